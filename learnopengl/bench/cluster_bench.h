@@ -0,0 +1,61 @@
+#pragma once
+
+#include "../rendering/cluster_grid.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// CPU light binning cost of ClusterGrid for 100 to 10,000 lights, single threaded and on the
+// thread pool. Lights are scattered through the view frustum with radii between 1 and 5 units.
+// Needs no GL context, run with --bench-clusters.
+inline void benchmarkClusterBinning(float fovY = glm::radians(45.0f), float aspect = 16.0f / 9.0f,
+                                    float nearPlane = 0.1f, float farPlane = 100.0f, int iterations = 50) {
+    const size_t lightCounts[] = { 100, 500, 1000, 2500, 5000, 10000 };
+
+    ClusterGrid grid;
+    grid.setProjection(fovY, aspect, nearPlane, farPlane);
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    std::cout << "Cluster binning: " << grid.dimX() << "x" << grid.dimY() << "x" << grid.dimZ() << " clusters, "
+              << threadPool().size() << " worker threads, " << iterations << " iterations" << std::endl;
+    std::cout << std::setw(8) << "lights" << std::setw(14) << "serial ms" << std::setw(14) << "parallel ms"
+              << std::setw(14) << "indices" << std::setw(14) << "per cluster" << std::endl;
+    std::cout << std::fixed;
+
+    for (size_t count : lightCounts) {
+        std::vector<PointLight> lights(count);
+        for (PointLight& light : lights) {
+            float depth = nearPlane + unit(rng) * (farPlane - nearPlane);
+            float halfHeight = std::tan(fovY * 0.5f) * depth;
+            light.position = glm::vec3((unit(rng) * 2.0f - 1.0f) * halfHeight * aspect,
+                                       (unit(rng) * 2.0f - 1.0f) * halfHeight, -depth);
+            light.radius = 1.0f + unit(rng) * 4.0f;
+            light.color = glm::vec3(1.0f);
+        }
+
+        double timings[2];
+        ThreadPool* pools[2] = { nullptr, &threadPool() };
+        for (int mode = 0; mode < 2; ++mode) {
+            grid.assign(view, lights, pools[mode]);     // warm up, sizes the per-cluster lists
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int i = 0; i < iterations; ++i) {
+                grid.assign(view, lights, pools[mode]);
+            }
+            timings[mode] = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / iterations;
+        }
+
+        std::cout << std::setw(8) << count << std::setprecision(3) << std::setw(14) << timings[0] << std::setw(14) << timings[1]
+                  << std::setw(14) << grid.indices().size() << std::setprecision(2)
+                  << std::setw(14) << static_cast<double>(grid.indices().size()) / grid.clusterCount() << std::endl;
+    }
+}
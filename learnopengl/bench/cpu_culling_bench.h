@@ -0,0 +1,123 @@
+#pragma once
+
+#include "asteroid_field.h"
+#include "../culling/frustum.h"
+#include "../culling/instance_grid.h"
+#include "../threading/thread_pool.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+// Frustum culling of the asteroid ring on the CPU without a GL context: the per instance test the
+// recorded draw path uses (transform every matrix, test its sphere) against InstanceGrid, each on
+// one thread and on the thread pool, at 100k, 1M and 5M rocks. One camera sees the ring from
+// outside, the other flies inside it and sees a small part. The grid's visible count has to match
+// the per instance test up to rounding at the frustum border. radius: bounding radius of
+// resources/models/rock/rock.obj.
+inline void benchmarkCpuCulling(int frames = 20, float radius = 2.14f, float aspect = 4.0f / 3.0f) {
+    typedef std::chrono::steady_clock Clock;
+    const unsigned int counts[] = { 100000, 1000000, 5000000 };
+    struct View {
+        const char* name;
+        glm::vec3 eye;
+        glm::vec3 target;
+    };
+    const View views[] = {
+        { "outside", glm::vec3(0.0f, 15.0f, 200.0f), glm::vec3(0.0f) },
+        { "inside", glm::vec3(150.0f, 2.0f, 0.0f), glm::vec3(130.0f, 0.0f, -100.0f) }
+    };
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), aspect, 0.1f, 1000.0f);
+    glm::mat4 orbit = glm::rotate(glm::mat4(1.0f), 0.3f, glm::vec3(0.0f, 1.0f, 0.0f));
+    ThreadPool& pool = threadPool();
+
+    std::cout << "CPU culling: " << frames << " frames, " << pool.size() + 1 << " threads, " << InstanceGrid::LANES << " SIMD lanes" << std::endl;
+    std::cout << std::setw(10) << "instances" << std::setw(9) << "view" << std::setw(10) << "visible"
+              << std::setw(14) << "per rock ms" << std::setw(14) << "per rock mt" << std::setw(12) << "grid ms"
+              << std::setw(12) << "grid mt" << std::setw(12) << "build ms" << std::endl;
+    std::cout << std::fixed << std::setprecision(3);
+
+    std::vector<glm::mat4> models;
+    std::vector<float> scales;
+    InstanceGrid grid;
+    std::vector<uint32_t> output;
+    for (unsigned int count : counts) {
+        srand(1234);
+        generateAsteroidField(count, models, scales);
+        Clock::time_point buildStart = Clock::now();
+        grid.build(models.data(), count, radius, 16.0f);
+        double build = std::chrono::duration<double, std::milli>(Clock::now() - buildStart).count();
+        output.resize(grid.outputSize());
+
+        for (const View& view : views) {
+            Frustum frustum(projection * glm::lookAt(view.eye, view.target, glm::vec3(0.0f, 1.0f, 0.0f)));
+            // the recorded draw path's test, the scale taken from the matrix like the grid does
+            auto perRock = [&](size_t begin, size_t end) {
+                unsigned int visible = 0;
+                for (size_t i = begin; i < end; ++i) {
+                    glm::mat4 model = orbit * models[i];
+                    float scale = std::max(glm::length(glm::vec3(model[0])), std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+                    visible += frustum.intersectsSphere(glm::vec3(model[3]), radius * scale) ? 1 : 0;
+                }
+                return visible;
+            };
+            auto gridVisible = [&]() {
+                unsigned int visible = 0;
+                for (const InstanceGrid::Chunk& chunk : grid.chunks()) {
+                    visible += chunk.count;
+                }
+                return visible;
+            };
+
+            double times[4] = {};
+            unsigned int visible[4] = {};
+            for (int frame = 0; frame < frames; ++frame) {
+                Clock::time_point start = Clock::now();
+                visible[0] = perRock(0, count);
+                Clock::time_point singleDone = Clock::now();
+                std::vector<unsigned int> chunkVisible(pool.size() + 1, 0);
+                size_t chunk = (count + chunkVisible.size() - 1) / chunkVisible.size();
+                pool.parallelFor(chunkVisible.size(), 1, [&](size_t begin, size_t end) {
+                    for (size_t c = begin; c < end; ++c) {
+                        chunkVisible[c] = perRock(std::min<size_t>(c * chunk, count), std::min<size_t>((c + 1) * chunk, count));
+                    }
+                });
+                visible[1] = 0;
+                for (unsigned int v : chunkVisible) {
+                    visible[1] += v;
+                }
+                Clock::time_point pooledDone = Clock::now();
+                grid.cull(frustum, orbit, output.data(), nullptr);
+                visible[2] = gridVisible();
+                Clock::time_point gridDone = Clock::now();
+                grid.cull(frustum, orbit, output.data(), &pool);
+                visible[3] = gridVisible();
+                Clock::time_point gridPooledDone = Clock::now();
+
+                times[0] += std::chrono::duration<double, std::milli>(singleDone - start).count();
+                times[1] += std::chrono::duration<double, std::milli>(pooledDone - singleDone).count();
+                times[2] += std::chrono::duration<double, std::milli>(gridDone - pooledDone).count();
+                times[3] += std::chrono::duration<double, std::milli>(gridPooledDone - gridDone).count();
+            }
+
+            // the grid moves the planes instead of the spheres, a sphere touching a plane may round
+            // to the other side
+            for (int variant = 1; variant < 4; ++variant) {
+                unsigned int difference = visible[variant] > visible[0] ? visible[variant] - visible[0] : visible[0] - visible[variant];
+                if (difference > count / 100000) {
+                    std::cout << "ERROR::BENCH::CULLING_MISMATCH variant " << variant << ": " << visible[variant] << " per rock " << visible[0] << std::endl;
+                }
+            }
+            std::cout << std::setw(10) << count << std::setw(9) << view.name << std::setw(10) << visible[0]
+                      << std::setw(14) << times[0] / frames << std::setw(14) << times[1] / frames << std::setw(12) << times[2] / frames
+                      << std::setw(12) << times[3] / frames << std::setw(12) << build << std::endl;
+        }
+    }
+}
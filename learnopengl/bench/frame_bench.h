@@ -0,0 +1,294 @@
+#pragma once
+
+#include "gl_call_counters.h"
+#include "../rendering/gl_state.h"
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Deterministic benchmark of the render loop, enabled with --bench:
+//   --bench-frames N        measured frames (default 500)
+//   --bench-warmup N        frames rendered before measuring (default 50)
+//   --bench-context API     native (default), egl or osmesa, the GLFW context creation API
+//   --bench-out FILE        JSON report (default bench_results.json)
+//   --bench-dump DIR        write every --bench-dump-every'th measured frame (default 60) as DIR/frame_NNNNN.ppm
+// The window stays hidden and frames go to an offscreen target, so with --bench-context osmesa (or
+// egl on a surfaceless Mesa driver) it runs on llvmpipe without a display. Time advances by a fixed step
+// per frame and the camera follows a scripted path, two runs render the same images.
+struct BenchOptions {
+    bool enabled = false;
+    unsigned int frames = 500;
+    unsigned int warmup = 50;
+    int contextApi = GLFW_NATIVE_CONTEXT_API;   // WGL/GLX/NSGL, egl and osmesa are often missing (opengl32 on Windows)
+    std::string output = "bench_results.json";
+    std::string dumpDirectory;
+    unsigned int dumpEvery = 60;
+};
+
+inline BenchOptions parseBenchOptions(int argc, char** argv) {
+    BenchOptions options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--bench") {
+            options.enabled = true;
+        } else if (arg == "--bench-frames" && hasValue) {
+            options.frames = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--bench-warmup" && hasValue) {
+            options.warmup = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--bench-out" && hasValue) {
+            options.output = argv[++i];
+        } else if (arg == "--bench-dump" && hasValue) {
+            options.dumpDirectory = argv[++i];
+        } else if (arg == "--bench-dump-every" && hasValue) {
+            options.dumpEvery = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--bench-context" && hasValue) {
+            std::string api = argv[++i];
+            if (api == "osmesa") {
+                options.contextApi = GLFW_OSMESA_CONTEXT_API;
+            } else if (api == "native") {
+                options.contextApi = GLFW_NATIVE_CONTEXT_API;
+            } else if (api == "egl") {
+                options.contextApi = GLFW_EGL_CONTEXT_API;
+            } else {
+                std::cout << "ERROR::BENCH::UNKNOWN_CONTEXT_API " << api << ", using native" << std::endl;
+            }
+        }
+    }
+    return options;
+}
+
+// camera pose of a benchmark frame: one orbit in front of the scene per run, bobbing up and down
+struct BenchCameraPose {
+    glm::vec3 position;
+    float yaw;      // degrees, Camera convention
+    float pitch;
+};
+
+inline BenchCameraPose benchCameraPose(unsigned int frame, unsigned int frameCount, glm::vec3 target, float radius) {
+    const float PI = 3.14159265359f;
+    float angle = 2.0f * PI * static_cast<float>(frame) / static_cast<float>(std::max(frameCount, 1u));
+    // sweep -60..60 degrees around the +z axis through the target
+    float sweep = std::sin(angle) * PI / 3.0f;
+    glm::vec3 position = target + glm::vec3(std::sin(sweep) * radius, std::sin(2.0f * angle) * radius * 0.2f, std::cos(sweep) * radius);
+    glm::vec3 direction = glm::normalize(target - position);
+
+    BenchCameraPose pose;
+    pose.position = position;
+    pose.yaw = glm::degrees(std::atan2(direction.z, direction.x));
+    pose.pitch = glm::degrees(std::asin(direction.y));
+    return pose;
+}
+
+// nearest rank percentile of sorted samples, p in [0, 100]
+inline double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * sorted.size()));
+    return sorted[std::min(std::max(rank, size_t(1)), sorted.size()) - 1];
+}
+
+// Offscreen target, startup phases and per frame samples of a --bench run. Frame times are wall
+// clock from the start of the frame until glFinish() returns, so GPU work is included and frames
+// can't queue up behind each other. Draw calls and state changes are the ones reaching the driver,
+// the state cache numbers expect glState().resetStats() at the start of every frame.
+class FrameBenchmark {
+    private:
+        struct FrameSample {
+            double milliseconds;
+            unsigned long long drawCalls;
+            unsigned long long stateChanges;
+            GLStateStats stateCache;
+        };
+
+        BenchOptions m_options;
+        unsigned int m_width;
+        unsigned int m_height;
+        unsigned int m_fbo = 0;
+        unsigned int m_color = 0;
+        unsigned int m_depth = 0;
+
+        std::chrono::steady_clock::time_point m_phaseStart = std::chrono::steady_clock::now();
+        std::vector<std::pair<std::string, double>> m_startup;
+
+        unsigned int m_frame = 0;
+        std::chrono::steady_clock::time_point m_frameStart;
+        GLCallCounts m_frameCounts;
+        std::vector<FrameSample> m_samples;
+        unsigned int m_dumped = 0;
+
+        static std::string escape(const std::string& text) {
+            std::string escaped;
+            for (char c : text) {
+                if (c == '"' || c == '\\') {
+                    escaped += '\\';
+                }
+                escaped += c;
+            }
+            return escaped;
+        }
+
+        void dump(unsigned int frame) {
+            std::vector<unsigned char> pixels(static_cast<size_t>(m_width) * m_height * 3);
+            glPixelStorei(GL_PACK_ALIGNMENT, 1);
+            glNamedFramebufferReadBuffer(m_fbo, GL_COLOR_ATTACHMENT0);
+            glState().bindFramebuffer(GL_READ_FRAMEBUFFER, m_fbo);
+            glReadPixels(0, 0, m_width, m_height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+
+            char name[32];
+            std::snprintf(name, sizeof(name), "/frame_%05u.ppm", frame);
+            std::ofstream file(m_options.dumpDirectory + name, std::ios::binary);
+            if (!file) {
+                std::cout << "ERROR::BENCH::DUMP_NOT_WRITTEN " << m_options.dumpDirectory + name << std::endl;
+                return;
+            }
+            // binary PPM rows run top to bottom, GL's bottom to top
+            file << "P6\n" << m_width << " " << m_height << "\n255\n";
+            for (unsigned int y = m_height; y-- > 0;) {
+                file.write(reinterpret_cast<const char*>(&pixels[static_cast<size_t>(y) * m_width * 3]), m_width * 3);
+            }
+            ++m_dumped;
+        }
+
+    public:
+        FrameBenchmark(const BenchOptions& options, unsigned int width, unsigned int height)
+            : m_options{ options }, m_width{ width }, m_height{ height } {}
+
+        // the context may be gone by now, release() has to run before glfwTerminate()
+        ~FrameBenchmark() {
+            release();
+        }
+
+        FrameBenchmark(const FrameBenchmark&) = delete;
+        FrameBenchmark& operator=(const FrameBenchmark&) = delete;
+
+        // closes the current startup phase, timed from the previous call (or construction)
+        void endPhase(const std::string& name) {
+            auto now = std::chrono::steady_clock::now();
+            m_startup.push_back(std::make_pair(name, std::chrono::duration<double, std::milli>(now - m_phaseStart).count()));
+            m_phaseStart = now;
+        }
+
+        // needs the context, creates the single sampled offscreen target the frames render into
+        void createTarget() {
+            glCreateTextures(GL_TEXTURE_2D, 1, &m_color);
+            glTextureStorage2D(m_color, 1, GL_RGBA8, m_width, m_height);
+            glCreateRenderbuffers(1, &m_depth);
+            glNamedRenderbufferStorage(m_depth, GL_DEPTH_COMPONENT24, m_width, m_height);
+            glCreateFramebuffers(1, &m_fbo);
+            glNamedFramebufferTexture(m_fbo, GL_COLOR_ATTACHMENT0, m_color, 0);
+            glNamedFramebufferRenderbuffer(m_fbo, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_depth);
+            if (glCheckNamedFramebufferStatus(m_fbo, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+                std::cout << "ERROR::BENCH::FRAMEBUFFER_INCOMPLETE" << std::endl;
+            }
+            installGLCallCounters();
+        }
+
+        // deletes the offscreen target, needs the context. does nothing without a target (no --bench)
+        void release() {
+            if (m_fbo == 0) {
+                return;
+            }
+            glState().forgetFramebuffer(m_fbo);
+            glDeleteFramebuffers(1, &m_fbo);
+            glDeleteTextures(1, &m_color);
+            glDeleteRenderbuffers(1, &m_depth);
+            m_fbo = m_color = m_depth = 0;
+        }
+
+        bool done() const { return m_frame >= m_options.warmup + m_options.frames; }
+        unsigned int frame() const { return m_frame; }
+        unsigned int frameCount() const { return m_options.warmup + m_options.frames; }
+
+        // fixed simulation time step
+        float deltaTime() const { return 1.0f / 60.0f; }
+        float time() const { return m_frame * deltaTime(); }
+
+        void beginFrame() {
+            glState().bindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+            glState().viewport(0, 0, m_width, m_height);
+            m_frameCounts = glCallCounts();
+            m_frameStart = std::chrono::steady_clock::now();
+        }
+
+        void endFrame() {
+            glFinish();
+            double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_frameStart).count();
+            const GLCallCounts& counts = glCallCounts();
+            if (m_frame >= m_options.warmup) {
+                unsigned int measured = m_frame - m_options.warmup;
+                m_samples.push_back({ milliseconds, counts.drawCalls() - m_frameCounts.drawCalls(), counts.stateChanges() - m_frameCounts.stateChanges(), glState().stats() });
+                if (!m_options.dumpDirectory.empty() && measured % m_options.dumpEvery == 0) {
+                    dump(measured);
+                }
+            }
+            ++m_frame;
+        }
+
+        // writes the JSON report and prints it, returns false if the file couldn't be written
+        bool report() const {
+            std::vector<double> times;
+            double total = 0.0, drawCalls = 0.0, stateChanges = 0.0, cacheIssued = 0.0, cacheFiltered = 0.0;
+            for (const FrameSample& sample : m_samples) {
+                times.push_back(sample.milliseconds);
+                total += sample.milliseconds;
+                drawCalls += static_cast<double>(sample.drawCalls);
+                stateChanges += static_cast<double>(sample.stateChanges);
+                cacheIssued += sample.stateCache.issued;
+                cacheFiltered += sample.stateCache.filtered;
+            }
+            std::sort(times.begin(), times.end());
+            double count = std::max<double>(static_cast<double>(m_samples.size()), 1.0);
+
+            const char* renderer = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+            const char* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+
+            std::ostringstream json;
+            json.setf(std::ios::fixed);
+            json.precision(3);
+            json << "{\n";
+            json << "  \"renderer\": \"" << escape(renderer ? renderer : "") << "\",\n";
+            json << "  \"version\": \"" << escape(version ? version : "") << "\",\n";
+            json << "  \"resolution\": [" << m_width << ", " << m_height << "],\n";
+            json << "  \"warmup_frames\": " << m_options.warmup << ",\n";
+            json << "  \"frames\": " << m_samples.size() << ",\n";
+            json << "  \"startup_ms\": {";
+            double startupTotal = 0.0;
+            for (size_t i = 0; i < m_startup.size(); ++i) {
+                json << (i ? ", " : "") << "\"" << escape(m_startup[i].first) << "\": " << m_startup[i].second;
+                startupTotal += m_startup[i].second;
+            }
+            json << (m_startup.empty() ? "" : ", ") << "\"total\": " << startupTotal << "},\n";
+            json << "  \"frame_ms\": {\"mean\": " << total / count
+                 << ", \"p50\": " << percentile(times, 50.0) << ", \"p95\": " << percentile(times, 95.0) << ", \"p99\": " << percentile(times, 99.0)
+                 << ", \"min\": " << (times.empty() ? 0.0 : times.front()) << ", \"max\": " << (times.empty() ? 0.0 : times.back()) << "},\n";
+            json << "  \"per_frame\": {\"draw_calls\": " << drawCalls / count << ", \"state_changes\": " << stateChanges / count
+                 << ", \"state_cache_issued\": " << cacheIssued / count << ", \"state_cache_filtered\": " << cacheFiltered / count << "},\n";
+            json << "  \"dumped_frames\": " << m_dumped << "\n";
+            json << "}\n";
+
+            std::cout << json.str();
+            std::ofstream file(m_options.output);
+            file << json.str();
+            if (!file) {
+                std::cout << "ERROR::BENCH::REPORT_NOT_WRITTEN " << m_options.output << std::endl;
+                return false;
+            }
+            std::cout << "Benchmark report written to " << m_options.output << std::endl;
+            return true;
+        }
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <glad/glad.h>
+
+// Counts the draw calls and state changes that actually reach the driver. install() swaps glad's
+// function pointers for counting trampolines that forward to the original entry point, so every
+// call site in the program is covered without touching it. Call it once after gladLoadGLLoader.
+enum GLCallKind {
+    GL_CALL_DRAW = 0,
+    GL_CALL_STATE,
+    GL_CALL_KIND_COUNT
+};
+
+struct GLCallCounts {
+    unsigned long long calls[GL_CALL_KIND_COUNT] = {};
+
+    unsigned long long drawCalls() const { return calls[GL_CALL_DRAW]; }
+    unsigned long long stateChanges() const { return calls[GL_CALL_STATE]; }
+};
+
+// running totals since install(), callers diff two snapshots to get per frame numbers
+inline GLCallCounts& glCallCounts() {
+    static GLCallCounts counts;
+    return counts;
+}
+
+template <typename Proc, Proc* Slot, GLCallKind Kind>
+struct GLCallHook;
+
+template <typename... Args, void (APIENTRYP* Slot)(Args...), GLCallKind Kind>
+struct GLCallHook<void (APIENTRYP)(Args...), Slot, Kind> {
+    typedef void (APIENTRYP Proc)(Args...);
+
+    static Proc& original() {
+        static Proc proc = nullptr;
+        return proc;
+    }
+
+    static void APIENTRY call(Args... args) {
+        ++glCallCounts().calls[Kind];
+        original()(args...);
+    }
+
+    static void install() {
+        if (*Slot != nullptr && *Slot != &call) {
+            original() = *Slot;
+            *Slot = &call;
+        }
+    }
+};
+
+#define GL_COUNT_CALLS(proc, kind) GLCallHook<decltype(glad_##proc), &glad_##proc, kind>::install()
+
+inline void installGLCallCounters() {
+    GL_COUNT_CALLS(glDrawArrays, GL_CALL_DRAW);
+    GL_COUNT_CALLS(glDrawElements, GL_CALL_DRAW);
+    GL_COUNT_CALLS(glDrawArraysInstanced, GL_CALL_DRAW);
+    GL_COUNT_CALLS(glDrawElementsInstanced, GL_CALL_DRAW);
+    GL_COUNT_CALLS(glDrawElementsBaseVertex, GL_CALL_DRAW);
+    GL_COUNT_CALLS(glDrawArraysIndirect, GL_CALL_DRAW);
+    GL_COUNT_CALLS(glDrawElementsIndirect, GL_CALL_DRAW);
+    GL_COUNT_CALLS(glMultiDrawArraysIndirect, GL_CALL_DRAW);
+    GL_COUNT_CALLS(glMultiDrawElementsIndirect, GL_CALL_DRAW);
+    GL_COUNT_CALLS(glDispatchCompute, GL_CALL_DRAW);
+
+    GL_COUNT_CALLS(glUseProgram, GL_CALL_STATE);
+    GL_COUNT_CALLS(glBindVertexArray, GL_CALL_STATE);
+    GL_COUNT_CALLS(glBindFramebuffer, GL_CALL_STATE);
+    GL_COUNT_CALLS(glBindBuffer, GL_CALL_STATE);
+    GL_COUNT_CALLS(glBindBufferBase, GL_CALL_STATE);
+    GL_COUNT_CALLS(glBindBufferRange, GL_CALL_STATE);
+    GL_COUNT_CALLS(glActiveTexture, GL_CALL_STATE);
+    GL_COUNT_CALLS(glBindTexture, GL_CALL_STATE);
+    GL_COUNT_CALLS(glBindTextureUnit, GL_CALL_STATE);
+    GL_COUNT_CALLS(glEnable, GL_CALL_STATE);
+    GL_COUNT_CALLS(glDisable, GL_CALL_STATE);
+    GL_COUNT_CALLS(glBlendFunc, GL_CALL_STATE);
+    GL_COUNT_CALLS(glDepthFunc, GL_CALL_STATE);
+    GL_COUNT_CALLS(glDepthMask, GL_CALL_STATE);
+    GL_COUNT_CALLS(glCullFace, GL_CALL_STATE);
+    GL_COUNT_CALLS(glViewport, GL_CALL_STATE);
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "asteroid_field.h"
+#include "../culling/gpu_culling.h"
+#include "../threading/thread_pool.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Cost of GpuInstanceCuller on the asteroid ring at 100k, 1M and 5M rocks, seen from outside the ring
+// so about half of it is visible. GPU times are wall clock between glFinish calls, which also works
+// on drivers without usable timer queries (llvmpipe). The CPU column is the same frustum test on the
+// thread pool, for comparison. Drawing a few million rocks on a software rasterizer takes minutes,
+// 'draw' false skips it. Renders into the bound framebuffer.
+inline void benchmarkGpuCulling(std::vector<Mesh>& meshes, Shader& cullShader, Shader& drawShader, float aspect, int frames = 20, bool draw = true) {
+    typedef std::chrono::steady_clock Clock;
+    const unsigned int counts[] = { 100000, 1000000, 5000000 };
+
+    glm::vec3 eye(0.0f, 15.0f, 200.0f);
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), aspect, 0.1f, 1000.0f);
+    glm::mat4 view = glm::lookAt(eye, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 transform(1.0f);
+    Frustum frustum(projection * view);
+
+    std::cout << "GPU culling: " << frames << " frames, LOD distances 40/120" << std::endl;
+    std::cout << std::setw(10) << "instances" << std::setw(10) << "visible" << std::setw(24) << "lod 0/1/2"
+              << std::setw(12) << "cull ms" << std::setw(12) << "draw ms" << std::setw(12) << "cpu ms" << std::endl;
+    std::cout << std::fixed << std::setprecision(3);
+
+    std::vector<glm::mat4> models;
+    std::vector<float> scales;
+    for (unsigned int count : counts) {
+        srand(1234);
+        generateAsteroidField(count, models, scales);
+        GpuInstanceCuller culler(cullShader, models.data(), count);
+        for (Mesh& mesh : meshes) {
+            culler.addMesh(mesh);
+        }
+
+        double cull = 0.0, drawn = 0.0;
+        // the visible counts are read back a few frames late
+        int runs = frames + GpuInstanceCuller::READBACK_FRAMES;
+        for (int frame = 0; frame < runs; ++frame) {
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            glFinish();
+            Clock::time_point start = Clock::now();
+            culler.cull(projection * view, eye, transform);
+            glFinish();
+            Clock::time_point culled = Clock::now();
+            // the counts don't change between frames, the extra readback frames only cull
+            if (draw && frame < frames) {
+                drawShader.use();
+                drawShader.setMat4("projection", projection);
+                drawShader.setMat4("view", view);
+                drawShader.setMat4("transform", transform);
+                culler.draw();
+                glFinish();
+            }
+            if (frame < frames) {
+                cull += std::chrono::duration<double, std::milli>(culled - start).count();
+                drawn += std::chrono::duration<double, std::milli>(Clock::now() - culled).count();
+            }
+        }
+
+        // CPU reference, chunks on the thread pool
+        float radius = culler.boundingRadius();
+        Clock::time_point cpuStart = Clock::now();
+        const unsigned int chunk = 16384;
+        std::vector<std::future<unsigned int>> chunks;
+        for (unsigned int begin = 0; begin < count; begin += chunk) {
+            unsigned int end = std::min(begin + chunk, count);
+            chunks.push_back(threadPool().submit([&, begin, end]() {
+                unsigned int visible = 0;
+                for (unsigned int i = begin; i < end; ++i) {
+                    // same scale estimate as the shader, so both agree at the frustum border
+                    glm::mat4 model = transform * models[i];
+                    float scale = std::max(glm::length(glm::vec3(model[0])), std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+                    visible += frustum.intersectsSphere(glm::vec3(model[3]), radius * scale) ? 1 : 0;
+                }
+                return visible;
+            }));
+        }
+        unsigned int cpuVisible = 0;
+        for (std::future<unsigned int>& result : chunks) {
+            cpuVisible += result.get();
+        }
+        double cpu = std::chrono::duration<double, std::milli>(Clock::now() - cpuStart).count();
+
+        const GpuCullingStats& stats = culler.stats();
+        if (stats.total != cpuVisible) {
+            std::cout << "ERROR::BENCH::CULLING_MISMATCH gpu " << stats.total << " cpu " << cpuVisible << std::endl;
+        }
+        std::string lods = std::to_string(stats.visible[0]) + "/" + std::to_string(stats.visible[1]) + "/" + std::to_string(stats.visible[2]);
+        std::cout << std::setw(10) << count << std::setw(10) << stats.total << std::setw(24) << lods
+                  << std::setw(12) << cull / frames << std::setw(12) << drawn / frames << std::setw(12) << cpu << std::endl;
+    }
+}
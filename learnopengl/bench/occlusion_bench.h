@@ -0,0 +1,182 @@
+#pragma once
+
+#include "asteroid_field.h"
+#include "../culling/frustum.h"
+#include "../culling/instance_grid.h"
+#include "../culling/occlusion_buffer.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+// closed, counter-clockwise UV sphere whose vertices lie on 'radius': the faces are inside the
+// sphere, so it never occludes more than the sphere itself
+inline void buildSphereOccluder(float radius, unsigned int rings, unsigned int segments, std::vector<glm::vec3>& positions, std::vector<unsigned int>& indices) {
+    const float PI = 3.14159265359f;
+    positions.clear();
+    indices.clear();
+    for (unsigned int ring = 0; ring <= rings; ++ring) {
+        float theta = ring * PI / rings;
+        for (unsigned int segment = 0; segment <= segments; ++segment) {
+            float phi = segment * 2.0f * PI / segments;
+            positions.push_back(radius * glm::vec3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi)));
+        }
+    }
+    for (unsigned int ring = 0; ring < rings; ++ring) {
+        for (unsigned int segment = 0; segment < segments; ++segment) {
+            unsigned int current = ring * (segments + 1) + segment;
+            unsigned int below = current + segments + 1;
+            unsigned int triangles[] = { current, current + 1, below, below, current + 1, below + 1 };
+            indices.insert(indices.end(), triangles, triangles + 6);
+        }
+    }
+}
+
+// deterministic edge cases of OcclusionBuffer, false (and an error per failed case) if one of them
+// fails: an empty buffer hides nothing, a wall covering the screen hides a box behind it but not one
+// in front of it, and a box reaching behind the near plane stays visible even behind the wall
+inline bool checkOcclusionBuffer() {
+    OcclusionBuffer occlusion(256, 128);
+    glm::mat4 viewProjection = glm::perspective(glm::radians(45.0f), 2.0f, 0.1f, 100.0f)
+                               * glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    // counter-clockwise quad facing the camera, 5 units away and well past the screen's edges
+    const glm::vec3 wall[] = { glm::vec3(-8.0f, -8.0f, -5.0f), glm::vec3(8.0f, -8.0f, -5.0f), glm::vec3(8.0f, 8.0f, -5.0f), glm::vec3(-8.0f, 8.0f, -5.0f) };
+    const unsigned int wallIndices[] = { 0, 1, 2, 0, 2, 3 };
+    struct Case {
+        const char* name;
+        bool withWall;
+        glm::vec3 minimum;
+        glm::vec3 maximum;
+        bool visible;
+    };
+    const Case cases[] = {
+        { "empty buffer", false, glm::vec3(-1.0f, -1.0f, -21.0f), glm::vec3(1.0f, 1.0f, -19.0f), true },
+        { "empty buffer, covering box", false, glm::vec3(-50.0f, -50.0f, -90.0f), glm::vec3(50.0f, 50.0f, -1.0f), true },
+        { "behind the wall", true, glm::vec3(-1.0f, -1.0f, -21.0f), glm::vec3(1.0f, 1.0f, -19.0f), false },
+        { "in front of the wall", true, glm::vec3(-0.5f, -0.5f, -3.0f), glm::vec3(0.5f, 0.5f, -2.0f), true },
+        { "crossing the near plane", true, glm::vec3(-0.5f, -0.5f, -20.0f), glm::vec3(0.5f, 0.5f, 1.0f), true }
+    };
+
+    bool passed = true;
+    for (const Case& test : cases) {
+        occlusion.clear(viewProjection);
+        if (test.withWall) {
+            occlusion.renderOccluder(glm::mat4(1.0f), wall, 4, sizeof(glm::vec3), wallIndices, 6);
+        }
+        if (occlusion.isVisible(test.minimum, test.maximum) != test.visible) {
+            std::cout << "ERROR::BENCH::OCCLUSION_CHECK_FAILED " << test.name << ": expected " << (test.visible ? "visible" : "hidden") << std::endl;
+            passed = false;
+        }
+    }
+    return passed;
+}
+
+// Occlusion culling of the asteroid ring behind the planet of done_chapters/main_instancing.cpp,
+// 1M rocks in an InstanceGrid, without a GL context. The planet is rasterized into a 256x128
+// OcclusionBuffer, then the grid culls with and without it. Rocks only the occlusion test removed
+// are checked against the exact sphere: every one of them has to be fully hidden behind it
+// ("wrongly hidden" would be visible artifacts, sub-pixel silhouette misses aside). The edge cases of
+// checkOcclusionBuffer() run first, the numbers below mean little if one of them fails.
+inline void benchmarkOcclusionCulling(int frames = 20, float radius = 2.14f, float aspect = 4.0f / 3.0f) {
+    checkOcclusionBuffer();
+
+    typedef std::chrono::steady_clock Clock;
+    const unsigned int count = 1000000;
+    const glm::vec3 planetCenter(0.0f, -3.0f, 0.0f);
+    const float planetRadius = 3.389f * 4.0f;
+    struct View {
+        const char* name;
+        glm::vec3 eye;
+        glm::vec3 target;
+    };
+    const View views[] = {
+        { "outside", glm::vec3(0.0f, 15.0f, 200.0f), glm::vec3(0.0f) },
+        { "close", glm::vec3(0.0f, 0.0f, -35.0f), glm::vec3(0.0f, -3.0f, 150.0f) },
+        { "grazing", glm::vec3(-20.0f, 2.0f, -30.0f), glm::vec3(60.0f, -3.0f, 150.0f) }
+    };
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), aspect, 0.1f, 1000.0f);
+    glm::mat4 orbit = glm::rotate(glm::mat4(1.0f), 0.3f, glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 planetModel = glm::translate(glm::mat4(1.0f), planetCenter);
+
+    std::vector<glm::vec3> occluder;
+    std::vector<unsigned int> occluderIndices;
+    buildSphereOccluder(planetRadius, 16, 32, occluder, occluderIndices);
+
+    std::vector<glm::mat4> models;
+    std::vector<float> scales;
+    srand(1234);
+    generateAsteroidField(count, models, scales);
+    InstanceGrid grid;
+    grid.build(models.data(), count, radius, 16.0f);
+    std::vector<uint32_t> unoccluded(grid.outputSize()), occluded(grid.outputSize());
+    std::vector<unsigned char> survivor(count);
+    OcclusionBuffer occlusion(256, 128);
+
+    std::cout << "occlusion culling: " << count << " rocks, " << occluderIndices.size() / 3 << " occluder triangles, "
+              << occlusion.width() << "x" << occlusion.height() << " buffer, " << frames << " frames" << std::endl;
+    std::cout << std::setw(9) << "view" << std::setw(10) << "frustum" << std::setw(10) << "occluded" << std::setw(8) << "cells"
+              << std::setw(14) << "wrongly hid" << std::setw(12) << "raster ms" << std::setw(12) << "cull ms" << std::setw(12) << "+occl ms" << std::endl;
+    std::cout << std::fixed << std::setprecision(3);
+
+    for (const View& view : views) {
+        glm::mat4 viewProjection = projection * glm::lookAt(view.eye, view.target, glm::vec3(0.0f, 1.0f, 0.0f));
+        Frustum frustum(viewProjection);
+        double raster = 0.0, plain = 0.0, withOcclusion = 0.0;
+        std::vector<InstanceGrid::Chunk> plainChunks, occludedChunks;
+        for (int frame = 0; frame < frames; ++frame) {
+            Clock::time_point start = Clock::now();
+            occlusion.clear(viewProjection);
+            occlusion.renderOccluder(planetModel, occluder.data(), occluder.size(), sizeof(glm::vec3), occluderIndices.data(), occluderIndices.size());
+            Clock::time_point rasterized = Clock::now();
+            plainChunks = grid.cull(frustum, orbit, unoccluded.data(), nullptr);
+            Clock::time_point culled = Clock::now();
+            occludedChunks = grid.cull(frustum, orbit, occluded.data(), nullptr, &occlusion);
+            Clock::time_point occlusionCulled = Clock::now();
+            raster += std::chrono::duration<double, std::milli>(rasterized - start).count();
+            plain += std::chrono::duration<double, std::milli>(culled - rasterized).count();
+            withOcclusion += std::chrono::duration<double, std::milli>(occlusionCulled - culled).count();
+        }
+
+        // rocks removed by the occlusion test have to be hidden behind the true sphere: inside its
+        // silhouette cone and farther than its center
+        std::fill(survivor.begin(), survivor.end(), 0);
+        unsigned int frustumVisible = 0, occlusionVisible = 0, occludedCells = 0, wronglyHidden = 0;
+        for (const InstanceGrid::Chunk& chunk : occludedChunks) {
+            for (uint32_t i = 0; i < chunk.count; ++i) {
+                survivor[occluded[chunk.offset + i]] = 1;
+            }
+            occlusionVisible += chunk.count;
+            occludedCells += chunk.occludedCells;
+        }
+        glm::vec3 toPlanet = planetCenter - view.eye;
+        float planetDistance = glm::length(toPlanet);
+        float coneAngle = std::asin(std::min(1.0f, planetRadius / planetDistance));
+        for (const InstanceGrid::Chunk& chunk : plainChunks) {
+            frustumVisible += chunk.count;
+            for (uint32_t i = 0; i < chunk.count; ++i) {
+                uint32_t index = unoccluded[chunk.offset + i];
+                if (survivor[index]) {
+                    continue;
+                }
+                glm::mat4 model = orbit * models[index];
+                glm::vec3 toRock = glm::vec3(model[3]) - view.eye;
+                float rockDistance = glm::length(toRock);
+                float rockRadius = radius * std::max(glm::length(glm::vec3(model[0])), std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+                float angle = std::acos(glm::clamp(glm::dot(toRock, toPlanet) / (rockDistance * planetDistance), -1.0f, 1.0f));
+                bool hidden = rockDistance - rockRadius > planetDistance && angle + std::asin(std::min(1.0f, rockRadius / rockDistance)) <= coneAngle;
+                wronglyHidden += hidden ? 0 : 1;
+            }
+        }
+        std::cout << std::setw(9) << view.name << std::setw(10) << frustumVisible << std::setw(10) << frustumVisible - occlusionVisible
+                  << std::setw(8) << occludedCells << std::setw(14) << wronglyHidden << std::setw(12) << raster / frames
+                  << std::setw(12) << plain / frames << std::setw(12) << withOcclusion / frames << std::endl;
+    }
+}
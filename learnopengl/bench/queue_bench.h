@@ -0,0 +1,68 @@
+#pragma once
+
+#include "../rendering/render_queue.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// CPU cost of recording and sorting RenderQueue commands for 1,000 to 100,000 draws per frame,
+// radix sort against std::sort on the same keys. Draws are spread over 8 programs, 256 materials
+// and 512 meshes with a tenth of them translucent. Needs no GL context, run with --bench-queue.
+inline void benchmarkRenderQueue(int iterations = 50) {
+    const size_t drawCounts[] = { 1000, 5000, 10000, 50000, 100000 };
+
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<uint32_t> programs(0, 7), materials(0, 255), meshes(0, 511);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    std::cout << "Render queue: " << iterations << " iterations" << std::endl;
+    std::cout << std::setw(8) << "draws" << std::setw(14) << "record ms" << std::setw(14) << "radix ms"
+              << std::setw(14) << "std::sort ms" << std::setw(14) << "ns per draw" << std::endl;
+    std::cout << std::fixed;
+
+    for (size_t count : drawCounts) {
+        struct Draw {
+            uint32_t program, material, mesh;
+            float distance;
+            RenderBucket bucket;
+        };
+        std::vector<Draw> draws(count);
+        for (Draw& draw : draws) {
+            draw = { programs(rng), materials(rng), meshes(rng), 1.0f + unit(rng) * 99.0f,
+                     unit(rng) < 0.1f ? RENDER_BUCKET_TRANSLUCENT : RENDER_BUCKET_OPAQUE };
+        }
+
+        RenderQueue queue(count);
+        double record = 0.0, radix = 0.0, reference = 0.0;
+        std::vector<std::pair<uint64_t, uint32_t>> keys;
+        for (int i = 0; i < iterations; ++i) {
+            queue.clear();
+            auto start = std::chrono::high_resolution_clock::now();
+            for (const Draw& draw : draws) {
+                queue.submit(0, draw.bucket, draw.program, draw.material, draw.mesh, draw.distance);
+            }
+            auto recorded = std::chrono::high_resolution_clock::now();
+            keys = queue.sorted();
+            auto copied = std::chrono::high_resolution_clock::now();
+            queue.sort();
+            auto sorted = std::chrono::high_resolution_clock::now();
+            std::sort(keys.begin(), keys.end());
+            auto referenced = std::chrono::high_resolution_clock::now();
+
+            record += std::chrono::duration<double, std::milli>(recorded - start).count();
+            radix += std::chrono::duration<double, std::milli>(sorted - copied).count();
+            reference += std::chrono::duration<double, std::milli>(referenced - sorted).count();
+        }
+        if (keys != queue.sorted()) {
+            std::cout << "ERROR::BENCH::RADIX_SORT_MISMATCH at " << count << " draws" << std::endl;
+        }
+
+        std::cout << std::setw(8) << count << std::setprecision(3) << std::setw(14) << record / iterations
+                  << std::setw(14) << radix / iterations << std::setw(14) << reference / iterations << std::setprecision(1)
+                  << std::setw(14) << (record + radix) / iterations * 1e6 / count << std::endl;
+    }
+}
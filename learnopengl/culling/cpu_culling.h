@@ -0,0 +1,151 @@
+#pragma once
+
+#include "gpu_culling.h"
+#include "instance_grid.h"
+#include "../model_loading/mesh.h"
+#include "../rendering/dynamic_buffer.h"
+#include "../rendering/gl_state.h"
+#include "../threading/thread_pool.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct CpuCullingStats {
+    unsigned int visible = 0;
+    unsigned int chunks = 0;
+    unsigned int occludedCells = 0;
+    double milliseconds = 0.0;      // culling on the CPU, the draws not included
+};
+
+// CPU counterpart of GpuInstanceCuller for the same static instance set and the same vertex shader
+// (shaders/instance_indirect.vs): the model matrices are uploaded once, every frame an InstanceGrid
+// culls the bounding spheres on the thread pool and the workers write the visible instance indices
+// straight into this frame's segment of the persistently mapped DynamicBufferRing. Every grid chunk
+// becomes one indirect command per mesh whose base instance points at the chunk's survivors, so
+// the chunks are never compacted and draw() is one glMultiDrawElementsIndirect per mesh. Only the
+// full detail mesh is drawn. The dynamic buffer segment has to fit InstanceGrid::outputSize()
+// indices plus the commands.
+class CpuInstanceCuller {
+    public:
+        static const GLuint INSTANCES_BINDING = GpuInstanceCuller::INSTANCES_BINDING;
+        static const GLuint INSTANCE_ATTRIBUTE = GpuInstanceCuller::INSTANCE_ATTRIBUTE;
+
+    private:
+        struct CulledMesh {
+            GLuint vertexArray;
+            GLuint count;
+        };
+
+        DynamicBufferRing& m_ring;
+        InstanceGrid m_grid;
+        std::vector<glm::mat4> m_models;        // the grid is built on the first cull, once the radius is known
+        float m_boundingRadius = 0.0f;
+        float m_cellSize;
+        GLuint m_instances = 0;
+        std::vector<CulledMesh> m_meshes;
+        GLintptr m_commandOffset = -1;          // of this frame's commands in the ring, -1 nothing to draw
+        CpuCullingStats m_stats;
+
+    public:
+        // count instances of 'models', uploaded once. cellSize: spacing of the culling grid in world units
+        CpuInstanceCuller(const glm::mat4* models, size_t count, float cellSize = 16.0f, DynamicBufferRing& ring = dynamicBuffers())
+            : m_ring(ring), m_models(models, models + count), m_cellSize{ cellSize } {
+            glCreateBuffers(1, &m_instances);
+            glNamedBufferStorage(m_instances, std::max<size_t>(count, 1) * sizeof(glm::mat4), models, 0);
+        }
+
+        ~CpuInstanceCuller() {
+            for (const CulledMesh& mesh : m_meshes) {
+                glState().forgetVertexArray(mesh.vertexArray);
+                glDeleteVertexArrays(1, &mesh.vertexArray);
+            }
+            glDeleteBuffers(1, &m_instances);
+        }
+
+        CpuInstanceCuller(const CpuInstanceCuller&) = delete;
+        CpuInstanceCuller& operator=(const CpuInstanceCuller&) = delete;
+
+        // before the first cull(), draws with the mesh's own element buffer. The bounding sphere
+        // sits at the model origin and grows to fit every added mesh.
+        void addMesh(Mesh& mesh) {
+            if (m_grid.count() || m_models.empty()) {
+                return;
+            }
+            for (const Vertex& vertex : mesh.Vertices()) {
+                m_boundingRadius = std::max(m_boundingRadius, glm::length(vertex.position));
+            }
+            CulledMesh culled;
+            culled.vertexArray = createIndirectVertexArray(mesh, mesh.ElementBuffer(), m_ring.buffer(), INSTANCE_ATTRIBUTE);
+            culled.count = static_cast<GLuint>(mesh.Indices().size());
+            m_meshes.push_back(culled);
+        }
+
+        // transform: rigid transform applied to every model matrix before testing (and by the
+        // vertex shader before drawing). Between the ring's beginFrame() and the draw. occlusion:
+        // grid cells hidden in it are skipped, it has to be filled for viewProjection
+        void cull(const glm::mat4& viewProjection, const glm::mat4& transform, ThreadPool* pool = &threadPool(), const OcclusionBuffer* occlusion = nullptr) {
+            m_commandOffset = -1;
+            if (m_meshes.empty()) {
+                return;
+            }
+            if (!m_grid.count()) {
+                m_grid.build(m_models.data(), m_models.size(), m_boundingRadius, m_cellSize);
+                m_models.clear();
+                m_models.shrink_to_fit();
+            }
+
+            DynamicAllocation visible = m_ring.allocate(m_grid.outputSize() * sizeof(GLuint), sizeof(GLuint));
+            DynamicAllocation commands = m_ring.allocate(m_grid.chunks().size() * m_meshes.size() * sizeof(DrawElementsIndirectCommand), sizeof(GLuint));
+            if (!visible.data || !commands.data) {
+                return;
+            }
+
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            const std::vector<InstanceGrid::Chunk>& chunks = m_grid.cull(Frustum(viewProjection), transform, static_cast<uint32_t*>(visible.data), pool, occlusion);
+            m_stats.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            // the instance attribute reads the ring from offset 0, base instances are ring indices
+            GLuint firstInstance = static_cast<GLuint>(visible.offset / sizeof(GLuint));
+            DrawElementsIndirectCommand* command = static_cast<DrawElementsIndirectCommand*>(commands.data);
+            m_stats.visible = 0;
+            m_stats.occludedCells = 0;
+            m_stats.chunks = static_cast<unsigned int>(chunks.size());
+            for (const CulledMesh& mesh : m_meshes) {
+                for (const InstanceGrid::Chunk& chunk : chunks) {
+                    DrawElementsIndirectCommand written = { mesh.count, chunk.count, 0, 0, firstInstance + chunk.offset };
+                    *command++ = written;
+                }
+            }
+            for (const InstanceGrid::Chunk& chunk : chunks) {
+                m_stats.visible += chunk.count;
+                m_stats.occludedCells += chunk.occludedCells;
+            }
+            m_commandOffset = commands.offset;
+        }
+
+        // with the caller's program in use, it reads the matrices from INSTANCES_BINDING
+        void draw() {
+            if (m_commandOffset < 0) {
+                return;
+            }
+            GLsizei chunks = static_cast<GLsizei>(m_grid.chunks().size());
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, INSTANCES_BINDING, m_instances);
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_ring.buffer());
+            for (size_t mesh = 0; mesh < m_meshes.size(); ++mesh) {
+                glState().bindVertexArray(m_meshes[mesh].vertexArray);
+                glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+                    reinterpret_cast<const void*>(m_commandOffset + mesh * chunks * sizeof(DrawElementsIndirectCommand)), chunks, 0);
+            }
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        }
+
+        float boundingRadius() const { return m_boundingRadius; }
+        const InstanceGrid& grid() const { return m_grid; }
+        const CpuCullingStats& stats() const { return m_stats; }
+};
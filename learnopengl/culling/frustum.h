@@ -0,0 +1,39 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// View frustum as six inward facing planes (xyz normal, w distance), extracted from a
+// view-projection matrix (Gribb/Hartmann). Normals are normalized, so plane distances are in world
+// units and bounding spheres can be tested directly.
+struct Frustum {
+    glm::vec4 planes[6];    // left, right, bottom, top, near, far
+
+    Frustum() = default;
+
+    explicit Frustum(const glm::mat4& viewProjection) {
+        // rows of the matrix, glm is column major
+        glm::vec4 rows[4];
+        for (int i = 0; i < 4; ++i) {
+            rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+        }
+        planes[0] = rows[3] + rows[0];
+        planes[1] = rows[3] - rows[0];
+        planes[2] = rows[3] + rows[1];
+        planes[3] = rows[3] - rows[1];
+        planes[4] = rows[3] + rows[2];
+        planes[5] = rows[3] - rows[2];
+        for (glm::vec4& plane : planes) {
+            plane /= glm::length(glm::vec3(plane));
+        }
+    }
+
+    // conservative: spheres near a frustum corner may pass although they're outside
+    bool intersectsSphere(const glm::vec3& center, float radius) const {
+        for (const glm::vec4& plane : planes) {
+            if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
@@ -0,0 +1,253 @@
+#pragma once
+
+#include "frustum.h"
+#include "../model_loading/mesh.h"
+#include "../model_loading/mesh_lod.h"
+#include "../rendering/gl_state.h"
+#include "../shader.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// layout of glDrawElementsIndirect's commands
+struct DrawElementsIndirectCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLuint baseVertex;
+    GLuint baseInstance;
+};
+
+// vertex array for drawing 'mesh' with instance indices: positions, normals and texture coordinates
+// at locations 0-2 like Mesh, 'elementBuffer' for the indices and one GLuint per instance from
+// 'instanceBuffer' at 'instanceAttribute', selected by the draw's base instance
+inline GLuint createIndirectVertexArray(const Mesh& mesh, GLuint elementBuffer, GLuint instanceBuffer, GLuint instanceAttribute) {
+    GLuint vertexArray;
+    glCreateVertexArrays(1, &vertexArray);
+    glVertexArrayElementBuffer(vertexArray, elementBuffer);
+    glVertexArrayVertexBuffer(vertexArray, 0, mesh.VertexBuffer(), 0, sizeof(Vertex));
+    const GLuint sizes[] = { 3, 3, 2 };
+    const GLuint offsets[] = { offsetof(Vertex, position), offsetof(Vertex, normal), offsetof(Vertex, texCoords) };
+    for (GLuint location = 0; location < 3; ++location) {
+        glEnableVertexArrayAttrib(vertexArray, location);
+        glVertexArrayAttribFormat(vertexArray, location, sizes[location], GL_FLOAT, GL_FALSE, offsets[location]);
+        glVertexArrayAttribBinding(vertexArray, location, 0);
+    }
+    glVertexArrayVertexBuffer(vertexArray, 1, instanceBuffer, 0, sizeof(GLuint));
+    glVertexArrayBindingDivisor(vertexArray, 1, 1);
+    glEnableVertexArrayAttrib(vertexArray, instanceAttribute);
+    glVertexArrayAttribIFormat(vertexArray, instanceAttribute, 1, GL_UNSIGNED_INT, 0);
+    glVertexArrayAttribBinding(vertexArray, instanceAttribute, 1);
+    return vertexArray;
+}
+
+// visible instances per LOD, read back GpuInstanceCuller::READBACK_FRAMES frames late
+struct GpuCullingStats {
+    static const unsigned int MAX_LODS = 4;
+    unsigned int visible[MAX_LODS] = {};
+    unsigned int total = 0;
+};
+
+// GPU driven culling and LOD selection for a large static instance set (shaders/cull_instances.comp).
+// The model matrices live in a storage buffer; each frame one compute thread per instance applies
+// a shared transform, tests the bounding sphere against the frustum, picks a LOD by distance and
+// appends the instance index to that LOD's range of the visible buffer, counting it in the LOD's
+// indirect draw command. draw() then issues one glMultiDrawElementsIndirect per mesh over its LOD
+// commands: counts never travel through the CPU. The visible indices feed an instanced integer
+// attribute (location 3), the vertex shader (shaders/instance_indirect.vs) fetches the matrix from
+// INSTANCES_BINDING with it. Meshes get their own VAO (createIndirectVertexArray) over the model's
+// vertex buffer and one element buffer holding all their LODs, built with buildLods().
+class GpuInstanceCuller {
+    public:
+        static const unsigned int LOD_COUNT = 3;
+        static const GLuint INSTANCES_BINDING = 0;
+        static const GLuint VISIBLE_BINDING = 1;
+        static const GLuint COMMANDS_BINDING = 2;
+        static const GLuint INSTANCE_ATTRIBUTE = 3;
+        static const unsigned int READBACK_FRAMES = 3;
+        static const unsigned int GROUP_SIZE = 256;    // local_size_x of the compute shader
+
+    private:
+        struct LodMesh {
+            GLuint vertexArray;
+            GLuint elementBuffer;
+        };
+
+        Shader& m_cullShader;
+        size_t m_count;
+        float m_boundingRadius = 0.0f;
+        float m_lodDistances[LOD_COUNT - 1] = { 40.0f, 120.0f };
+
+        GLuint m_instances = 0;
+        GLuint m_visible = 0;
+        GLuint m_commands = 0;
+        GLuint m_commandTemplate = 0;       // the commands with zero instances, copied over m_commands every frame
+        std::vector<LodMesh> m_meshes;
+        std::vector<DrawElementsIndirectCommand> m_templates;
+
+        GLuint m_readback = 0;
+        const unsigned char* m_readbackMapping = nullptr;
+        GLsync m_readbackFences[READBACK_FRAMES] = {};
+        unsigned int m_readbackSlot = 0;
+        GpuCullingStats m_stats;
+
+        size_t commandBytes() const { return m_templates.size() * sizeof(DrawElementsIndirectCommand); }
+
+        void createCommandBuffers() {
+            glCreateBuffers(1, &m_commandTemplate);
+            glNamedBufferStorage(m_commandTemplate, commandBytes(), m_templates.data(), 0);
+            glCreateBuffers(1, &m_commands);
+            glNamedBufferStorage(m_commands, commandBytes(), nullptr, 0);
+
+            GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glCreateBuffers(1, &m_readback);
+            glNamedBufferStorage(m_readback, commandBytes() * READBACK_FRAMES, nullptr, flags);
+            m_readbackMapping = static_cast<const unsigned char*>(glMapNamedBufferRange(m_readback, 0, commandBytes() * READBACK_FRAMES, flags));
+        }
+
+        // the slot about to be overwritten holds the counts of READBACK_FRAMES frames ago
+        void readStats() {
+            GLsync& fence = m_readbackFences[m_readbackSlot];
+            if (!fence) {
+                return;
+            }
+            GLenum result = glClientWaitSync(fence, 0, 0);
+            while (result == GL_TIMEOUT_EXPIRED) {
+                result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+            }
+            glDeleteSync(fence);
+            fence = nullptr;
+            if (!m_readbackMapping) {
+                return;
+            }
+            const DrawElementsIndirectCommand* commands = reinterpret_cast<const DrawElementsIndirectCommand*>(m_readbackMapping + m_readbackSlot * commandBytes());
+            m_stats = GpuCullingStats();
+            for (unsigned int lod = 0; lod < LOD_COUNT && lod < GpuCullingStats::MAX_LODS; ++lod) {
+                m_stats.visible[lod] = commands[lod].instanceCount;
+                m_stats.total += commands[lod].instanceCount;
+            }
+        }
+
+    public:
+        // count instances of 'models', uploaded once
+        GpuInstanceCuller(Shader& cullShader, const glm::mat4* models, size_t count) : m_cullShader(cullShader), m_count{ count } {
+            glCreateBuffers(1, &m_instances);
+            glNamedBufferStorage(m_instances, std::max<size_t>(count, 1) * sizeof(glm::mat4), models, 0);
+            glCreateBuffers(1, &m_visible);
+            glNamedBufferStorage(m_visible, std::max<size_t>(count, 1) * LOD_COUNT * sizeof(GLuint), nullptr, 0);
+        }
+
+        ~GpuInstanceCuller() {
+            for (unsigned int slot = 0; slot < READBACK_FRAMES; ++slot) {
+                if (m_readbackFences[slot]) {
+                    glDeleteSync(m_readbackFences[slot]);
+                }
+            }
+            for (const LodMesh& mesh : m_meshes) {
+                glState().forgetVertexArray(mesh.vertexArray);
+                glDeleteVertexArrays(1, &mesh.vertexArray);
+                glDeleteBuffers(1, &mesh.elementBuffer);
+            }
+            GLuint buffers[] = { m_instances, m_visible, m_commands, m_commandTemplate, m_readback };
+            glDeleteBuffers(5, buffers);
+        }
+
+        GpuInstanceCuller(const GpuInstanceCuller&) = delete;
+        GpuInstanceCuller& operator=(const GpuInstanceCuller&) = delete;
+
+        // before the first cull(). Positions, normals and texture coordinates at locations 0-2 like Mesh.
+        // The bounding sphere sits at the model origin and grows to fit every added mesh.
+        void addMesh(Mesh& mesh) {
+            if (m_commands) {
+                return;
+            }
+            for (const Vertex& vertex : mesh.Vertices()) {
+                m_boundingRadius = std::max(m_boundingRadius, glm::length(vertex.position));
+            }
+
+            std::vector<std::vector<unsigned int>> lods = buildLods(mesh.Vertices(), mesh.Indices(), LOD_COUNT);
+            std::vector<unsigned int> indices;
+            for (unsigned int lod = 0; lod < LOD_COUNT; ++lod) {
+                DrawElementsIndirectCommand command = {};
+                command.count = static_cast<GLuint>(lods[lod].size());
+                command.firstIndex = static_cast<GLuint>(indices.size());
+                command.baseInstance = static_cast<GLuint>(lod * m_count);
+                m_templates.push_back(command);
+                indices.insert(indices.end(), lods[lod].begin(), lods[lod].end());
+            }
+
+            LodMesh lodMesh;
+            glCreateBuffers(1, &lodMesh.elementBuffer);
+            glNamedBufferStorage(lodMesh.elementBuffer, indices.size() * sizeof(unsigned int), indices.data(), 0);
+            lodMesh.vertexArray = createIndirectVertexArray(mesh, lodMesh.elementBuffer, m_visible, INSTANCE_ATTRIBUTE);
+            m_meshes.push_back(lodMesh);
+        }
+
+        // view distances where LOD 1, 2 ... start
+        void setLodDistances(const float (&distances)[LOD_COUNT - 1]) {
+            std::copy(distances, distances + LOD_COUNT - 1, m_lodDistances);
+        }
+
+        // transform: applied to every model matrix before testing (and by the vertex shader before drawing)
+        void cull(const glm::mat4& viewProjection, const glm::vec3& cameraPosition, const glm::mat4& transform) {
+            if (m_meshes.empty()) {
+                return;
+            }
+            if (!m_commands) {
+                createCommandBuffers();
+            }
+            readStats();
+
+            glCopyNamedBufferSubData(m_commandTemplate, m_commands, 0, 0, commandBytes());
+
+            Frustum frustum(viewProjection);
+            m_cullShader.use();
+            m_cullShader.setMat4("transform", transform);
+            for (int plane = 0; plane < 6; ++plane) {
+                m_cullShader.setVec4(m_cullShader.uniform("frustumPlanes", plane), frustum.planes[plane]);
+            }
+            m_cullShader.setVec3("cameraPosition", cameraPosition);
+            m_cullShader.setFloat("boundingRadius", m_boundingRadius);
+            for (unsigned int lod = 0; lod < LOD_COUNT - 1; ++lod) {
+                m_cullShader.setFloat(m_cullShader.uniform("lodDistances", lod), m_lodDistances[lod]);
+            }
+            glUniform1ui(m_cullShader.uniform("instanceCount").value, static_cast<GLuint>(m_count));
+            glUniform1ui(m_cullShader.uniform("meshCount").value, static_cast<GLuint>(m_meshes.size()));
+
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, INSTANCES_BINDING, m_instances);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, VISIBLE_BINDING, m_visible);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, COMMANDS_BINDING, m_commands);
+            glDispatchCompute(static_cast<GLuint>((m_count + GROUP_SIZE - 1) / GROUP_SIZE), 1, 1);
+            glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+            glCopyNamedBufferSubData(m_commands, m_readback, 0, m_readbackSlot * commandBytes(), commandBytes());
+            m_readbackFences[m_readbackSlot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            m_readbackSlot = (m_readbackSlot + 1) % READBACK_FRAMES;
+        }
+
+        // with the caller's program in use, it reads the matrices from INSTANCES_BINDING
+        void draw() {
+            if (!m_commands) {
+                return;
+            }
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, INSTANCES_BINDING, m_instances);
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commands);
+            for (size_t mesh = 0; mesh < m_meshes.size(); ++mesh) {
+                glState().bindVertexArray(m_meshes[mesh].vertexArray);
+                glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+                    reinterpret_cast<const void*>(mesh * LOD_COUNT * sizeof(DrawElementsIndirectCommand)), LOD_COUNT, 0);
+            }
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        }
+
+        size_t count() const { return m_count; }
+        float boundingRadius() const { return m_boundingRadius; }
+        // index count of every LOD of the first mesh
+        GLuint lodIndexCount(unsigned int lod) const { return lod < m_templates.size() ? m_templates[lod].count : 0; }
+        const GpuCullingStats& stats() const { return m_stats; }
+};
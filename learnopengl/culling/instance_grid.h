@@ -0,0 +1,275 @@
+#pragma once
+
+#include "frustum.h"
+#include "occlusion_buffer.h"
+#include "../threading/thread_pool.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define INSTANCE_GRID_AVX 1
+#elif defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define INSTANCE_GRID_SSE 1
+#endif
+
+// Bounding spheres of a static instance set for CPU frustum culling. Instances are bucketed into a
+// uniform grid over the XZ extent of their centers (the asteroid ring is flat, one cell spans the
+// whole height) and stored structure-of-arrays, sorted by cell. Each cell's range is padded to a
+// multiple of LANES with spheres that always fail, so the SIMD loop never needs a tail. cull() first
+// classifies every cell's bounds against the frustum: cells outside are skipped, cells inside are
+// copied without tests, only intersecting cells test their spheres, LANES at a time. Optionally
+// the visible cells' bounds are tested against an OcclusionBuffer first. Cells are
+// split into chunks of similar size that run on the thread pool; every chunk writes the original
+// instance indices of its survivors to its own range of the output.
+class InstanceGrid {
+    public:
+#if defined(INSTANCE_GRID_AVX)
+        static const size_t LANES = 8;
+#elif defined(INSTANCE_GRID_SSE)
+        static const size_t LANES = 4;
+#else
+        static const size_t LANES = 1;
+#endif
+
+        // written by cull(): survivors at output[offset, offset + count)
+        struct Chunk {
+            uint32_t offset;
+            uint32_t count;
+            uint32_t occludedCells;     // in the frustum but hidden in the occlusion buffer
+        };
+
+    private:
+        struct Cell {
+            glm::vec3 minimum;
+            glm::vec3 maximum;
+            uint32_t begin;     // into the SoA arrays, a multiple of LANES
+            uint32_t end;
+        };
+        static const uint32_t PADDING = ~0u;
+
+        std::vector<float> m_x, m_y, m_z, m_radius;
+        std::vector<uint32_t> m_index;
+        std::vector<Cell> m_cells;
+        std::vector<uint32_t> m_chunkCells;     // first cell of every chunk, one past the last at the end
+        std::vector<Chunk> m_chunks;
+        size_t m_count = 0;
+
+        // -1 outside, 1 inside, 0 intersecting
+        static int classify(const glm::vec4 (&planes)[6], const glm::vec3& minimum, const glm::vec3& maximum) {
+            int result = 1;
+            for (const glm::vec4& plane : planes) {
+                glm::vec3 normal(plane);
+                glm::vec3 positive(normal.x >= 0.0f ? maximum.x : minimum.x, normal.y >= 0.0f ? maximum.y : minimum.y, normal.z >= 0.0f ? maximum.z : minimum.z);
+                glm::vec3 negative(normal.x >= 0.0f ? minimum.x : maximum.x, normal.y >= 0.0f ? minimum.y : maximum.y, normal.z >= 0.0f ? minimum.z : maximum.z);
+                if (glm::dot(normal, positive) + plane.w < 0.0f) {
+                    return -1;
+                }
+                if (glm::dot(normal, negative) + plane.w < 0.0f) {
+                    result = 0;
+                }
+            }
+            return result;
+        }
+
+        // appends the indices of the spheres in [begin, end) that intersect the frustum. Every lane
+        // is stored and only survivors advance, writes stay below output + (end - begin)
+        size_t testSpheres(const glm::vec4 (&planes)[6], uint32_t begin, uint32_t end, uint32_t* output) const {
+            size_t written = 0;
+#if defined(INSTANCE_GRID_AVX)
+            __m256 px[6], py[6], pz[6], pw[6];
+            for (int p = 0; p < 6; ++p) {
+                px[p] = _mm256_set1_ps(planes[p].x);
+                py[p] = _mm256_set1_ps(planes[p].y);
+                pz[p] = _mm256_set1_ps(planes[p].z);
+                pw[p] = _mm256_set1_ps(planes[p].w);
+            }
+            for (uint32_t i = begin; i < end; i += 8) {
+                __m256 x = _mm256_loadu_ps(&m_x[i]);
+                __m256 y = _mm256_loadu_ps(&m_y[i]);
+                __m256 z = _mm256_loadu_ps(&m_z[i]);
+                __m256 negativeRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(&m_radius[i]));
+                __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+                for (int p = 0; p < 6; ++p) {
+                    __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(px[p], x), _mm256_mul_ps(py[p], y)), _mm256_add_ps(_mm256_mul_ps(pz[p], z), pw[p]));
+                    inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negativeRadius, _CMP_GE_OQ));
+                }
+                int mask = _mm256_movemask_ps(inside);
+                for (int lane = 0; lane < 8; ++lane) {
+                    output[written] = m_index[i + lane];
+                    written += (mask >> lane) & 1;
+                }
+            }
+#elif defined(INSTANCE_GRID_SSE)
+            __m128 px[6], py[6], pz[6], pw[6];
+            for (int p = 0; p < 6; ++p) {
+                px[p] = _mm_set1_ps(planes[p].x);
+                py[p] = _mm_set1_ps(planes[p].y);
+                pz[p] = _mm_set1_ps(planes[p].z);
+                pw[p] = _mm_set1_ps(planes[p].w);
+            }
+            for (uint32_t i = begin; i < end; i += 4) {
+                __m128 x = _mm_loadu_ps(&m_x[i]);
+                __m128 y = _mm_loadu_ps(&m_y[i]);
+                __m128 z = _mm_loadu_ps(&m_z[i]);
+                __m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&m_radius[i]));
+                __m128 inside = _mm_cmpeq_ps(x, x);
+                for (int p = 0; p < 6; ++p) {
+                    __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px[p], x), _mm_mul_ps(py[p], y)), _mm_add_ps(_mm_mul_ps(pz[p], z), pw[p]));
+                    inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+                }
+                int mask = _mm_movemask_ps(inside);
+                for (int lane = 0; lane < 4; ++lane) {
+                    output[written] = m_index[i + lane];
+                    written += (mask >> lane) & 1;
+                }
+            }
+#else
+            for (uint32_t i = begin; i < end; ++i) {
+                bool inside = true;
+                for (const glm::vec4& plane : planes) {
+                    inside = inside && plane.x * m_x[i] + plane.y * m_y[i] + plane.z * m_z[i] + plane.w >= -m_radius[i];
+                }
+                output[written] = m_index[i];
+                written += inside ? 1 : 0;
+            }
+#endif
+            return written;
+        }
+
+        size_t cullChunk(const glm::vec4 (&planes)[6], size_t chunk, uint32_t* output, const OcclusionBuffer* occlusion, const glm::mat4& transform, uint32_t& occluded) const {
+            size_t written = 0;
+            occluded = 0;
+            for (uint32_t cell = m_chunkCells[chunk]; cell < m_chunkCells[chunk + 1]; ++cell) {
+                const Cell& bounds = m_cells[cell];
+                if (bounds.begin == bounds.end) {
+                    continue;
+                }
+                int classification = classify(planes, bounds.minimum, bounds.maximum);
+                if (classification < 0) {
+                    continue;
+                }
+                if (occlusion && !occlusion->isVisible(bounds.minimum, bounds.maximum, transform)) {
+                    ++occluded;
+                    continue;
+                }
+                if (classification > 0) {
+                    for (uint32_t i = bounds.begin; i < bounds.end; ++i) {
+                        output[written] = m_index[i];
+                        written += m_index[i] != PADDING ? 1 : 0;
+                    }
+                } else {
+                    written += testSpheres(planes, bounds.begin, bounds.end, output + written);
+                }
+            }
+            return written;
+        }
+
+    public:
+        // radius: bounding sphere of the mesh around its origin, scaled per instance by the matrix.
+        // cellSize: grid spacing on X and Z in world units
+        void build(const glm::mat4* models, size_t count, float radius, float cellSize) {
+            m_count = count;
+            glm::vec2 minimum(0.0f), maximum(0.0f);
+            for (size_t i = 0; i < count; ++i) {
+                glm::vec2 center(models[i][3].x, models[i][3].z);
+                minimum = i ? glm::min(minimum, center) : center;
+                maximum = i ? glm::max(maximum, center) : center;
+            }
+            int cellsX = std::max(1, static_cast<int>((maximum.x - minimum.x) / cellSize) + 1);
+            int cellsZ = std::max(1, static_cast<int>((maximum.y - minimum.y) / cellSize) + 1);
+
+            // counting sort by cell
+            std::vector<uint32_t> cellOf(count);
+            std::vector<uint32_t> cellCount(cellsX * cellsZ, 0);
+            for (size_t i = 0; i < count; ++i) {
+                int x = std::min(cellsX - 1, static_cast<int>((models[i][3].x - minimum.x) / cellSize));
+                int z = std::min(cellsZ - 1, static_cast<int>((models[i][3].z - minimum.y) / cellSize));
+                cellOf[i] = static_cast<uint32_t>(z * cellsX + x);
+                ++cellCount[cellOf[i]];
+            }
+            m_cells.assign(cellCount.size(), Cell());
+            uint32_t offset = 0;
+            for (size_t cell = 0; cell < m_cells.size(); ++cell) {
+                m_cells[cell].begin = m_cells[cell].end = offset;
+                m_cells[cell].minimum = glm::vec3(1e30f);
+                m_cells[cell].maximum = glm::vec3(-1e30f);
+                offset += static_cast<uint32_t>((cellCount[cell] + LANES - 1) / LANES * LANES);
+            }
+            // padding always fails the plane tests and is never copied by fully inside cells
+            m_x.assign(offset, 0.0f);
+            m_y.assign(offset, 0.0f);
+            m_z.assign(offset, 0.0f);
+            m_radius.assign(offset, -1e30f);
+            m_index.assign(offset, static_cast<uint32_t>(PADDING));
+            for (size_t i = 0; i < count; ++i) {
+                Cell& cell = m_cells[cellOf[i]];
+                const glm::mat4& model = models[i];
+                glm::vec3 center(model[3]);
+                float scale = std::max(glm::length(glm::vec3(model[0])), std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+                uint32_t slot = cell.end++;
+                m_x[slot] = center.x;
+                m_y[slot] = center.y;
+                m_z[slot] = center.z;
+                m_radius[slot] = radius * scale;
+                m_index[slot] = static_cast<uint32_t>(i);
+                cell.minimum = glm::min(cell.minimum, center - glm::vec3(radius * scale));
+                cell.maximum = glm::max(cell.maximum, center + glm::vec3(radius * scale));
+            }
+            for (Cell& cell : m_cells) {
+                cell.end = static_cast<uint32_t>(cell.begin + (cell.end - cell.begin + LANES - 1) / LANES * LANES);
+            }
+
+            // chunks of about equal size, a few per thread so uneven culling still balances
+            size_t chunkCount = std::min(m_cells.size(), (threadPool().size() + 1) * 4);
+            size_t target = (offset + chunkCount - 1) / std::max<size_t>(chunkCount, 1);
+            m_chunkCells.assign(1, 0);
+            size_t filled = 0;
+            for (size_t cell = 0; cell < m_cells.size(); ++cell) {
+                filled += m_cells[cell].end - m_cells[cell].begin;
+                if (filled >= target && cell + 1 < m_cells.size()) {
+                    m_chunkCells.push_back(static_cast<uint32_t>(cell + 1));
+                    filled = 0;
+                }
+            }
+            m_chunkCells.push_back(static_cast<uint32_t>(m_cells.size()));
+            m_chunks.assign(m_chunkCells.size() - 1, Chunk());
+        }
+
+        // output has to hold outputSize() indices. transform: rigid transform applied to the whole
+        // set, the planes are moved into the grid's space instead of moving the instances.
+        // nullptr pool culls on the calling thread. occlusion: cells in the frustum are also tested
+        // against it, filled for the same view
+        const std::vector<Chunk>& cull(const Frustum& frustum, const glm::mat4& transform, uint32_t* output, ThreadPool* pool = &threadPool(), const OcclusionBuffer* occlusion = nullptr) {
+            glm::vec4 planes[6];
+            glm::mat4 transposed = glm::transpose(transform);
+            for (int p = 0; p < 6; ++p) {
+                planes[p] = transposed * frustum.planes[p];
+            }
+            auto cullChunks = [&](size_t begin, size_t end) {
+                for (size_t chunk = begin; chunk < end; ++chunk) {
+                    uint32_t offset = m_cells[m_chunkCells[chunk]].begin;
+                    m_chunks[chunk].offset = offset;
+                    m_chunks[chunk].count = static_cast<uint32_t>(cullChunk(planes, chunk, output + offset, occlusion, transform, m_chunks[chunk].occludedCells));
+                }
+            };
+            if (pool) {
+                pool->parallelFor(m_chunks.size(), 1, cullChunks);
+            } else {
+                cullChunks(0, m_chunks.size());
+            }
+            return m_chunks;
+        }
+
+        // padded instance count, every chunk writes within its cells' range of the SoA arrays
+        size_t outputSize() const { return m_index.size(); }
+        size_t count() const { return m_count; }
+        size_t cellCount() const { return m_cells.size(); }
+        const std::vector<Chunk>& chunks() const { return m_chunks; }
+};
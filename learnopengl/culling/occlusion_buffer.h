@@ -0,0 +1,256 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define OCCLUSION_BUFFER_SSE 1
+#endif
+
+struct OcclusionBufferStats {
+    unsigned int occluderTriangles = 0;     // submitted since clear()
+    unsigned int rasterizedTriangles = 0;   // of those, front facing, in front of the camera and on screen
+};
+
+// Software depth buffer at reduced resolution for occlusion culling on the CPU, no GL involved.
+// A few large, low-poly occluders are rasterized every frame (four pixels at a time with SSE), then
+// bounding boxes are tested against it before their draws are submitted. Depth is 1 / w, which is
+// linear in screen space and independent of the projection's depth range; larger is nearer and the
+// buffer clears to 0, infinitely far. Every TILE_SIZE x TILE_SIZE tile keeps the farthest depth of
+// its pixels, so a box whose nearest point lies behind a tile's farthest depth is hidden there
+// without looking at pixels. Occluders have to be closed meshes wound counter-clockwise, back faces
+// and triangles crossing the near plane are skipped, which only ever makes the buffer emptier.
+// Depth is sampled at pixel centers, at low resolution a box can disappear behind an occluder's
+// silhouette by less than a pixel. Tests are read only and can run on several threads at once.
+class OcclusionBuffer {
+    public:
+        static const int TILE_SIZE = 8;
+
+    private:
+        struct ScreenVertex {
+            float x, y, depth;
+            bool valid;     // in front of the camera and inside the guard band
+        };
+        static constexpr float MIN_W = 1e-3f;
+        static constexpr float GUARD_BAND = 8.0f;     // in screen sizes, rasterizing beyond it would lose precision
+
+        int m_width;
+        int m_height;
+        int m_tilesX;
+        int m_tilesY;
+        glm::mat4 m_viewProjection = glm::mat4(1.0f);
+        std::vector<float> m_depth;
+        std::vector<float> m_tiles;
+        std::vector<ScreenVertex> m_vertices;
+        OcclusionBufferStats m_stats;
+
+        ScreenVertex project(const glm::vec4& clip) const {
+            ScreenVertex vertex;
+            vertex.valid = clip.w > MIN_W;
+            float inverseW = vertex.valid ? 1.0f / clip.w : 0.0f;
+            vertex.x = (clip.x * inverseW * 0.5f + 0.5f) * m_width;
+            vertex.y = (clip.y * inverseW * 0.5f + 0.5f) * m_height;
+            vertex.depth = inverseW;
+            vertex.valid = vertex.valid && std::abs(vertex.x) < GUARD_BAND * m_width && std::abs(vertex.y) < GUARD_BAND * m_height;
+            return vertex;
+        }
+
+        // false if the triangle was skipped. Extends the dirty pixel rectangle by what it touched
+        bool rasterize(const ScreenVertex& v0, const ScreenVertex& v1, const ScreenVertex& v2, int (&dirty)[4]) {
+            float area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+            if (!v0.valid || !v1.valid || !v2.valid || area <= 0.0f) {
+                return false;
+            }
+            int minX = std::max(0, static_cast<int>(std::floor(std::min(v0.x, std::min(v1.x, v2.x)))));
+            int maxX = std::min(m_width - 1, static_cast<int>(std::ceil(std::max(v0.x, std::max(v1.x, v2.x)))));
+            int minY = std::max(0, static_cast<int>(std::floor(std::min(v0.y, std::min(v1.y, v2.y)))));
+            int maxY = std::min(m_height - 1, static_cast<int>(std::ceil(std::max(v0.y, std::max(v1.y, v2.y)))));
+            if (minX > maxX || minY > maxY) {
+                return false;
+            }
+            // rows are processed in groups of four pixels, the width is a multiple of TILE_SIZE
+            minX &= ~3;
+
+            // edge functions a * x + b * y + c, non-negative inside a counter-clockwise triangle
+            const ScreenVertex* corners[3] = { &v0, &v1, &v2 };
+            float a[3], b[3], c[3];
+            for (int edge = 0; edge < 3; ++edge) {
+                const ScreenVertex& from = *corners[edge];
+                const ScreenVertex& to = *corners[(edge + 1) % 3];
+                a[edge] = from.y - to.y;
+                b[edge] = to.x - from.x;
+                c[edge] = -(a[edge] * from.x + b[edge] * from.y);
+            }
+            // depth plane
+            float depthX = ((v1.depth - v0.depth) * (v2.y - v0.y) - (v2.depth - v0.depth) * (v1.y - v0.y)) / area;
+            float depthY = ((v2.depth - v0.depth) * (v1.x - v0.x) - (v1.depth - v0.depth) * (v2.x - v0.x)) / area;
+            float depthC = v0.depth - depthX * v0.x - depthY * v0.y;
+
+#if defined(OCCLUSION_BUFFER_SSE)
+            __m128 offsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+            __m128 zero = _mm_setzero_ps();
+            __m128 edgeStep[3], depthStep = _mm_set1_ps(depthX * 4.0f);
+            for (int edge = 0; edge < 3; ++edge) {
+                edgeStep[edge] = _mm_set1_ps(a[edge] * 4.0f);
+            }
+            for (int y = minY; y <= maxY; ++y) {
+                float centerY = y + 0.5f;
+                __m128 x = _mm_add_ps(_mm_set1_ps(static_cast<float>(minX)), offsets);
+                __m128 edges[3];
+                for (int edge = 0; edge < 3; ++edge) {
+                    edges[edge] = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a[edge]), x), _mm_set1_ps(b[edge] * centerY + c[edge]));
+                }
+                __m128 depth = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(depthX), x), _mm_set1_ps(depthY * centerY + depthC));
+                float* row = &m_depth[y * m_width];
+                for (int px = minX; px <= maxX; px += 4) {
+                    __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(edges[0], zero), _mm_cmpge_ps(edges[1], zero)), _mm_cmpge_ps(edges[2], zero));
+                    __m128 stored = _mm_loadu_ps(row + px);
+                    __m128 nearer = _mm_max_ps(stored, depth);
+                    _mm_storeu_ps(row + px, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, stored)));
+                    for (int edge = 0; edge < 3; ++edge) {
+                        edges[edge] = _mm_add_ps(edges[edge], edgeStep[edge]);
+                    }
+                    depth = _mm_add_ps(depth, depthStep);
+                }
+            }
+#else
+            for (int y = minY; y <= maxY; ++y) {
+                float centerY = y + 0.5f;
+                float* row = &m_depth[y * m_width];
+                for (int px = minX; px <= maxX; ++px) {
+                    float centerX = px + 0.5f;
+                    bool inside = true;
+                    for (int edge = 0; edge < 3; ++edge) {
+                        inside = inside && a[edge] * centerX + b[edge] * centerY + c[edge] >= 0.0f;
+                    }
+                    if (inside) {
+                        row[px] = std::max(row[px], depthX * centerX + depthY * centerY + depthC);
+                    }
+                }
+            }
+#endif
+            dirty[0] = std::min(dirty[0], minX);
+            dirty[1] = std::min(dirty[1], minY);
+            dirty[2] = std::max(dirty[2], std::min(maxX | 3, m_width - 1));
+            dirty[3] = std::max(dirty[3], maxY);
+            return true;
+        }
+
+        // farthest depth of every tile the pixel rectangle touches
+        void updateTiles(const int (&dirty)[4]) {
+            for (int tileY = dirty[1] / TILE_SIZE; tileY <= dirty[3] / TILE_SIZE; ++tileY) {
+                for (int tileX = dirty[0] / TILE_SIZE; tileX <= dirty[2] / TILE_SIZE; ++tileX) {
+                    float farthest = m_depth[tileY * TILE_SIZE * m_width + tileX * TILE_SIZE];
+                    for (int y = tileY * TILE_SIZE; y < (tileY + 1) * TILE_SIZE; ++y) {
+                        const float* row = &m_depth[y * m_width + tileX * TILE_SIZE];
+                        for (int x = 0; x < TILE_SIZE; ++x) {
+                            farthest = std::min(farthest, row[x]);
+                        }
+                    }
+                    m_tiles[tileY * m_tilesX + tileX] = farthest;
+                }
+            }
+        }
+
+    public:
+        // rounded up to whole tiles. The aspect ratio should match the camera's
+        OcclusionBuffer(int width = 256, int height = 128)
+            : m_width{ (std::max(width, 1) + TILE_SIZE - 1) / TILE_SIZE * TILE_SIZE },
+              m_height{ (std::max(height, 1) + TILE_SIZE - 1) / TILE_SIZE * TILE_SIZE } {
+            m_tilesX = m_width / TILE_SIZE;
+            m_tilesY = m_height / TILE_SIZE;
+            m_depth.assign(m_width * m_height, 0.0f);
+            m_tiles.assign(m_tilesX * m_tilesY, 0.0f);
+        }
+
+        // starts a frame seen through viewProjection, nothing occludes anything
+        void clear(const glm::mat4& viewProjection) {
+            m_viewProjection = viewProjection;
+            std::fill(m_depth.begin(), m_depth.end(), 0.0f);
+            std::fill(m_tiles.begin(), m_tiles.end(), 0.0f);
+            m_stats = OcclusionBufferStats();
+        }
+
+        // indexCount / 3 triangles over vertexCount positions 'stride' bytes apart (a Vertex array
+        // works), placed by 'model'
+        void renderOccluder(const glm::mat4& model, const glm::vec3* positions, size_t vertexCount, size_t stride, const unsigned int* indices, size_t indexCount) {
+            glm::mat4 modelViewProjection = m_viewProjection * model;
+            m_vertices.resize(vertexCount);
+            const unsigned char* position = reinterpret_cast<const unsigned char*>(positions);
+            for (size_t i = 0; i < vertexCount; ++i, position += stride) {
+                m_vertices[i] = project(modelViewProjection * glm::vec4(*reinterpret_cast<const glm::vec3*>(position), 1.0f));
+            }
+
+            int dirty[4] = { m_width, m_height, -1, -1 };
+            for (size_t i = 0; i + 2 < indexCount; i += 3) {
+                ++m_stats.occluderTriangles;
+                if (indices[i] < vertexCount && indices[i + 1] < vertexCount && indices[i + 2] < vertexCount
+                    && rasterize(m_vertices[indices[i]], m_vertices[indices[i + 1]], m_vertices[indices[i + 2]], dirty)) {
+                    ++m_stats.rasterizedTriangles;
+                }
+            }
+            if (dirty[2] >= 0) {
+                updateTiles(dirty);
+            }
+        }
+
+        // false if the box, placed by 'model', is hidden behind the occluders or off screen. Boxes
+        // reaching behind the camera are always visible
+        bool isVisible(const glm::vec3& minimum, const glm::vec3& maximum, const glm::mat4& model = glm::mat4(1.0f)) const {
+            glm::mat4 modelViewProjection = m_viewProjection * model;
+            float minX = 1e30f, minY = 1e30f, maxX = -1e30f, maxY = -1e30f, nearest = 0.0f;
+            for (int corner = 0; corner < 8; ++corner) {
+                glm::vec3 point((corner & 1) ? maximum.x : minimum.x, (corner & 2) ? maximum.y : minimum.y, (corner & 4) ? maximum.z : minimum.z);
+                glm::vec4 clip = modelViewProjection * glm::vec4(point, 1.0f);
+                if (clip.w <= MIN_W) {
+                    return true;
+                }
+                float inverseW = 1.0f / clip.w;
+                float x = (clip.x * inverseW * 0.5f + 0.5f) * m_width;
+                float y = (clip.y * inverseW * 0.5f + 0.5f) * m_height;
+                minX = std::min(minX, x);
+                maxX = std::max(maxX, x);
+                minY = std::min(minY, y);
+                maxY = std::max(maxY, y);
+                nearest = std::max(nearest, inverseW);
+            }
+            // every pixel the box's screen rectangle overlaps
+            int x0 = std::max(0, static_cast<int>(std::floor(minX)));
+            int x1 = std::min(m_width - 1, static_cast<int>(std::ceil(maxX)) - 1);
+            int y0 = std::max(0, static_cast<int>(std::floor(minY)));
+            int y1 = std::min(m_height - 1, static_cast<int>(std::ceil(maxY)) - 1);
+            if (x0 > x1 || y0 > y1) {
+                return false;
+            }
+            for (int tileY = y0 / TILE_SIZE; tileY <= y1 / TILE_SIZE; ++tileY) {
+                for (int tileX = x0 / TILE_SIZE; tileX <= x1 / TILE_SIZE; ++tileX) {
+                    if (m_tiles[tileY * m_tilesX + tileX] >= nearest) {
+                        continue;
+                    }
+                    // part of the tile is farther than the box, look at the pixels under it
+                    int rowEnd = std::min(y1, (tileY + 1) * TILE_SIZE - 1);
+                    int columnEnd = std::min(x1, (tileX + 1) * TILE_SIZE - 1);
+                    for (int y = std::max(y0, tileY * TILE_SIZE); y <= rowEnd; ++y) {
+                        const float* row = &m_depth[y * m_width];
+                        for (int x = std::max(x0, tileX * TILE_SIZE); x <= columnEnd; ++x) {
+                            if (row[x] < nearest) {
+                                return true;
+                            }
+                        }
+                    }
+                }
+            }
+            return false;
+        }
+
+        int width() const { return m_width; }
+        int height() const { return m_height; }
+        // m_width * m_height values, rows bottom to top
+        const float* depth() const { return m_depth.data(); }
+        const OcclusionBufferStats& stats() const { return m_stats; }
+};
@@ -11,6 +11,12 @@
 #include "stb_image.h"
 #include "model_loading/model.h"
 #include "utils.h"
+#include "rendering/light_buffer.h"
+#include "rendering/uniform_blocks.h"
+#include "rendering/render_graph.h"
+#include "post/bloom.h"
+#include "post/post_process.h"
+#include "shading/permutations.h"
 
 #include <iostream>
 
@@ -19,18 +25,17 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void processInput(GLFWwindow* window);
 unsigned int loadTexture(const char* path);
-unsigned int loadCubemap(std::vector<std::string> faces_paths);
-void renderQuad();
 void renderCube();
 
 // settings
 const unsigned int SCR_WIDTH = 1024;
 const unsigned int SCR_HEIGHT = 768;
-bool gamma = false;
-bool gammaKeyPressed = false;
-bool bloom = true;
+bool gradingKeyPressed = false;
 bool bloomKeyPressed = false;
-float exposure = 1.0f;
+// Q and E shrink and widen the glow
+BloomSettings bloomSettings;
+// B toggles bloom, G the color grading
+PostSettings postSettings;
 
 // camera
 Camera camera(glm::vec3(0.f, 0.f, 3.f));
@@ -81,18 +86,13 @@ int main()
         return -1;
     }
 
-    // configure global opengl state
-    // -----------------------------
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-    // build and compile our shader zprogram
+    // build and compile our shader zprogram, the post pass adds its permutations to the same library
     // ------------------------------------
-    Shader shader("shaders/bloom.vs", "shaders/bloom.fs");
-    Shader shaderLight("shaders/bloom.vs", "shaders/light_cube.fs");
-    Shader shaderBlur("shaders/blur.vs", "shaders/blur.fs");
-    Shader shaderBloomFinal("shaders/bloom_final.vs", "shaders/bloom_final.fs");
+    ShaderLibrary shaders;
+    Shader& shader = shaders.get("shaders/bloom.vs", "shaders/bloom.fs");
+    Shader& shaderLight = shaders.get("shaders/bloom.vs", "shaders/light_cube.fs");
+    Shader& shaderBloomDownsample = shaders.get("shaders/fullscreen.vs", "shaders/bloom_downsample.fs");
+    Shader& shaderBloomUpsample = shaders.get("shaders/fullscreen.vs", "shaders/bloom_upsample.fs");
 
     // load textures
     // -------------
@@ -100,59 +100,6 @@ int main()
     unsigned int woodTexture = textureFromFile("wood.png", directory, true);
     unsigned int containerTexture = textureFromFile("wood_container.png", directory, true);
 
-    // configure (floating point) framebuffers
-    // ---------------------------------------
-    unsigned int hdrFBO;
-    glGenFramebuffers(1, &hdrFBO);
-    glBindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
-    // create 2 floating point color buffers (1 for normal rendering, other for brightness threshold values)
-    unsigned int colorBuffers[2];
-    glGenTextures(2, colorBuffers);
-    for (unsigned int i = 0; i < 2; i++)
-    {
-        glBindTexture(GL_TEXTURE_2D, colorBuffers[i]);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);  // we clamp to the edge as the blur filter would otherwise sample repeated texture values!
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        // attach texture to framebuffer
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, colorBuffers[i], 0);
-    }
-    // create and attach depth buffer (renderbuffer)
-    unsigned int rboDepth;
-    glGenRenderbuffers(1, &rboDepth);
-    glBindRenderbuffer(GL_RENDERBUFFER, rboDepth);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, SCR_WIDTH, SCR_HEIGHT);
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rboDepth);
-    // tell OpenGL which color attachments we'll use (of this framebuffer) for rendering 
-    unsigned int attachments[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
-    glDrawBuffers(2, attachments);
-    // finally check if framebuffer is complete
-    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-        std::cout << "Framebuffer not complete!" << std::endl;
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-    // ping-pong-framebuffer for blurring
-    unsigned int pingpongFBO[2];
-    unsigned int pingpongColorbuffers[2];
-    glGenFramebuffers(2, pingpongFBO);
-    glGenTextures(2, pingpongColorbuffers);
-    for (unsigned int i = 0; i < 2; i++)
-    {
-        glBindFramebuffer(GL_FRAMEBUFFER, pingpongFBO[i]);
-        glBindTexture(GL_TEXTURE_2D, pingpongColorbuffers[i]);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE); // we clamp to the edge as the blur filter would otherwise sample repeated texture values!
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, pingpongColorbuffers[i], 0);
-        // also check if framebuffers are complete (no need for depth buffer)
-        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-            std::cout << "Framebuffer not complete!" << std::endl;
-    }
-
     // lighting info
     // -------------
     // positions
@@ -167,16 +114,127 @@ int main()
     lightColors.push_back(glm::vec3(10.0f,  0.0f,  0.0f));
     lightColors.push_back(glm::vec3(0.0f,   0.0f,  15.0f));
     lightColors.push_back(glm::vec3(0.0f,   5.0f,  0.0f));
+    // the scene lights never move, upload them to the light storage buffer once
+    LightBuffer lightBuffer(LIGHTS_BINDING);
+    for (unsigned int i = 0; i < lightPositions.size(); i++)
+    {
+        PointLight light;
+        light.position = lightPositions[i];
+        light.color = lightColors[i];
+        lightBuffer.add(light);
+    }
+    lightBuffer.upload();
 
     // shader configuration
     // --------------------
     shader.use();
     shader.setInt("diffuseTexture", 0);
-    shaderBlur.use();
-    shaderBlur.setInt("image", 0);
-    shaderBloomFinal.use();
-    shaderBloomFinal.setInt("scene", 0);
-    shaderBloomFinal.setInt("bloomBlur", 1);
+
+    // render graph: scene into an hdr target, bloom down and back up a chain of smaller targets
+    // (the first step picks the bright parts), then a single post pass composites, tonemaps and
+    // grades into the window. every target is a transient of the graph and everything is
+    // reallocated when the window resizes
+    // ------------------------------------------------------------------------------------------------
+    RenderGraph graph(SCR_WIDTH, SCR_HEIGHT);
+    RenderResource backbuffer = graph.importBackbuffer();
+    RenderResource hdrColor;
+    graph.addPass("scene",
+        [&](RenderPassBuilder& builder)
+        {
+            hdrColor = builder.create("hdr color", RenderTargetDesc(GL_RGBA16F));
+            builder.create("depth", RenderTargetDesc(GL_DEPTH_COMPONENT24, 1.0f, GL_NEAREST));
+        },
+        [&](const RenderPassResources& targets)
+        {
+            glClearColor(0.f, 0.f, 0.f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            // the bloom and post passes change blending and depth testing
+            glState().enable(GL_DEPTH_TEST);
+            glState().enable(GL_BLEND);
+            glState().blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+            // draw objects
+            shader.use();
+            glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)targets.width() / (float)targets.height(), 0.1f, 100.0f);
+            glm::mat4 view = camera.GetViewMatrix();
+            shader.setMat4("projection", projection);
+            shader.setMat4("view", view);
+            glm::mat4 model = glm::mat4(1.0f);
+
+            glState().bindTexture(0, woodTexture);
+
+            shader.setVec3("viewPos", camera.Position);
+            // create one large cube that acts as the floor
+            model = glm::mat4(1.0f);
+            model = glm::translate(model, glm::vec3(0.0f, -1.0f, 0.0));
+            model = glm::scale(model, glm::vec3(12.5f, 0.5f, 12.5f));
+            shader.setMat4("model", model);
+            renderCube();
+            // then create multiple cubes as the scenery
+            glState().bindTexture(0, containerTexture);
+            model = glm::mat4(1.0f);
+            model = glm::translate(model, glm::vec3(0.0f, 1.5f, 0.0));
+            model = glm::scale(model, glm::vec3(0.5f));
+            shader.setMat4("model", model);
+            renderCube();
+
+            model = glm::mat4(1.0f);
+            model = glm::translate(model, glm::vec3(2.0f, 0.0f, 1.0));
+            model = glm::scale(model, glm::vec3(0.5f));
+            shader.setMat4("model", model);
+            renderCube();
+
+            model = glm::mat4(1.0f);
+            model = glm::translate(model, glm::vec3(-1.0f, -1.0f, 2.0));
+            model = glm::rotate(model, glm::radians(60.0f), glm::normalize(glm::vec3(1.0, 0.0, 1.0)));
+            shader.setMat4("model", model);
+            renderCube();
+
+            model = glm::mat4(1.0f);
+            model = glm::translate(model, glm::vec3(0.0f, 2.7f, 4.0));
+            model = glm::rotate(model, glm::radians(23.0f), glm::normalize(glm::vec3(1.0, 0.0, 1.0)));
+            model = glm::scale(model, glm::vec3(1.25));
+            shader.setMat4("model", model);
+            renderCube();
+
+            model = glm::mat4(1.0f);
+            model = glm::translate(model, glm::vec3(-2.0f, 1.0f, -3.0));
+            model = glm::rotate(model, glm::radians(124.0f), glm::normalize(glm::vec3(1.0, 0.0, 1.0)));
+            shader.setMat4("model", model);
+            renderCube();
+
+            model = glm::mat4(1.0f);
+            model = glm::translate(model, glm::vec3(-3.0f, 0.0f, 0.0));
+            model = glm::scale(model, glm::vec3(0.5f));
+            shader.setMat4("model", model);
+            renderCube();
+
+            shaderLight.use();
+            shaderLight.setMat4("projection", projection);
+            shaderLight.setMat4("view", view);
+
+            for (unsigned int i = 0; i < lightPositions.size(); i++)
+            {
+                model = glm::mat4(1.0f);
+                model = glm::translate(model, glm::vec3(lightPositions[i]));
+                model = glm::scale(model, glm::vec3(0.25f));
+                shaderLight.setMat4("model", model);
+                shaderLight.setVec3("lightColor", lightColors[i]);
+                renderCube();
+            }
+        });
+
+    RenderResource bloomBlur = addBloomPasses(graph, hdrColor, shaderBloomDownsample, shaderBloomUpsample, bloomSettings);
+
+    // the exponential curve the chapter always used, with a slight grade on top
+    postSettings.grading.tonemap = TONEMAP_EXPONENTIAL;
+    postSettings.grading.contrast = 1.1f;
+    postSettings.grading.saturation = 1.1f;
+    PostProcess postProcess(shaders);
+    addPostProcessPass(graph, hdrColor, bloomBlur, backbuffer, postProcess, postSettings);
+    graph.compile();
+    std::cout << "Render graph:" << std::endl;
+    graph.print();
 
     // render loop
     // -----------
@@ -194,118 +252,13 @@ int main()
 
         // render
         // ------
-        glClearColor(0.f, 0.f, 0.f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        glBindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        // draw objects
-        shader.use();
-        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-        glm::mat4 view = camera.GetViewMatrix();
-        shader.setMat4("projection", projection);
-        shader.setMat4("view", view);
-        glm::mat4 model = glm::mat4(1.0f);
-        
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, woodTexture);
-
-        // set lighting uniforms
-        for (unsigned int i = 0; i < lightPositions.size(); i++)
-        {
-            shader.setVec3("lights[" + std::to_string(i) + "].Position", lightPositions[i]);
-            shader.setVec3("lights[" + std::to_string(i) + "].Color", lightColors[i]);
-        }
-        shader.setVec3("viewPos", camera.Position);
-        // create one large cube that acts as the floor
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, glm::vec3(0.0f, -1.0f, 0.0));
-        model = glm::scale(model, glm::vec3(12.5f, 0.5f, 12.5f));
-        shader.setMat4("model", model);
-        renderCube();
-        // then create multiple cubes as the scenery
-        glBindTexture(GL_TEXTURE_2D, containerTexture);
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, glm::vec3(0.0f, 1.5f, 0.0));
-        model = glm::scale(model, glm::vec3(0.5f));
-        shader.setMat4("model", model);
-        renderCube();
-
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, glm::vec3(2.0f, 0.0f, 1.0));
-        model = glm::scale(model, glm::vec3(0.5f));
-        shader.setMat4("model", model);
-        renderCube();
-
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, glm::vec3(-1.0f, -1.0f, 2.0));
-        model = glm::rotate(model, glm::radians(60.0f), glm::normalize(glm::vec3(1.0, 0.0, 1.0)));
-        shader.setMat4("model", model);
-        renderCube();
-
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, glm::vec3(0.0f, 2.7f, 4.0));
-        model = glm::rotate(model, glm::radians(23.0f), glm::normalize(glm::vec3(1.0, 0.0, 1.0)));
-        model = glm::scale(model, glm::vec3(1.25));
-        shader.setMat4("model", model);
-        renderCube();
-
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, glm::vec3(-2.0f, 1.0f, -3.0));
-        model = glm::rotate(model, glm::radians(124.0f), glm::normalize(glm::vec3(1.0, 0.0, 1.0)));
-        shader.setMat4("model", model);
-        renderCube();
-
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, glm::vec3(-3.0f, 0.0f, 0.0));
-        model = glm::scale(model, glm::vec3(0.5f));
-        shader.setMat4("model", model);
-        renderCube();
-
-        shaderLight.use();
-        shaderLight.setMat4("projection", projection);
-        shaderLight.setMat4("view", view);
-
-        for (unsigned int i = 0; i < lightPositions.size(); i++)
-        {
-            model = glm::mat4(1.0f);
-            model = glm::translate(model, glm::vec3(lightPositions[i]));
-            model = glm::scale(model, glm::vec3(0.25f));
-            shaderLight.setMat4("model", model);
-            shaderLight.setVec3("lightColor", lightColors[i]);
-            renderCube();
-        }
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-        bool horizontal = true, first_iteration = true;
-        unsigned int steps = 10;
-        shaderBlur.use();
-
-        for (unsigned int i = 0; i < steps; ++i) {
-            glBindFramebuffer(GL_FRAMEBUFFER, pingpongFBO[i]);
-            shaderBlur.setBool("horizontal", horizontal);
-            glBindTexture(GL_TEXTURE_2D, first_iteration ? colorBuffers[1] : pingpongFBO[!horizontal]);
-            renderQuad();
-            horizontal = !horizontal;
-            if (first_iteration)
-                first_iteration = false;
-        }
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-        // 3. now render floating point color buffer to 2D quad and tonemap HDR colors to default framebuffer's (clamped) color range
-        // --------------------------------------------------------------------------------------------------------------------------
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        shaderBloomFinal.use();
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, colorBuffers[0]);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, pingpongColorbuffers[!horizontal]);
-        shaderBloomFinal.setInt("bloom", bloom);
-        shaderBloomFinal.setFloat("exposure", exposure);
-        renderQuad();
-
-        std::cout << "bloom: " << (bloom ? "on" : "off") << "| exposure: " << exposure << std::endl;
+        int framebufferWidth, framebufferHeight;
+        glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+        graph.setOutputSize(framebufferWidth, framebufferHeight);
+        graph.execute();
+
+        std::cout << "bloom: " << (postSettings.bloom ? "on" : "off") << "| radius: " << bloomSettings.radius << "| grading: " << (postSettings.colorGrading ? "on" : "off")
+                  << "| exposure: " << postSettings.exposure << std::endl;
 
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
         // -------------------------------------------------------------------------------
@@ -378,7 +331,7 @@ void renderCube()
         glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
         glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
         // link vertex attributes
-        glBindVertexArray(cubeVAO);
+        glState().bindVertexArray(cubeVAO);
         glEnableVertexAttribArray(0);
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
         glEnableVertexAttribArray(1);
@@ -386,43 +339,12 @@ void renderCube()
         glEnableVertexAttribArray(2);
         glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
         glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glBindVertexArray(0);
+        glState().bindVertexArray(0);
     }
     // render Cube
-    glBindVertexArray(cubeVAO);
+    glState().bindVertexArray(cubeVAO);
     glDrawArrays(GL_TRIANGLES, 0, 36);
-    glBindVertexArray(0);
-}
-
-// renderQuad() renders a 1x1 XY quad in NDC
-// -----------------------------------------
-unsigned int quadVAO = 0;
-unsigned int quadVBO;
-void renderQuad()
-{
-    if (quadVAO == 0)
-    {
-        float quadVertices[] = {
-            // positions        // texture Coords
-            -1.0f,  1.0f, 0.0f, 0.0f, 1.0f,
-            -1.0f, -1.0f, 0.0f, 0.0f, 0.0f,
-             1.0f,  1.0f, 0.0f, 1.0f, 1.0f,
-             1.0f, -1.0f, 0.0f, 1.0f, 0.0f,
-        };
-        // setup plane VAO
-        glGenVertexArrays(1, &quadVAO);
-        glGenBuffers(1, &quadVBO);
-        glBindVertexArray(quadVAO);
-        glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
-    }
-    glBindVertexArray(quadVAO);
-    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-    glBindVertexArray(0);
+    glState().bindVertexArray(0);
 }
 
 // process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
@@ -443,7 +365,7 @@ void processInput(GLFWwindow* window)
 
     if (glfwGetKey(window, GLFW_KEY_B) == GLFW_PRESS && !bloomKeyPressed) 
     {
-        bloom = !bloom;
+        postSettings.bloom = !postSettings.bloom;
         bloomKeyPressed = true;
     }
     if (glfwGetKey(window, GLFW_KEY_B) == GLFW_RELEASE) 
@@ -451,14 +373,19 @@ void processInput(GLFWwindow* window)
         bloomKeyPressed = false;
     }
 
-    if (glfwGetKey(window, GLFW_KEY_G) == GLFW_PRESS && !gammaKeyPressed) 
+    if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS)
+        bloomSettings.radius = std::max(0.25f, bloomSettings.radius - deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS)
+        bloomSettings.radius = std::min(4.0f, bloomSettings.radius + deltaTime);
+
+    if (glfwGetKey(window, GLFW_KEY_G) == GLFW_PRESS && !gradingKeyPressed) 
     {
-        gamma = !gamma;
-        gammaKeyPressed = true;
+        postSettings.colorGrading = !postSettings.colorGrading;
+        gradingKeyPressed = true;
     }
     if (glfwGetKey(window, GLFW_KEY_G) == GLFW_RELEASE) 
     {
-        gammaKeyPressed = false;
+        gradingKeyPressed = false;
     }
 }
 
@@ -468,7 +395,7 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
     // make sure the viewport matches the new window dimensions; note that width and 
     // height will be significantly larger than specified on retina displays.
-    glViewport(0, 0, width, height);
+    glState().viewport(0, 0, width, height);
 }
 
 
@@ -500,45 +427,3 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
 {
     camera.ProcessMouseScroll(static_cast<float>(yoffset));
 }
-
-unsigned int loadCubemap(std::vector<std::string> faces_paths) {
-    unsigned int cubemap;
-    glGenTextures(1, &cubemap);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap);
-
-    int width, height, channels;
-    for (size_t i = 0; i < faces_paths.size(); ++i) {
-        unsigned char* data = stbi_load(faces_paths[i].c_str(), &width, &height, &channels, NULL);
-
-        if (data) {
-            unsigned int internalFormat;
-            switch(channels) {
-                case 1:
-                    internalFormat = GL_RED;
-                    break;
-                case 3:
-                    internalFormat = GL_RGB;
-                    break;
-                default:
-                    internalFormat = GL_RGBA;
-            }
-
-            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, internalFormat, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-            stbi_image_free(data);
-        }
-        else {
-            std::cout << "Failed to load the cubemap face: " << faces_paths[i] << std::endl;
-            stbi_image_free(data);
-        }
-    }
-
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-
-    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
-
-    return cubemap;
-}
\ No newline at end of file
@@ -0,0 +1,455 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "shader.h"
+#include "camera.h"
+#include "stb_image.h"
+#include "model_loading/mesh.h"
+#include "utils.h"
+#include "rendering/gbuffer.h"
+#include "rendering/gl_state.h"
+#include "rendering/light_buffer.h"
+#include "rendering/light_clusters.h"
+#include "rendering/light_volumes.h"
+#include "rendering/uniform_blocks.h"
+#include "post/fullscreen_triangle.h"
+#include "profiling/profiler.h"
+#include "shading/permutations.h"
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void mouse_callback(GLFWwindow* window, double xpos, double ypos);
+void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
+void processInput(GLFWwindow* window);
+unsigned int solidTexture(const glm::vec4& color);
+Mesh cubeMesh(const std::vector<Texture>& textures, float uvScale);
+double gpuAverage(const std::string& name);
+
+// settings
+const unsigned int SCR_WIDTH = 1280;
+const unsigned int SCR_HEIGHT = 720;
+const unsigned int NR_LIGHTS = 128;
+// frames between two timing reports
+const unsigned int REPORT_FRAMES = 60;
+// C switches between the classic and the compact G-buffer layout, V between the clustered full
+// screen lighting pass and light volumes
+bool compactLayout = false;
+bool compactKeyPressed = false;
+bool lightVolumes = false;
+bool lightVolumesKeyPressed = false;
+
+// camera
+Camera camera(glm::vec3(0.f, 5.f, 12.f), glm::vec3(0.f, 1.f, 0.f), -90.f, -25.f);
+float lastX = SCR_WIDTH / 2.f;
+float lastY = SCR_HEIGHT / 2.f;
+bool firstMouse = true;
+
+// timing
+float deltaTime = 0.f;
+float lastFrame = 0.f;
+
+int main()
+{
+    // glfw: initialize and configure
+    // ------------------------------
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+#ifdef __APPLE__
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+
+    // glfw window creation
+    // --------------------
+    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL", NULL, NULL);
+    if (window == NULL)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    glfwSetCursorPosCallback(window, mouse_callback);
+    glfwSetScrollCallback(window, scroll_callback);
+
+    // tell GLFW to capture our mouse
+    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+    // glad: load all OpenGL function pointers
+    // ---------------------------------------
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+
+    // load textures
+    // -------------
+    std::string directory = "resources/textures";
+    std::vector<Texture> floorTextures = {
+        { textureFromFile("brickwall.jpg", directory), "texture_diffuse", "brickwall.jpg" },
+        { solidTexture(glm::vec4(0.2f)), "texture_specular", "" },
+        { textureFromFile("brickwall_normal.jpg", directory), "texture_normal", "brickwall_normal.jpg" },
+    };
+    std::vector<Texture> crateTextures = {
+        { textureFromFile("wood_container.png", directory), "texture_diffuse", "wood_container.png" },
+        { textureFromFile("wood_container_specular.png", directory), "texture_specular", "wood_container_specular.png" },
+        // flat, the normal map of a face pointing straight out
+        { solidTexture(glm::vec4(0.5f, 0.5f, 1.0f, 1.0f)), "texture_normal", "" },
+    };
+    Mesh floorMesh = cubeMesh(floorTextures, 6.0f);
+    Mesh crateMesh = cubeMesh(crateTextures, 1.0f);
+
+    // scene: a floor and a grid of crates, each with a model matrix
+    // -------------------------------------------------------------
+    std::vector<glm::mat4> crateModels;
+    for (int z = -2; z <= 2; ++z)
+    {
+        for (int x = -2; x <= 2; ++x)
+        {
+            glm::mat4 model = glm::mat4(1.0f);
+            model = glm::translate(model, glm::vec3(x * 3.0f, 0.5f, z * 3.0f));
+            model = glm::rotate(model, glm::radians(17.0f * (x + 2 * z)), glm::vec3(0.0f, 1.0f, 0.0f));
+            model = glm::scale(model, glm::vec3(0.5f));
+            crateModels.push_back(model);
+        }
+    }
+    glm::mat4 floorModel = glm::scale(glm::mat4(1.0f), glm::vec3(10.0f, 0.1f, 10.0f));
+    floorModel = glm::translate(floorModel, glm::vec3(0.0f, -1.0f, 0.0f));
+
+    // lighting info
+    // -------------
+    // small colored lights scattered over the floor, each bounded by the radius its falloff gives
+    LightBuffer lightBuffer(LIGHTS_BINDING, NR_LIGHTS + 1);
+    srand(13);
+    for (unsigned int i = 0; i < NR_LIGHTS; i++)
+    {
+        float xPos = static_cast<float>(((rand() % 100) / 100.0) * 18.0 - 9.0);
+        float yPos = static_cast<float>(((rand() % 100) / 100.0) * 1.5 + 0.25);
+        float zPos = static_cast<float>(((rand() % 100) / 100.0) * 18.0 - 9.0);
+        float rColor = static_cast<float>(((rand() % 100) / 200.0f) + 0.5);
+        float gColor = static_cast<float>(((rand() % 100) / 200.0f) + 0.5);
+        float bColor = static_cast<float>(((rand() % 100) / 200.0f) + 0.5);
+        lightBuffer.add(attenuatedLight(glm::vec3(xPos, yPos, zPos), glm::vec3(rColor, gColor, bColor), 0.7f, 1.8f));
+    }
+    // and a dim fill light high above without falloff, so without a radius (unbounded)
+    lightBuffer.add(attenuatedLight(glm::vec3(-20.0f, 30.0f, 10.0f), glm::vec3(0.15f, 0.15f, 0.2f), 0.0f, 0.0f));
+    lightBuffer.upload();
+
+    UniformBuffer<CameraBlock> cameraBuffer(CAMERA_BINDING);
+    // the full screen lighting pass only loops over the lights of each pixel's cluster
+    LightClusters lightClusters(CLUSTERS_BINDING, CLUSTER_LIGHTS_BINDING);
+    float clusterZoom = 0.0f;
+    int clusterWidth = 0;
+    int clusterHeight = 0;
+
+    // with light volumes the full screen pass only adds the ambient term
+    LightVolumes volumes;
+
+    // one G-buffer per layout, the geometry and lighting programs of each are permutations of the same
+    // sources selected by GBuffer::defines()
+    // ------------------------------------------------------------------------------------------------
+    int scrWidth, scrHeight;
+    glfwGetFramebufferSize(window, &scrWidth, &scrHeight);
+    GBuffer classicGBuffer(GBufferLayout::CLASSIC, scrWidth, scrHeight);
+    GBuffer compactGBuffer(GBufferLayout::COMPACT, scrWidth, scrHeight);
+    ShaderLibrary shaders;
+    for (GBuffer* gbuffer : { &classicGBuffer, &compactGBuffer })
+    {
+        shaders.get("shaders/geometry_pass.vs", "shaders/geometry_pass.fs", gbuffer->defines());
+        Shader* lightingShaders[] = {
+            &shaders.get("shaders/fullscreen.vs", "shaders/lighting_pass.fs", gbuffer->defines()),
+            &shaders.get("shaders/fullscreen.vs", "shaders/lighting_pass.fs", gbuffer->defines().set("LIGHT_VOLUMES")),
+            &shaders.get("shaders/light_volume.vs", "shaders/light_volume.fs", gbuffer->defines()),
+            &shaders.get("shaders/light_volume.vs", "shaders/light_volume.fs", gbuffer->defines().set("UNBOUNDED_LIGHT")),
+        };
+        for (Shader* lightingShader : lightingShaders)
+        {
+            lightingShader->use();
+            gbuffer->setSamplers(*lightingShader);
+        }
+    }
+    reportGBufferBandwidth(scrWidth, scrHeight);
+
+    // setup above bound textures and vertex arrays directly, from here on everything goes through the
+    // state cache
+    glState().invalidate();
+
+    // render loop
+    // -----------
+    unsigned int frame = 0;
+    while (!glfwWindowShouldClose(window))
+    {
+        // per-frame time logic
+        // --------------------
+        float currentFrame = static_cast<float>(glfwGetTime());
+        deltaTime = currentFrame - lastFrame;
+        lastFrame = currentFrame;
+        profiler().beginFrame();
+
+        // input
+        // -----
+        processInput(window);
+
+        glfwGetFramebufferSize(window, &scrWidth, &scrHeight);
+        if (scrWidth == 0 || scrHeight == 0)
+        {
+            glfwPollEvents();
+            continue;
+        }
+        GBuffer& gbuffer = compactLayout ? compactGBuffer : classicGBuffer;
+        gbuffer.resize(scrWidth, scrHeight);
+        const char* layoutName = gbufferLayoutName(gbuffer.layout());
+
+        // per-frame camera data and light clusters
+        // ----------------------------------------
+        CameraBlock cameraBlock;
+        cameraBlock.projection = glm::perspective(glm::radians(camera.Zoom), (float)scrWidth / (float)scrHeight, 0.1f, 100.0f);
+        cameraBlock.view = camera.GetViewMatrix();
+        cameraBlock.viewProjection = cameraBlock.projection * cameraBlock.view;
+        cameraBlock.inverseViewProjection = glm::inverse(cameraBlock.viewProjection);
+        cameraBlock.position = camera.Position;
+        cameraBlock.time = currentFrame;
+        cameraBuffer.update(cameraBlock);
+        if (camera.Zoom != clusterZoom || scrWidth != clusterWidth || scrHeight != clusterHeight)
+        {
+            clusterZoom = camera.Zoom;
+            clusterWidth = scrWidth;
+            clusterHeight = scrHeight;
+            lightClusters.setProjection(glm::radians(camera.Zoom), (float)scrWidth / (float)scrHeight, 0.1f, 100.0f, scrWidth, scrHeight);
+        }
+        lightClusters.update(cameraBlock.view, lightBuffer.lights());
+
+        // 1. geometry pass: render scene's geometry/color data into the G-buffer
+        // ----------------------------------------------------------------------
+        {
+            PROFILE_GPU(compactLayout ? "geometry (compact)" : "geometry (classic)");
+            gbuffer.bind();
+            glState().viewport(0, 0, scrWidth, scrHeight);
+            glState().enable(GL_DEPTH_TEST);
+            // no albedo and no specular where nothing is drawn: the cleared compact normal decodes to a
+            // valid direction, and unbounded lights reach those pixels too
+            glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            Shader& geometryShader = shaders.get("shaders/geometry_pass.vs", "shaders/geometry_pass.fs", gbuffer.defines());
+            geometryShader.use();
+            geometryShader.setMat4("projection", cameraBlock.projection);
+            geometryShader.setMat4("view", cameraBlock.view);
+            geometryShader.setMat4("model", floorModel);
+            floorMesh.Draw(geometryShader);
+            for (const glm::mat4& model : crateModels)
+            {
+                geometryShader.setMat4("model", model);
+                crateMesh.Draw(geometryShader);
+            }
+        }
+
+        // 2. lighting pass: calculate lighting by iterating over a screen filling triangle pixel-by-pixel
+        // using the G-buffer's content, or only the ambient term there and each light over the pixels
+        // its volume covers
+        // -------------------------------------------------------------------------------------------
+        if (!lightVolumes)
+        {
+            PROFILE_GPU(compactLayout ? "lighting (compact)" : "lighting (classic)");
+            glState().bindFramebuffer(GL_FRAMEBUFFER, 0);
+            glState().disable(GL_DEPTH_TEST);
+            Shader& lightingShader = shaders.get("shaders/fullscreen.vs", "shaders/lighting_pass.fs", gbuffer.defines());
+            lightingShader.use();
+            gbuffer.bindTextures();
+            fullscreenTriangle().draw();
+        }
+        else
+        {
+            PROFILE_GPU(compactLayout ? "light volumes (compact)" : "light volumes (classic)");
+            glState().bindFramebuffer(GL_FRAMEBUFFER, 0);
+            glState().disable(GL_DEPTH_TEST);
+            Shader& ambientShader = shaders.get("shaders/fullscreen.vs", "shaders/lighting_pass.fs", gbuffer.defines().set("LIGHT_VOLUMES"));
+            ambientShader.use();
+            gbuffer.bindTextures();
+            fullscreenTriangle().draw();
+            volumes.render(shaders.get("shaders/light_volume.vs", "shaders/light_volume.fs", gbuffer.defines()),
+                shaders.get("shaders/light_volume.vs", "shaders/light_volume.fs", gbuffer.defines().set("UNBOUNDED_LIGHT")),
+                gbuffer, lightBuffer.lights());
+        }
+
+        // GPU times are averaged over the frames, each layout and lighting method keeps its own numbers
+        if (++frame % REPORT_FRAMES == 0)
+        {
+            std::cout << std::fixed << std::setprecision(3) << lightBuffer.size() << " lights, " << layoutName << " G-buffer, "
+                      << (lightVolumes ? "light volumes" : "full screen lighting");
+            for (const char* layout : { "classic", "compact" })
+            {
+                double geometry = gpuAverage(std::string("geometry (") + layout + ")");
+                double lighting = gpuAverage(std::string("lighting (") + layout + ")");
+                double volumeLighting = gpuAverage(std::string("light volumes (") + layout + ")");
+                if (geometry > 0.0)
+                    std::cout << "| " << layout << ": geometry " << geometry << " ms, full screen lighting " << lighting
+                              << " ms, light volumes " << volumeLighting << " ms";
+            }
+            std::cout << std::endl;
+        }
+
+        // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
+        // -------------------------------------------------------------------------------
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+    }
+
+    // glfw: terminate, clearing all previously allocated GLFW resources.
+    // ------------------------------------------------------------------
+    glfwTerminate();
+    return 0;
+}
+
+// average GPU time of a profiler scope in ms, 0 if it never ran
+// ---------------------------------------------------------------
+double gpuAverage(const std::string& name)
+{
+    for (const Profiler::Stat& stat : profiler().stats())
+    {
+        if (stat.gpu && name == stat.name)
+            return stat.average;
+    }
+    return 0.0;
+}
+
+// 1x1 texture of a single color, for materials without a map of that kind
+// ------------------------------------------------------------------------
+unsigned int solidTexture(const glm::vec4& color)
+{
+    unsigned char texel[4];
+    for (int i = 0; i < 4; ++i)
+        texel[i] = static_cast<unsigned char>(glm::clamp(color[i], 0.0f, 1.0f) * 255.0f + 0.5f);
+    unsigned int texture;
+    glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+    glTextureStorage2D(texture, 1, GL_RGBA8, 1, 1);
+    glTextureSubImage2D(texture, 0, 0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, texel);
+    return texture;
+}
+
+// cubeMesh() builds a 2x2x2 cube centered on the origin with the tangents the geometry pass needs
+// for normal mapping, every face repeats the textures uvScale times
+// -----------------------------------------------------------------------------------------------
+Mesh cubeMesh(const std::vector<Texture>& textures, float uvScale)
+{
+    // normal and tangent of each face, the bitangent is their cross product
+    const glm::vec3 faces[6][2] = {
+        { glm::vec3( 0.0f,  0.0f,  1.0f), glm::vec3( 1.0f, 0.0f,  0.0f) },
+        { glm::vec3( 0.0f,  0.0f, -1.0f), glm::vec3(-1.0f, 0.0f,  0.0f) },
+        { glm::vec3( 1.0f,  0.0f,  0.0f), glm::vec3( 0.0f, 0.0f, -1.0f) },
+        { glm::vec3(-1.0f,  0.0f,  0.0f), glm::vec3( 0.0f, 0.0f,  1.0f) },
+        { glm::vec3( 0.0f,  1.0f,  0.0f), glm::vec3( 1.0f, 0.0f,  0.0f) },
+        { glm::vec3( 0.0f, -1.0f,  0.0f), glm::vec3( 1.0f, 0.0f,  0.0f) },
+    };
+    const glm::vec2 corners[4] = { glm::vec2(0.0f, 0.0f), glm::vec2(1.0f, 0.0f), glm::vec2(1.0f, 1.0f), glm::vec2(0.0f, 1.0f) };
+
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+    for (const glm::vec3* face : faces)
+    {
+        glm::vec3 normal = face[0];
+        glm::vec3 tangent = face[1];
+        glm::vec3 bitangent = glm::cross(normal, tangent);
+        unsigned int first = static_cast<unsigned int>(vertices.size());
+        for (const glm::vec2& corner : corners)
+        {
+            Vertex vertex;
+            vertex.position = normal + (corner.x * 2.0f - 1.0f) * tangent + (corner.y * 2.0f - 1.0f) * bitangent;
+            vertex.normal = normal;
+            vertex.texCoords = corner * uvScale;
+            vertex.tangent = tangent;
+            vertices.push_back(vertex);
+        }
+        // counter-clockwise seen from outside
+        indices.insert(indices.end(), { first, first + 1, first + 2, first + 2, first + 3, first });
+    }
+    return Mesh(vertices, indices, textures);
+}
+
+// process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
+// ---------------------------------------------------------------------------------------------------------
+void processInput(GLFWwindow* window)
+{
+    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+        glfwSetWindowShouldClose(window, true);
+
+    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+        camera.ProcessKeyboard(FORWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+        camera.ProcessKeyboard(BACKWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+        camera.ProcessKeyboard(LEFT, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+        camera.ProcessKeyboard(RIGHT, deltaTime);
+
+    if (glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS && !compactKeyPressed)
+    {
+        compactLayout = !compactLayout;
+        compactKeyPressed = true;
+    }
+    if (glfwGetKey(window, GLFW_KEY_C) == GLFW_RELEASE)
+    {
+        compactKeyPressed = false;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_V) == GLFW_PRESS && !lightVolumesKeyPressed)
+    {
+        lightVolumes = !lightVolumes;
+        lightVolumesKeyPressed = true;
+    }
+    if (glfwGetKey(window, GLFW_KEY_V) == GLFW_RELEASE)
+    {
+        lightVolumesKeyPressed = false;
+    }
+}
+
+// glfw: whenever the window size changed (by OS or user resize) this callback function executes
+// ---------------------------------------------------------------------------------------------
+void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+    // make sure the viewport matches the new window dimensions; note that width and 
+    // height will be significantly larger than specified on retina displays.
+    glState().viewport(0, 0, width, height);
+}
+
+
+// glfw: whenever the mouse moves, this callback is called
+// -------------------------------------------------------
+void mouse_callback(GLFWwindow* window, double xposIn, double yposIn)
+{
+    float xpos = static_cast<float>(xposIn);
+    float ypos = static_cast<float>(yposIn);
+    if (firstMouse)
+    {
+        lastX = xpos;
+        lastY = ypos;
+        firstMouse = false;
+    }
+
+    float xoffset = xpos - lastX;
+    float yoffset = lastY - ypos; // reversed since y-coordinates go from bottom to top
+
+    lastX = xpos;
+    lastY = ypos;
+
+    camera.ProcessMouseMovement(xoffset, yoffset);
+}
+
+// glfw: whenever the mouse scroll wheel scrolls, this callback is called
+// ----------------------------------------------------------------------
+void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
+{
+    camera.ProcessMouseScroll(static_cast<float>(yoffset));
+}
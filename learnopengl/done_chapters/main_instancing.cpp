@@ -11,15 +11,24 @@
 #include "stb_image.h"
 #include "model_loading/model.h"
 #include "utils.h"
+#include "culling/frustum.h"
+#include "culling/gpu_culling.h"
+#include "culling/cpu_culling.h"
+#include "culling/occlusion_buffer.h"
+#include "rendering/parallel_recorder.h"
+#include "rendering/gl_command_replay.h"
+#include "bench/gpu_culling_bench.h"
+#include "bench/cpu_culling_bench.h"
+#include "bench/occlusion_bench.h"
 
 #include <iostream>
+#include <string>
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void processInput(GLFWwindow* window);
 unsigned int loadTexture(const char* path);
-unsigned int loadCubemap(std::vector<std::string> faces_paths);
 
 // settings
 const unsigned int SCR_WIDTH = 1024;
@@ -35,8 +44,55 @@ bool firstMouse = true;
 float deltaTime = 0.f;
 float lastFrame = 0.f;
 
-int main()
+// asteroids are culled and LOD selected by a compute shader and drawn indirectly, G switches to
+// culling on the CPU and recording the draws on the thread pool, M then to recording on the main thread.
+// C culls on the CPU over a grid with SIMD tests and draws indirectly from the written indices,
+// O toggles skipping the grid cells hidden behind the planet there
+bool gpuCulling = true;
+bool gpuCullingKeyPressed = false;
+bool gridCulling = false;
+bool gridCullingKeyPressed = false;
+bool occlusionCulling = true;
+bool occlusionCullingKeyPressed = false;
+bool threadedRecording = true;
+bool threadedRecordingKeyPressed = false;
+
+int main(int argc, char** argv)
 {
+    // --bench-culling: GPU culling at 100k, 1M and 5M asteroids in a hidden window, then exit.
+    // --bench-cpu-culling, --bench-occlusion: the CPU culling paths without a window.
+    // --bench-frames N sets the measured frames, --bench-no-draw only culls
+    bool benchCulling = false;
+    bool benchCpuCulling = false;
+    bool benchOcclusion = false;
+    bool benchDraw = true;
+    int benchFrames = 20;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--bench-culling")
+            benchCulling = true;
+        else if (arg == "--bench-cpu-culling")
+            benchCpuCulling = true;
+        else if (arg == "--bench-occlusion")
+            benchOcclusion = true;
+        else if (arg == "--bench-no-draw")
+            benchDraw = false;
+        else if (arg == "--bench-frames" && i + 1 < argc)
+            benchFrames = std::max(1, std::atoi(argv[++i]));
+    }
+    if (benchCpuCulling)
+    {
+        benchmarkCpuCulling(benchFrames);
+        return 0;
+    }
+    if (benchOcclusion)
+    {
+        benchmarkOcclusionCulling(benchFrames);
+        return 0;
+    }
+
+
     // glfw: initialize and configure
     // ------------------------------
     glfwInit();
@@ -47,6 +103,8 @@ int main()
 #ifdef __APPLE__
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
+    if (benchCulling)
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
 
     // glfw window creation
     // --------------------
@@ -83,6 +141,8 @@ int main()
     Shader screenShader("shaders/screen_shader.vs", "shaders/screen_shader.fs");
     Shader skyboxShader("shaders/cubemap.vs", "shaders/cubemap.fs");
     Shader instanceShader("shaders/instance.vs", "shaders/instance.fs");
+    Shader indirectInstanceShader("shaders/instance_indirect.vs", "shaders/instance.fs");
+    Shader cullShader("shaders/cull_instances.comp");
  
     float cubeVertices[] = {
         // Back face
@@ -264,35 +324,10 @@ int main()
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
     unsigned int amount = 100000;
-    glm::mat4* modelMatrices;
-    modelMatrices = new glm::mat4[amount];
+    std::vector<glm::mat4> modelMatrices;
+    std::vector<float> asteroidScales;
     srand(static_cast<unsigned int>(glfwGetTime())); // initialize random seed
-    float radius = 150.0;
-    float offset = 25.0f;
-    for (unsigned int i = 0; i < amount; i++)
-    {
-        glm::mat4 model = glm::mat4(1.0f);
-        // 1. translation: displace along circle with 'radius' in range [-offset, offset]
-        float angle = (float)i / (float)amount * 360.0f;
-        float displacement = (rand() % (int)(2 * offset * 100)) / 100.0f - offset;
-        float x = sin(angle) * radius + displacement;
-        displacement = (rand() % (int)(2 * offset * 100)) / 100.0f - offset;
-        float y = displacement * 0.4f; // keep height of asteroid field smaller compared to width of x and z
-        displacement = (rand() % (int)(2 * offset * 100)) / 100.0f - offset;
-        float z = cos(angle) * radius + displacement;
-        model = glm::translate(model, glm::vec3(x, y, z));
-
-        // 2. scale: Scale between 0.05 and 0.25f
-        float scale = static_cast<float>((rand() % 20) / 100.0 + 0.05);
-        model = glm::scale(model, glm::vec3(scale));
-
-        // 3. rotation: add random rotation around a (semi)randomly picked rotation axis vector
-        float rotAngle = static_cast<float>((rand() % 360));
-        model = glm::rotate(model, rotAngle, glm::vec3(0.4f, 0.6f, 0.8f));
-
-        // 4. now add to list of matrices
-        modelMatrices[i] = model;
-    }
+    generateAsteroidField(amount, modelMatrices, asteroidScales);
 
     std::vector<std::string> faces = {
         "resources/textures/skybox/right.jpg",
@@ -311,41 +346,79 @@ int main()
     Model rock = Model("resources/models/rock/rock.obj");
     stbi_set_flip_vertically_on_load(false);
 
-    // configure instanced array
-    // -------------------------
-    unsigned int buffer;
-    glGenBuffers(1, &buffer);
-    glBindBuffer(GL_ARRAY_BUFFER, buffer);
-    glBufferData(GL_ARRAY_BUFFER, amount * sizeof(glm::mat4), &modelMatrices[0], GL_STATIC_DRAW);
+    if (benchCulling)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glState().invalidate();
+        benchmarkGpuCulling(rock.meshes(), cullShader, indirectInstanceShader, (float)SCR_WIDTH / (float)SCR_HEIGHT, benchFrames, benchDraw);
+        glfwTerminate();
+        return 0;
+    }
 
+    // GPU path: the matrices are uploaded once, every frame a compute pass culls them, picks one
+    // of three LODs and writes the indirect draw commands
+    // ---------------------------------------------------------------------------------------
+    GpuInstanceCuller gpuCuller(cullShader, modelMatrices.data(), amount);
+    for (Mesh& mesh : rock.meshes())
+        gpuCuller.addMesh(mesh);
+
+    // CPU path: the visible asteroids' matrices are recorded every frame by worker threads into
+    // per thread command buffers; the replay streams them into one instance buffer the rock VAOs
+    // read from. worst case every asteroid is visible, all their matrices go through the dynamic
+    // buffer
+    // ---------------------------------------------------------------------------------------
+    dynamicBuffers().setSegmentSize(amount * sizeof(glm::mat4) + 64 * 1024);
+    ParallelRecorder asteroidRecorder;
+    GLCommandReplay commandReplay;
+    CommandBuffer asteroidSetup;
+    std::vector<CommandMesh> rockMeshes;
+    float rockRadius = 0.0f;
     for (unsigned int i = 0; i < rock.meshes().size(); i++)
     {
-        unsigned int VAO = rock.meshes()[i].VAO;
-        glBindVertexArray(VAO);
+        Mesh& mesh = rock.meshes()[i];
         // set attribute pointers for matrix (4 times vec4)
-        glEnableVertexAttribArray(3);
-        glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)0);
-        glEnableVertexAttribArray(4);
-        glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(sizeof(glm::vec4)));
-        glEnableVertexAttribArray(5);
-        glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(2 * sizeof(glm::vec4)));
-        glEnableVertexAttribArray(6);
-        glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(3 * sizeof(glm::vec4)));
-
-        glVertexAttribDivisor(3, 1);
-        glVertexAttribDivisor(4, 1);
-        glVertexAttribDivisor(5, 1);
-        glVertexAttribDivisor(6, 1);
-
-        glBindVertexArray(0);
+        commandReplay.attachInstanceAttributes(mesh.VAO, 3);
+
+        CommandMesh commandMesh;
+        commandMesh.vertexArray = mesh.VAO;
+        commandMesh.mode = GL_TRIANGLES;
+        commandMesh.count = static_cast<uint32_t>(mesh.Indices().size());
+        commandMesh.indexType = GL_UNSIGNED_INT;
+        rockMeshes.push_back(commandMesh);
+
+        // bounding sphere around the model origin, scaled per asteroid
+        for (const Vertex& vertex : mesh.Vertices())
+            rockRadius = std::max(rockRadius, glm::length(vertex.position));
     }
 
+    // CPU grid path: the asteroids are bucketed into a grid once, every frame the thread pool culls
+    // whole cells and tests the rest of the spheres with SIMD, writing the visible indices straight
+    // into the dynamic buffer the indirect draws read them from, the segment size above covers them
+    // ---------------------------------------------------------------------------------------
+    CpuInstanceCuller cpuCuller(modelMatrices.data(), amount);
+    for (Mesh& mesh : rock.meshes())
+        cpuCuller.addMesh(mesh);
+
+    // the planet is the only large occluder: rasterized into a small software depth buffer every
+    // frame, grid cells behind it are skipped before their instances are tested
+    OcclusionBuffer occlusionBuffer(256, 192);
+    glm::mat4 planetModel = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -3.0f, 0.0f)), glm::vec3(4.f, 4.f, 4.f));
+
     screenShader.use();
     screenShader.setInt("Texture", 0);
 
     skyboxShader.use();
     skyboxShader.setInt("skybox", 0);
 
+    instanceShader.use();
+    instanceShader.setInt("texture_diffuse1", 0);
+    UniformLocation instanceProjection = instanceShader.uniform("projection");
+    UniformLocation instanceView = instanceShader.uniform("view");
+
+    // setup above bound objects directly, the render loop goes through the state cache
+    glState().invalidate();
+    float titleTime = 0.f;
+
     // render loop
     // -----------
     while (!glfwWindowShouldClose(window))
@@ -355,74 +428,144 @@ int main()
         float currentFrame = static_cast<float>(glfwGetTime());
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
+        dynamicBuffers().beginFrame();
 
         // input
         // -----
         processInput(window);
 
-        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glState().bindFramebuffer(GL_FRAMEBUFFER, fbo);
 
         // render
         // ------
         glClearColor(0.05f, 0.05f, 0.05f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
-        glEnable(GL_DEPTH_TEST);
-        glDepthFunc(GL_LESS);
+        glState().enable(GL_DEPTH_TEST);
+        glState().depthFunc(GL_LESS);
 
         // don't forget to enable shader before setting uniforms
         framebufferShader.use();
 
-        glm::mat4 model = glm::mat4(1.f);
         // view/projection transformations
         glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 1000.0f);
         glm::mat4 view = camera.GetViewMatrix();
         framebufferShader.setMat4("projection", projection);
         framebufferShader.setMat4("view", view);
 
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, glm::vec3(0.0f, -3.0f, 0.0f));
-        model = glm::scale(model, glm::vec3(4.f, 4.f, 4.f));
-        framebufferShader.setMat4("model", model);
+        framebufferShader.setMat4("model", planetModel);
         planet.Draw(framebufferShader);
 
-        instanceShader.use();
-        instanceShader.setMat4("projection", projection);
-        instanceShader.setMat4("view", view);
-        instanceShader.setInt("texture_diffuse1", 0);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, planet.loaded_textures()[0].id);
-        for (unsigned int i = 0; i < rock.meshes().size(); ++i) {
-            glBindVertexArray(rock.meshes()[i].VAO);
-            glDrawElementsInstanced(GL_TRIANGLES, rock.meshes()[i].Indices().size(), GL_UNSIGNED_INT, 0, amount);
-            glBindVertexArray(0);
+        // asteroids: the field slowly orbits the planet. either the compute pass culls it and the
+        // draws take their counts straight from the GPU written commands, or the grid culls it on
+        // the CPU, or workers transform the asteroids, cull them against the view frustum and
+        // record the visible ones, the GL thread only replays
+        glm::mat4 orbit = glm::rotate(glm::mat4(1.0f), currentFrame * 0.02f, glm::vec3(0.0f, 1.0f, 0.0f));
+        if (gridCulling)
+        {
+            occlusionBuffer.clear(projection * view);
+            if (occlusionCulling)
+            {
+                for (Mesh& mesh : planet.meshes())
+                    occlusionBuffer.renderOccluder(planetModel, &mesh.Vertices()[0].position, mesh.Vertices().size(), sizeof(Vertex), mesh.Indices().data(), mesh.Indices().size());
+            }
+            cpuCuller.cull(projection * view, orbit, &threadPool(), occlusionCulling ? &occlusionBuffer : nullptr);
+            indirectInstanceShader.use();
+            indirectInstanceShader.setMat4("projection", projection);
+            indirectInstanceShader.setMat4("view", view);
+            indirectInstanceShader.setMat4("transform", orbit);
+            glState().bindTexture(0, planet.loaded_textures()[0].id);
+            cpuCuller.draw();
+        }
+        else if (gpuCulling)
+        {
+            gpuCuller.cull(projection * view, camera.Position, orbit);
+            indirectInstanceShader.use();
+            indirectInstanceShader.setMat4("projection", projection);
+            indirectInstanceShader.setMat4("view", view);
+            indirectInstanceShader.setMat4("transform", orbit);
+            glState().bindTexture(0, planet.loaded_textures()[0].id);
+            gpuCuller.draw();
+        }
+        else
+        {
+            asteroidSetup.reset();
+            asteroidSetup.useProgram(instanceShader.ID);
+            asteroidSetup.setMat4(instanceProjection.value, projection);
+            asteroidSetup.setMat4(instanceView.value, view);
+            asteroidSetup.bindTexture(0, planet.loaded_textures()[0].id);
+
+            Frustum frustum(projection * view);
+            asteroidRecorder.record(amount, 4096, [&](size_t begin, size_t end, CommandBuffer& buffer)
+            {
+                glm::mat4* instances = buffer.allocateInstances(end - begin);
+                uint32_t visible = 0;
+                for (size_t i = begin; i < end; ++i)
+                {
+                    glm::mat4 asteroid = orbit * modelMatrices[i];
+                    if (frustum.intersectsSphere(glm::vec3(asteroid[3]), rockRadius * asteroidScales[i]))
+                        instances[visible++] = asteroid;
+                }
+                for (const CommandMesh& mesh : rockMeshes)
+                    buffer.drawInstanced(mesh, visible, instances);
+            }, threadedRecording ? &threadPool() : nullptr);
+
+            std::vector<const CommandBuffer*> commandBuffers(1, &asteroidSetup);
+            commandBuffers.insert(commandBuffers.end(), asteroidRecorder.buffers().begin(), asteroidRecorder.buffers().end());
+            commandReplay.replay(commandBuffers);
         }
 
         skyboxShader.use();
-        glDepthFunc(GL_LEQUAL);
-        glBindVertexArray(skyboxVAO);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, skyboxTexture);
+        glState().depthFunc(GL_LEQUAL);
+        glState().bindVertexArray(skyboxVAO);
+        glState().bindTexture(0, skyboxTexture);
         view = glm::mat4(glm::mat3(camera.GetViewMatrix()));
         skyboxShader.setMat4("projection", projection);
         skyboxShader.setMat4("view", view);
         glDrawArrays(GL_TRIANGLES, 0, 36);
 
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glState().bindFramebuffer(GL_FRAMEBUFFER, 0);
         screenShader.use();
 
         glClearColor(1.f, 1.f, 1.f, 1.f);
         glClear(GL_COLOR_BUFFER_BIT);
-        glDisable(GL_DEPTH_TEST);
-        glDisable(GL_CULL_FACE);
+        glState().disable(GL_DEPTH_TEST);
+        glState().disable(GL_CULL_FACE);
 
-        glBindVertexArray(quadVAO);
-        glBindTexture(GL_TEXTURE_2D, fbo_color_texture);
+        glState().bindVertexArray(quadVAO);
+        glState().bindTexture(0, fbo_color_texture);
         glDrawArrays(GL_TRIANGLES, 0, 6);
 
-        glBindVertexArray(0);
+        // visible asteroids and the culling cost, once a second. the GPU counts arrive a few frames late
+        if (currentFrame - titleTime > 1.f && gridCulling)
+        {
+            titleTime = currentFrame;
+            const CpuCullingStats& cullingStats = cpuCuller.stats();
+            std::string title = "LearnOpenGL - grid culling, " + std::to_string(cullingStats.visible) + " of " + std::to_string(amount) + " asteroids, "
+                + std::to_string(cullingStats.milliseconds) + " ms (" + std::to_string(threadPool().size() + 1) + " threads, " + std::to_string(cullingStats.chunks) + " chunks), "
+                + (occlusionCulling ? std::to_string(cullingStats.occludedCells) + " cells occluded" : std::string("no occlusion culling"));
+            glfwSetWindowTitle(window, title.c_str());
+        }
+        else if (currentFrame - titleTime > 1.f && gpuCulling)
+        {
+            titleTime = currentFrame;
+            const GpuCullingStats& cullingStats = gpuCuller.stats();
+            std::string title = "LearnOpenGL - GPU culling, " + std::to_string(cullingStats.total) + " of " + std::to_string(amount) + " asteroids, LOD "
+                + std::to_string(cullingStats.visible[0]) + "/" + std::to_string(cullingStats.visible[1]) + "/" + std::to_string(cullingStats.visible[2]);
+            glfwSetWindowTitle(window, title.c_str());
+        }
+        else if (currentFrame - titleTime > 1.f)
+        {
+            titleTime = currentFrame;
+            const CommandReplayStats& replayStats = commandReplay.stats();
+            std::string title = "LearnOpenGL - " + std::to_string(replayStats.instances) + " of " + std::to_string(amount) + " asteroids, record "
+                + std::to_string(asteroidRecorder.milliseconds()) + " ms (" + (threadedRecording ? std::to_string(threadPool().size() + 1) + " threads" : std::string("1 thread"))
+                + "), replay " + std::to_string(replayStats.milliseconds) + " ms, " + std::to_string(replayStats.draws) + " draws";
+            glfwSetWindowTitle(window, title.c_str());
+        }
         
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
         // -------------------------------------------------------------------------------
+        dynamicBuffers().endFrame();
         glfwSwapBuffers(window);
         glfwPollEvents();
     }
@@ -431,8 +574,6 @@ int main()
     glDeleteRenderbuffers(1, &rbo_depth_stencil);
     glDeleteFramebuffers(1, &fbo);
 
-    delete[] modelMatrices;
-
     // glfw: terminate, clearing all previously allocated GLFW resources.
     // ------------------------------------------------------------------
     glfwTerminate();
@@ -454,6 +595,38 @@ void processInput(GLFWwindow* window)
         camera.ProcessKeyboard(LEFT, deltaTime);
     if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
         camera.ProcessKeyboard(RIGHT, deltaTime);
+
+    if (glfwGetKey(window, GLFW_KEY_G) == GLFW_PRESS && !gpuCullingKeyPressed)
+    {
+        gpuCulling = !gpuCulling;
+        gpuCullingKeyPressed = true;
+    }
+    if (glfwGetKey(window, GLFW_KEY_G) == GLFW_RELEASE)
+        gpuCullingKeyPressed = false;
+
+    if (glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS && !gridCullingKeyPressed)
+    {
+        gridCulling = !gridCulling;
+        gridCullingKeyPressed = true;
+    }
+    if (glfwGetKey(window, GLFW_KEY_C) == GLFW_RELEASE)
+        gridCullingKeyPressed = false;
+
+    if (glfwGetKey(window, GLFW_KEY_O) == GLFW_PRESS && !occlusionCullingKeyPressed)
+    {
+        occlusionCulling = !occlusionCulling;
+        occlusionCullingKeyPressed = true;
+    }
+    if (glfwGetKey(window, GLFW_KEY_O) == GLFW_RELEASE)
+        occlusionCullingKeyPressed = false;
+
+    if (glfwGetKey(window, GLFW_KEY_M) == GLFW_PRESS && !threadedRecordingKeyPressed)
+    {
+        threadedRecording = !threadedRecording;
+        threadedRecordingKeyPressed = true;
+    }
+    if (glfwGetKey(window, GLFW_KEY_M) == GLFW_RELEASE)
+        threadedRecordingKeyPressed = false;
 }
 
 // glfw: whenever the window size changed (by OS or user resize) this callback function executes
@@ -462,7 +635,7 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
     // make sure the viewport matches the new window dimensions; note that width and 
     // height will be significantly larger than specified on retina displays.
-    glViewport(0, 0, width, height);
+    glState().viewport(0, 0, width, height);
 }
 
 
@@ -494,45 +667,3 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
 {
     camera.ProcessMouseScroll(static_cast<float>(yoffset));
 }
-
-unsigned int loadCubemap(std::vector<std::string> faces_paths) {
-    unsigned int cubemap;
-    glGenTextures(1, &cubemap);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap);
-
-    int width, height, channels;
-    for (size_t i = 0; i < faces_paths.size(); ++i) {
-        unsigned char* data = stbi_load(faces_paths[i].c_str(), &width, &height, &channels, NULL);
-
-        if (data) {
-            unsigned int internalFormat;
-            switch(channels) {
-                case 1:
-                    internalFormat = GL_RED;
-                    break;
-                case 3:
-                    internalFormat = GL_RGB;
-                    break;
-                default:
-                    internalFormat = GL_RGBA;
-            }
-
-            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, internalFormat, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-            stbi_image_free(data);
-        }
-        else {
-            std::cout << "Failed to load the cubemap face: " << faces_paths[i] << std::endl;
-            stbi_image_free(data);
-        }
-    }
-
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-
-    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
-
-    return cubemap;
-}
\ No newline at end of file
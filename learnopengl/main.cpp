@@ -13,7 +13,23 @@
 #include "utils.h"
 #include "debug/utils.h"
 #include "text/utils.h"
-
+#include "shading/permutations.h"
+#include "shading/shader_watcher.h"
+#include "rendering/uniform_blocks.h"
+#include "rendering/light_buffer.h"
+#include "rendering/light_clusters.h"
+#include "bench/cluster_bench.h"
+#include "bench/frame_bench.h"
+#include "bench/queue_bench.h"
+#include "rendering/gbuffer.h"
+#include "rendering/render_queue.h"
+#include "rendering/dynamic_buffer.h"
+#include "post/color_lut.h"
+#include "profiling/profiler.h"
+#include "simulation/update_thread.h"
+
+#include <chrono>
+#include <cstddef>
 #include <iostream>
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
@@ -21,32 +37,66 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void processInput(GLFWwindow* window);
 unsigned int loadTexture(const char* path);
-unsigned int loadCubemap(std::vector<std::string> faces_paths);
 void renderQuad();
 void renderCube();
-void renderSphere();
+
+// per-instance data of the sphere draw, read by pbr.vs as vertex attributes 3-9
+struct SphereInstance
+{
+    glm::mat4 model;
+    glm::mat3 normalMatrix;
+};
+void setSphereInstances(const std::vector<SphereInstance>& instances);
+RenderMesh sphereMesh();
+RenderMesh cubeMesh();
 
 // settings
 const unsigned int SCR_WIDTH = 1920;
 const unsigned int SCR_HEIGHT = 1080;
+// the framebuffer's size in pixels, kept current by framebuffer_size_callback
+int scrWidth = SCR_WIDTH;
+int scrHeight = SCR_HEIGHT;
 bool gamma = false;
 bool gammaKeyPressed = false;
 bool bloom = true;
 bool bloomKeyPressed = false;
 float exposure = 1.0f;
+const unsigned int NR_LIGHTS = 4;
 
-// camera
+// camera: the update thread owns and moves it, the render loop rebuilds this copy every frame
+// from the newest snapshot. input only goes into the queue
 Camera camera(glm::vec3(0.f, 0.f, 3.f));
+InputQueue inputQueue;
 float lastX = SCR_WIDTH / 2.f;
 float lastY = SCR_HEIGHT / 2.f;
 bool firstMouse = true;
 
-// timing
-float deltaTime = 0.f;
-float lastFrame = 0.f;
-
-int main()
+int main(int argc, char** argv)
 {
+    // CPU only benchmarks, no window needed
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::string(argv[i]) == "--bench-clusters")
+        {
+            benchmarkClusterBinning();
+            return 0;
+        }
+        if (std::string(argv[i]) == "--bench-gbuffer")
+        {
+            reportGBufferBandwidth(SCR_WIDTH, SCR_HEIGHT);
+            return 0;
+        }
+        if (std::string(argv[i]) == "--bench-queue")
+        {
+            benchmarkRenderQueue();
+            return 0;
+        }
+    }
+
+    // --bench: hidden window, offscreen target, scripted camera and a fixed time step
+    BenchOptions benchOptions = parseBenchOptions(argc, argv);
+    FrameBenchmark frameBench(benchOptions, SCR_WIDTH, SCR_HEIGHT);
+
     // glfw: initialize and configure
     // ------------------------------
     glfwInit();
@@ -61,6 +111,11 @@ int main()
 #ifdef __APPLE__
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
+    if (benchOptions.enabled)
+    {
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        glfwWindowHint(GLFW_CONTEXT_CREATION_API, benchOptions.contextApi);
+    }
 
     // glfw window creation
     // --------------------
@@ -77,7 +132,8 @@ int main()
     glfwSetScrollCallback(window, scroll_callback);
 
     // tell GLFW to capture our mouse
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+    if (!benchOptions.enabled)
+        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
     // glad: load all OpenGL function pointers
     // ---------------------------------------
@@ -86,6 +142,7 @@ int main()
         std::cout << "Failed to initialize GLAD" << std::endl;
         return -1;
     }
+    shaderCompileQueue().setCompilerThreads((GLADloadproc)glfwGetProcAddress);
 #ifndef NDEBUG
     GLint flags = 0;
     glGetIntegerv(GL_CONTEXT_FLAGS, &flags);
@@ -101,6 +158,12 @@ int main()
     }
 #endif
 
+    if (benchOptions.enabled)
+    {
+        frameBench.createTarget();
+        frameBench.endPhase("context");
+    }
+
     // configure global opengl state
     // -----------------------------
     glEnable(GL_DEPTH_TEST);
@@ -108,13 +171,18 @@ int main()
 
     // build and compile our pbrShader zprogram
     // ------------------------------------
-    Shader pbrShader("shaders/pbr.vs", "shaders/pbr.fs");
+    auto shadersStart = std::chrono::steady_clock::now();
+    ShaderLibrary shaders;      // owns the pbr program, only the default define set is built
+    Shader& pbrShader = shaders.get("shaders/pbr.vs", "shaders/pbr.fs");
     Shader equirectangularToCubemapShader("shaders/cubemap.vs", "shaders/equirectangular_to_cubemap.fs");
     Shader irradianceShader("shaders/cubemap.vs", "shaders/irradiance_convolution.fs");
     Shader prefilterShader("shaders/cubemap.vs", "shaders/prefilter.fs");
     Shader brdfShader("shaders/brdf.vs", "shaders/brdf.fs");
     Shader backgroundShader("shaders/background.vs", "shaders/background.fs");
     Shader textShader("shaders/text.vs", "shaders/text.fs");
+    std::chrono::duration<double, std::milli> shadersTime = std::chrono::steady_clock::now() - shadersStart;
+    std::cout << "Submitted shader programs in " << shadersTime.count() << " ms ("
+        << programBinaryCache().hits() << " from binary cache, " << programBinaryCache().misses() << " compiled)" << std::endl;
 
     loadCharacters();
 
@@ -124,6 +192,8 @@ int main()
     unsigned int metallic = textureFromFile("rustediron2_metallic.png", directory);
     unsigned int roughness = textureFromFile("rustediron2_roughness.png", directory);
     unsigned int ao = textureFromFile("rustediron2_ao.png", directory);
+    if (benchOptions.enabled)
+        frameBench.endPhase("shaders and textures");
 
     pbrShader.use();
     pbrShader.setInt("albedoMap", 0);
@@ -140,13 +210,13 @@ int main()
 
     // lights
     // ------
-    glm::vec3 lightPositions[] = {
+    glm::vec3 lightPositions[NR_LIGHTS] = {
         glm::vec3(-10.0f,  10.0f, 10.0f),
         glm::vec3(10.0f,  10.0f, 10.0f),
         glm::vec3(-10.0f, -10.0f, 10.0f),
         glm::vec3(10.0f, -10.0f, 10.0f),
     };
-    glm::vec3 lightColors[] = {
+    glm::vec3 lightColors[NR_LIGHTS] = {
         glm::vec3(300.0f, 300.0f, 300.0f),
         glm::vec3(300.0f, 300.0f, 300.0f),
         glm::vec3(300.0f, 300.0f, 300.0f),
@@ -156,6 +226,58 @@ int main()
     int nrColumns = 7;
     float spacing = 2.5;
 
+    // camera data shared by every program, written once per frame
+    // -----------------------------------------------------------
+    UniformBuffer<CameraBlock> cameraBuffer(CAMERA_BINDING);
+
+    // lights live in a storage buffer, the shaders loop over its runtime light count. these never
+    // change here, so they're uploaded once up front; edits later only re-upload the touched range
+    // ---------------------------------------------------------------------------------------------
+    LightBuffer lightBuffer(LIGHTS_BINDING);
+    for (unsigned int i = 0; i < NR_LIGHTS; ++i)
+    {
+        PointLight light;
+        light.position = lightPositions[i];
+        light.color = lightColors[i];
+        lightBuffer.add(light);
+    }
+    lightBuffer.upload();
+
+    // clustered shading: lights are binned into view frustum clusters every frame, the shaders
+    // only loop over the lights of the fragment's cluster
+    LightClusters lightClusters(CLUSTERS_BINDING, CLUSTER_LIGHTS_BINDING);
+    float clusterZoom = 0.0f;
+    int clusterWidth = 0;
+    int clusterHeight = 0;
+
+    // rows*column number of spheres with varying metallic/roughness values scaled by rows and columns respectively,
+    // followed by the light source spheres. the scene is static, so model and normal matrices are computed once
+    // and the whole set is drawn with a single instanced draw call
+    // ------------------------------------------------------------------------------------------------------------
+    std::vector<SphereInstance> sphereInstances;
+    sphereInstances.reserve(nrRows * nrColumns + NR_LIGHTS);
+    for (int row = 0; row < nrRows; ++row)
+    {
+        for (int col = 0; col < nrColumns; ++col)
+        {
+            glm::mat4 model = glm::mat4(1.0f);
+            model = glm::translate(model, glm::vec3(
+                (float)(col - (nrColumns / 2)) * spacing,
+                (float)(row - (nrRows / 2)) * spacing,
+                -2.0f
+            ));
+            sphereInstances.push_back({ model, glm::transpose(glm::inverse(glm::mat3(model))) });
+        }
+    }
+    for (unsigned int i = 0; i < NR_LIGHTS; ++i)
+    {
+        glm::mat4 model = glm::mat4(1.0f);
+        model = glm::translate(model, lightPositions[i]);
+        model = glm::scale(model, glm::vec3(0.5f));
+        sphereInstances.push_back({ model, glm::transpose(glm::inverse(glm::mat3(model))) });
+    }
+    setSphereInstances(sphereInstances);
+
     // pbr: setup framebuffer
     // ----------------------
     unsigned int captureFBO;
@@ -228,17 +350,20 @@ int main()
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, hdrTexture);
 
-    glViewport(0, 0, 512, 512); // don't forget to configure the viewport to the capture dimensions.
-    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-    for (unsigned int i = 0; i < 6; ++i)
     {
-        equirectangularToCubemapShader.setMat4("view", captureViews[i]);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, envCubemap, 0);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        PROFILE_GPU("IBL: equirectangular to cubemap");
+        glViewport(0, 0, 512, 512); // don't forget to configure the viewport to the capture dimensions.
+        glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
+        for (unsigned int i = 0; i < 6; ++i)
+        {
+            equirectangularToCubemapShader.setMat4("view", captureViews[i]);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, envCubemap, 0);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        renderCube();
+            renderCube();
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
     }
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
     // pbr: create an irradiance cubemap, and re-scale capture FBO to irradiance scale.
     // --------------------------------------------------------------------------------
@@ -267,17 +392,20 @@ int main()
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
 
-    glViewport(0, 0, 32, 32); 
-    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-    for (unsigned int i = 0; i < 6; ++i)
     {
-        irradianceShader.setMat4("view", captureViews[i]);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, irradianceMap, 0);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        PROFILE_GPU("IBL: irradiance convolution");
+        glViewport(0, 0, 32, 32); 
+        glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
+        for (unsigned int i = 0; i < 6; ++i)
+        {
+            irradianceShader.setMat4("view", captureViews[i]);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, irradianceMap, 0);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        renderCube();
+            renderCube();
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
     }
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
     unsigned int prefilteredMap;
     glGenTextures(1, &prefilteredMap);
@@ -298,27 +426,30 @@ int main()
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
 
-    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-    unsigned int maxMipLevels = 5;
-    for (size_t mip = 0; mip < maxMipLevels; ++mip) {
-        unsigned int mipWidth = static_cast<unsigned int>(128 * std::pow(0.5, mip));
-        unsigned int mipHeight = static_cast<unsigned int>(128 * std::pow(0.5, mip));
-
-        glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
-        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, mipWidth, mipHeight);
-        glViewport(0, 0, mipWidth, mipHeight);
-
-        float roughness = static_cast<float>(mip) / static_cast<float>(maxMipLevels - 1);
-        prefilterShader.setFloat("roughness", roughness);
-        for (size_t i = 0; i < 6; ++i) {
-            prefilterShader.setMat4("view", captureViews[i]);
-            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, prefilteredMap, mip);
-
-            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-            renderCube();
+    {
+        PROFILE_GPU("IBL: prefilter");
+        glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
+        unsigned int maxMipLevels = 5;
+        for (size_t mip = 0; mip < maxMipLevels; ++mip) {
+            unsigned int mipWidth = static_cast<unsigned int>(128 * std::pow(0.5, mip));
+            unsigned int mipHeight = static_cast<unsigned int>(128 * std::pow(0.5, mip));
+
+            glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
+            glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, mipWidth, mipHeight);
+            glViewport(0, 0, mipWidth, mipHeight);
+
+            float roughness = static_cast<float>(mip) / static_cast<float>(maxMipLevels - 1);
+            prefilterShader.setFloat("roughness", roughness);
+            for (size_t i = 0; i < 6; ++i) {
+                prefilterShader.setMat4("view", captureViews[i]);
+                glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, prefilteredMap, mip);
+
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                renderCube();
+            }
         }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
     }
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
     unsigned int brdfLUTTexture;
     glGenTextures(1, &brdfLUTTexture);
@@ -336,125 +467,224 @@ int main()
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, captureRBO);
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, brdfLUTTexture, 0);
 
-    glViewport(0, 0, 512, 512);
-    brdfShader.use();
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    renderQuad();
+    {
+        PROFILE_GPU("IBL: BRDF LUT");
+        glViewport(0, 0, 512, 512);
+        brdfShader.use();
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        renderQuad();
+    }
 
+    // the capture targets are only needed for the bakes above
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteRenderbuffers(1, &captureRBO);
+    glDeleteFramebuffers(1, &captureFBO);
+    if (benchOptions.enabled)
+    {
+        glFinish();
+        frameBench.endPhase("ibl bake");
+    }
 
     // initialize static shader uniforms before rendering
     // --------------------------------------------------
-    glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-    pbrShader.use();
-    pbrShader.setMat4("projection", projection);
-    backgroundShader.use();
-    backgroundShader.setMat4("projection", projection);
+    textShader.use();
+    textShader.setMat4("projection", glm::ortho(0.f, static_cast<float>(SCR_WIDTH), 0.f, static_cast<float>(SCR_HEIGHT)));
+
+    // every program has been used by now, finish them and report the compile phase
+    shaderCompileQueue().waitAll();
+    shaderCompileQueue().logTimings();
+
+    // hot reload the programs drawn every frame when their sources change on disk
+    ShaderWatcher shaderWatcher;
+    shaderWatcher.watch(pbrShader);
+    shaderWatcher.watch(backgroundShader);
+    shaderWatcher.watch(textShader);
 
     // then before rendering, configure the viewport to the original framebuffer's screen dimensions
-    int scrWidth, scrHeight;
     glfwGetFramebufferSize(window, &scrWidth, &scrHeight);
-    glViewport(0, 0, scrWidth, scrHeight);
 
-    while (!glfwWindowShouldClose(window))
+    // the scene is drawn through a sort-key render queue: registered once here, the draws are
+    // recorded every frame and submitted sorted by bucket, program, material, mesh and depth
+    // ----------------------------------------------------------------------------------------
+    RenderQueue renderQueue;
+    uint32_t pbrProgram = renderQueue.addProgram(pbrShader);
+    uint32_t backgroundProgram = renderQueue.addProgram(backgroundShader);
+    RenderMaterial rustedIron;
+    unsigned int pbrTextures[] = { albedo, normal, metallic, roughness, ao, irradianceMap, prefilteredMap, brdfLUTTexture };
+    for (unsigned int texture : pbrTextures)
+        rustedIron.textures[rustedIron.textureCount++] = texture;
+    uint32_t rustedIronMaterial = renderQueue.addMaterial(rustedIron);
+    RenderMaterial environment;
+    environment.textures[environment.textureCount++] = envCubemap;
+    //environment.textures[0] = irradianceMap; // display irradiance map
+    uint32_t environmentMaterial = renderQueue.addMaterial(environment);
+    uint32_t sphere = renderQueue.addMesh(sphereMesh());
+    uint32_t cube = renderQueue.addMesh(cubeMesh());
+
+    // setup above changed bindings and state directly, from here on the per-frame code goes
+    // through the state cache
+    glState().invalidate();
+    glState().viewport(0, 0, scrWidth, scrHeight);
+
+    // tonemapping and gamma of pbr.fs and background.fs come from one baked LUT (the default grading
+    // is plain Reinhard), bound once on the first unit the materials don't use
+    ColorLut colorLut;
+    colorLut.update(ColorGrading());
+    pbrShader.use();
+    colorLut.apply(pbrShader, RenderMaterial::MAX_TEXTURES);
+    backgroundShader.use();
+    colorLut.apply(backgroundShader, RenderMaterial::MAX_TEXTURES);
+
+    // fixed time step simulation on its own thread, the benchmark keeps its deterministic
+    // scripted camera on this thread instead
+    // ---------------------------------------------------------------------------------------
+    UpdateThread updateThread(inputQueue, camera);
+    if (!benchOptions.enabled)
+        updateThread.start();
+    float interpolation = 0.f;
+    uint64_t simulationTick = 0;
+
+    while (benchOptions.enabled ? !frameBench.done() : !glfwWindowShouldClose(window))
     {
-        // per-frame time logic
-        // --------------------
-        float currentFrame = static_cast<float>(glfwGetTime());
-        deltaTime = currentFrame - lastFrame;
-        lastFrame = currentFrame;
-
-        // input
-        // -----
-        processInput(window);
+        profiler().beginFrame();
+        Shader::resetFrameStats();
+        glState().resetStats();
+        dynamicBuffers().beginFrame();
+        // programs compiled after startup (reloads) are checked and timed as soon as they're done
+        shaderCompileQueue().poll();
+
+        // input goes to the update thread, the camera and scene time come from its newest
+        // snapshot (or the scripted camera path when benchmarking)
+        // ---------------------------------------------------------------------------------
+        float currentFrame;
+        if (benchOptions.enabled)
+        {
+            currentFrame = frameBench.time();
+            BenchCameraPose pose = benchCameraPose(frameBench.frame(), frameBench.frameCount(), glm::vec3(0.0f, 0.0f, -2.0f), 12.0f);
+            camera = Camera(pose.position, glm::vec3(0.0f, 1.0f, 0.0f), pose.yaw, pose.pitch);
+            frameBench.beginFrame();
+        }
+        else
+        {
+            shaderWatcher.update();
+            processInput(window);
+
+            const FrameSnapshot& snapshot = updateThread.latest();
+            interpolation = updateThread.interpolation(snapshot);
+            simulationTick = snapshot.tick;
+            camera = snapshot.interpolate(interpolation).camera();
+            currentFrame = static_cast<float>(snapshot.time - (1.0 - interpolation) * updateThread.step());
+        }
 
         // render
         // ------
         glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-        // render scene, supplying the convoluted irradiance map to the final shader.
-        // ------------------------------------------------------------------------------------------
-        pbrShader.use();
-        glm::mat4 view = camera.GetViewMatrix();
-        pbrShader.setMat4("view", view);
-        pbrShader.setVec3("camPos", camera.Position);
-
-        // bind pre-computed IBL data
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, albedo);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, normal);
-        glActiveTexture(GL_TEXTURE2);
-        glBindTexture(GL_TEXTURE_2D, metallic);
-        glActiveTexture(GL_TEXTURE3);
-        glBindTexture(GL_TEXTURE_2D, roughness);
-        glActiveTexture(GL_TEXTURE4);
-        glBindTexture(GL_TEXTURE_2D, ao);
-        glActiveTexture(GL_TEXTURE5);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, irradianceMap);
-        glActiveTexture(GL_TEXTURE6);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, prefilteredMap);
-        glActiveTexture(GL_TEXTURE7);
-        glBindTexture(GL_TEXTURE_2D, brdfLUTTexture);
-
-        // render rows*column number of spheres with varying metallic/roughness values scaled by rows and columns respectively
-        glm::mat4 model = glm::mat4(1.0f);
-        for (int row = 0; row < nrRows; ++row)
+        // per-frame camera data, one buffer write shared by every program
+        // a minimized window has a 0x0 framebuffer, the aspect ratio then falls back to 1
+        float aspect = scrWidth > 0 && scrHeight > 0 ? (float)scrWidth / (float)scrHeight : 1.0f;
+        CameraBlock cameraBlock;
+        cameraBlock.projection = glm::perspective(glm::radians(camera.Zoom), aspect, 0.1f, 100.0f);
+        cameraBlock.view = camera.GetViewMatrix();
+        cameraBlock.viewProjection = cameraBlock.projection * cameraBlock.view;
+        cameraBlock.inverseViewProjection = glm::inverse(cameraBlock.viewProjection);
+        cameraBlock.position = camera.Position;
+        cameraBlock.time = currentFrame;
+        cameraBuffer.update(cameraBlock);
+
         {
-            for (int col = 0; col < nrColumns; ++col)
+            PROFILE_CPU("light clusters");
+            // the clusters' tile size is in framebuffer pixels, it changes with the zoom and on resize
+            if (camera.Zoom != clusterZoom || scrWidth != clusterWidth || scrHeight != clusterHeight)
             {
-                model = glm::mat4(1.0f);
-                model = glm::translate(model, glm::vec3(
-                    (float)(col - (nrColumns / 2)) * spacing,
-                    (float)(row - (nrRows / 2)) * spacing,
-                    -2.0f
-                ));
-                pbrShader.setMat4("model", model);
-                pbrShader.setMat3("normalMatrix", glm::transpose(glm::inverse(glm::mat3(model))));
-                renderSphere();
+                clusterZoom = camera.Zoom;
+                clusterWidth = scrWidth;
+                clusterHeight = scrHeight;
+                lightClusters.setProjection(glm::radians(camera.Zoom), aspect, 0.1f, 100.0f, scrWidth, scrHeight);
             }
+            lightClusters.update(cameraBlock.view, lightBuffer.lights());
         }
 
-        // render light source (simply re-render sphere at light positions)
-        // this looks a bit off as we use the same shader, but it'll make their positions obvious and 
-        // keeps the codeprint small.
-        for (unsigned int i = 0; i < sizeof(lightPositions) / sizeof(lightPositions[0]); ++i)
+        // render scene, supplying the convoluted irradiance map to the final shader.
+        // the sphere grid and the light source spheres are a single instanced draw (this looks a bit
+        // off as we use the same shader, but it'll make their positions obvious and keeps the
+        // codeprint small). the skybox sits in the background bucket, drawn after all opaque draws
+        // to prevent overdraw
+        // ------------------------------------------------------------------------------------------
         {
-            glm::vec3 newPos = lightPositions[i] + glm::vec3(sin(glfwGetTime() * 5.0) * 5.0, 0.0, 0.0);
-            newPos = lightPositions[i];
-            pbrShader.setVec3("lightPositions[" + std::to_string(i) + "]", newPos);
-            pbrShader.setVec3("lightColors[" + std::to_string(i) + "]", lightColors[i]);
-
-            model = glm::mat4(1.0f);
-            model = glm::translate(model, newPos);
-            model = glm::scale(model, glm::vec3(0.5f));
-            pbrShader.setMat4("model", model);
-            pbrShader.setMat3("normalMatrix", glm::transpose(glm::inverse(glm::mat3(model))));
-            renderSphere();
+            PROFILE_GPU("render queue");
+            renderQueue.submit(0, RENDER_BUCKET_OPAQUE, pbrProgram, rustedIronMaterial, sphere, glm::length(camera.Position - glm::vec3(0.0f, 0.0f, -2.0f)),
+                static_cast<uint32_t>(sphereInstances.size()));
+            renderQueue.submit(0, RENDER_BUCKET_BACKGROUND, backgroundProgram, environmentMaterial, cube, 100.0f);
+            renderQueue.flush();
         }
 
-        // render skybox (render as last to prevent overdraw)
-        backgroundShader.use();
-        backgroundShader.setMat4("view", view);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
-        //glBindTexture(GL_TEXTURE_CUBE_MAP, irradianceMap); // display irradiance map
-        renderCube();
-
-        textShader.use();
-        glm::mat4 textProjection = glm::ortho(0.f, static_cast<float>(SCR_WIDTH), 0.f, static_cast<float>(SCR_HEIGHT));
-        textShader.setMat4("projection", textProjection);
+        // text overlay. the benchmark skips the timing lines, they would differ between runs and
+        // break image comparisons
+        // ----------------------------------------------------------------------------------------
+        {
+            PROFILE_GPU("text");
+            glState().enable(GL_BLEND);
+            glState().blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            renderText(textShader, "PBR lighting example", SCR_WIDTH - 385.f, SCR_HEIGHT - 45.f, .75f, glm::vec3(0.0f, 0.0f, 0.0f));
 
-        renderText(textShader, "PBR lighting example", SCR_WIDTH - 385.f, SCR_HEIGHT - 45.f, .75f, glm::vec3(0.0f, 0.0f, 0.0f));
+            if (!benchOptions.enabled)
+            {
+                const UniformStats& uniformStats = Shader::frameStats();
+                renderText(textShader, "uniform lookups: " + std::to_string(uniformStats.cached) + " cached, " + std::to_string(uniformStats.driver) + " driver",
+                    25.f, 25.f, .4f, glm::vec3(0.0f, 0.0f, 0.0f));
+                renderText(textShader, "light clusters: " + std::to_string(lightClusters.binMilliseconds()) + " ms, " + std::to_string(lightClusters.indexCount()) + " indices",
+                    25.f, 45.f, .4f, glm::vec3(0.0f, 0.0f, 0.0f));
+                // counted up to here, the text itself isn't included
+                const GLStateStats& stateStats = glState().stats();
+                renderText(textShader, "gl state: " + std::to_string(stateStats.issued) + " issued, " + std::to_string(stateStats.filtered) + " filtered",
+                    25.f, 65.f, .4f, glm::vec3(0.0f, 0.0f, 0.0f));
+                const RenderQueueStats& queueStats = renderQueue.stats();
+                renderText(textShader, "render queue: " + std::to_string(queueStats.commands) + " draws, " + std::to_string(queueStats.programChanges) + " programs, "
+                    + std::to_string(queueStats.materialChanges) + " materials, " + std::to_string(queueStats.meshChanges) + " meshes",
+                    25.f, 85.f, .4f, glm::vec3(0.0f, 0.0f, 0.0f));
+                renderText(textShader, "simulation: " + std::to_string(static_cast<int>(1.0 / updateThread.step() + 0.5)) + " Hz, tick " + std::to_string(simulationTick)
+                    + ", interpolation " + std::to_string(interpolation) + ", " + std::to_string(updateThread.dropped()) + " ticks dropped",
+                    25.f, 105.f, .4f, glm::vec3(0.0f, 0.0f, 0.0f));
+                const DynamicBufferStats& dynamicStats = dynamicBuffers().stats();
+                renderText(textShader, "dynamic buffer: " + std::to_string(dynamicStats.allocated) + " bytes in " + std::to_string(dynamicStats.allocations)
+                    + " allocations, " + std::to_string(dynamicStats.stalls) + " stalls",
+                    25.f, 125.f, .4f, glm::vec3(0.0f, 0.0f, 0.0f));
+
+                // per scope timings of the previous frames, GPU times lag QUERY_FRAMES frames behind
+                float statY = 145.f;
+                for (const Profiler::Stat& stat : profiler().stats())
+                {
+                    renderText(textShader, std::string(stat.gpu ? "gpu " : "cpu ") + stat.name + ": " + std::to_string(stat.average) + " ms",
+                        25.f, statY, .4f, glm::vec3(0.0f, 0.0f, 0.0f));
+                    statY += 20.f;
+                }
+            }
+        }
 
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
+        // the benchmark renders offscreen and waits for the frame to finish instead
         // -------------------------------------------------------------------------------
-        glfwSwapBuffers(window);
+        dynamicBuffers().endFrame();
+        if (benchOptions.enabled)
+            frameBench.endFrame();
+        else
+            glfwSwapBuffers(window);
         glfwPollEvents();
     }
+    updateThread.stop();
+
+    if (benchOptions.enabled)
+        frameBench.report();
+    frameBench.release();
+
+    // write the recorded scopes for chrome://tracing or ui.perfetto.dev
+    // ------------------------------------------------------------------
+    if (profiler().writeChromeTrace("profile_trace.json"))
+        std::cout << "Profiler trace written to profile_trace.json" << std::endl;
+    else
+        std::cout << "ERROR::PROFILER::TRACE_NOT_WRITTEN" << std::endl;
 
     // glfw: terminate, clearing all previously allocated GLFW resources.
     // ------------------------------------------------------------------
@@ -462,11 +692,12 @@ int main()
     return 0;
 }
 
-// renders (and builds at first invocation) a sphere
-// -------------------------------------------------
+// builds the sphere mesh on first use
+// -----------------------------------
 unsigned int sphereVAO = 0;
+unsigned int sphereInstanceVBO = 0;
 unsigned int indexCount;
-void renderSphere()
+void buildSphere()
 {
     if (sphereVAO == 0)
     {
@@ -541,7 +772,7 @@ void renderSphere()
                 data.push_back(uv[i].y);
             }
         }
-        glBindVertexArray(sphereVAO);
+        glState().bindVertexArray(sphereVAO);
         glBindBuffer(GL_ARRAY_BUFFER, vbo);
         glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(float), &data[0], GL_STATIC_DRAW);
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
@@ -554,18 +785,54 @@ void renderSphere()
         glEnableVertexAttribArray(2);
         glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(6 * sizeof(float)));
     }
+}
+
+// uploads the per-instance matrices of the sphere draw and attaches them to the sphere VAO,
+// model matrix as attributes 3-6, normal matrix as attributes 7-9
+// -----------------------------------------------------------------------------------------
+void setSphereInstances(const std::vector<SphereInstance>& instances)
+{
+    buildSphere();
+    if (sphereInstanceVBO == 0)
+        glGenBuffers(1, &sphereInstanceVBO);
+
+    glState().bindVertexArray(sphereVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, sphereInstanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(SphereInstance), instances.data(), GL_STATIC_DRAW);
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+        glEnableVertexAttribArray(3 + i);
+        glVertexAttribPointer(3 + i, 4, GL_FLOAT, GL_FALSE, sizeof(SphereInstance), (void*)(offsetof(SphereInstance, model) + i * sizeof(glm::vec4)));
+        glVertexAttribDivisor(3 + i, 1);
+    }
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+        glEnableVertexAttribArray(7 + i);
+        glVertexAttribPointer(7 + i, 3, GL_FLOAT, GL_FALSE, sizeof(SphereInstance), (void*)(offsetof(SphereInstance, normalMatrix) + i * sizeof(glm::vec3)));
+        glVertexAttribDivisor(7 + i, 1);
+    }
+    glState().bindVertexArray(0);
+}
 
-    glBindVertexArray(sphereVAO);
-    glDrawElements(GL_TRIANGLE_STRIP, indexCount, GL_UNSIGNED_INT, 0);
+// the sphere as a render queue mesh, instanced through the matrices of setSphereInstances
+// -----------------------------------------------------------------------------------------
+RenderMesh sphereMesh()
+{
+    buildSphere();
+    RenderMesh mesh;
+    mesh.vao = sphereVAO;
+    mesh.mode = GL_TRIANGLE_STRIP;
+    mesh.count = indexCount;
+    mesh.indexType = GL_UNSIGNED_INT;
+    return mesh;
 }
 
-// renderCube() renders a 1x1 3D cube in NDC.
-// -------------------------------------------------
+// builds the 1x1 3D cube in NDC on first use
+// ------------------------------------------
 unsigned int cubeVAO = 0;
 unsigned int cubeVBO = 0;
-void renderCube()
+void buildCube()
 {
-    // initialize (if necessary)
     if (cubeVAO == 0)
     {
         float vertices[] = {
@@ -618,7 +885,7 @@ void renderCube()
         glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
         glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
         // link vertex attributes
-        glBindVertexArray(cubeVAO);
+        glState().bindVertexArray(cubeVAO);
         glEnableVertexAttribArray(0);
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
         glEnableVertexAttribArray(1);
@@ -626,12 +893,28 @@ void renderCube()
         glEnableVertexAttribArray(2);
         glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
         glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glBindVertexArray(0);
+        glState().bindVertexArray(0);
     }
-    // render Cube
-    glBindVertexArray(cubeVAO);
+}
+
+// renderCube() renders a 1x1 3D cube in NDC.
+// -------------------------------------------------
+void renderCube()
+{
+    buildCube();
+    glState().bindVertexArray(cubeVAO);
     glDrawArrays(GL_TRIANGLES, 0, 36);
-    glBindVertexArray(0);
+}
+
+// the cube as a render queue mesh
+// -------------------------------
+RenderMesh cubeMesh()
+{
+    buildCube();
+    RenderMesh mesh;
+    mesh.vao = cubeVAO;
+    mesh.count = 36;
+    return mesh;
 }
 
 // renderQuad() renders a 1x1 XY quad in NDC
@@ -652,7 +935,7 @@ void renderQuad()
         // setup plane VAO
         glGenVertexArrays(1, &quadVAO);
         glGenBuffers(1, &quadVBO);
-        glBindVertexArray(quadVAO);
+        glState().bindVertexArray(quadVAO);
         glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
         glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
         glEnableVertexAttribArray(0);
@@ -660,9 +943,8 @@ void renderQuad()
         glEnableVertexAttribArray(1);
         glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
     }
-    glBindVertexArray(quadVAO);
+    glState().bindVertexArray(quadVAO);
     glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-    glBindVertexArray(0);
 }
 
 // process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
@@ -672,14 +954,11 @@ void processInput(GLFWwindow* window)
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         glfwSetWindowShouldClose(window, true);
 
-    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
-        camera.ProcessKeyboard(FORWARD, deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
-        camera.ProcessKeyboard(BACKWARD, deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
-        camera.ProcessKeyboard(LEFT, deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
-        camera.ProcessKeyboard(RIGHT, deltaTime);
+    // the update thread moves the camera on its next tick
+    inputQueue.setMovement(glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS,
+        glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS,
+        glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS,
+        glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS);
 }
 
 // glfw: whenever the window size changed (by OS or user resize) this callback function executes
@@ -688,7 +967,9 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
     // make sure the viewport matches the new window dimensions; note that width and 
     // height will be significantly larger than specified on retina displays.
-    glViewport(0, 0, width, height);
+    glState().viewport(0, 0, width, height);
+    scrWidth = width;
+    scrHeight = height;
 }
 
 
@@ -711,54 +992,12 @@ void mouse_callback(GLFWwindow* window, double xposIn, double yposIn)
     lastX = xpos;
     lastY = ypos;
 
-    camera.ProcessMouseMovement(xoffset, yoffset);
+    inputQueue.addMouse(xoffset, yoffset);
 }
 
 // glfw: whenever the mouse scroll wheel scrolls, this callback is called
 // ----------------------------------------------------------------------
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
 {
-    camera.ProcessMouseScroll(static_cast<float>(yoffset));
+    inputQueue.addScroll(static_cast<float>(yoffset));
 }
-
-unsigned int loadCubemap(std::vector<std::string> faces_paths) {
-    unsigned int cubemap;
-    glGenTextures(1, &cubemap);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap);
-
-    int width, height, channels;
-    for (size_t i = 0; i < faces_paths.size(); ++i) {
-        unsigned char* data = stbi_load(faces_paths[i].c_str(), &width, &height, &channels, NULL);
-
-        if (data) {
-            unsigned int internalFormat;
-            switch(channels) {
-                case 1:
-                    internalFormat = GL_RED;
-                    break;
-                case 3:
-                    internalFormat = GL_RGB;
-                    break;
-                default:
-                    internalFormat = GL_RGBA;
-            }
-
-            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, internalFormat, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-            stbi_image_free(data);
-        }
-        else {
-            std::cout << "Failed to load the cubemap face: " << faces_paths[i] << std::endl;
-            stbi_image_free(data);
-        }
-    }
-
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-
-    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
-
-    return cubemap;
-}
\ No newline at end of file
@@ -13,7 +13,7 @@ void Mesh::setup() {
     glGenBuffers(1, &VBO);
     glGenBuffers(1, &EBO);
 
-    glBindVertexArray(VAO);
+    glState().bindVertexArray(VAO);
 
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
     glBufferData(GL_ARRAY_BUFFER, m_vertices.size() * sizeof(Vertex), m_vertices.data(), GL_STATIC_DRAW);
@@ -33,7 +33,7 @@ void Mesh::setup() {
     glEnableVertexAttribArray(3);
     glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, tangent));
 
-    glBindVertexArray(0);
+    glState().bindVertexArray(0);
 }
 
 void Mesh::Draw(Shader& shader) {
@@ -42,8 +42,6 @@ void Mesh::Draw(Shader& shader) {
     unsigned int normalCount = 1;
 
     for (size_t i = 0; i < m_textures.size(); ++i) {
-        glActiveTexture(GL_TEXTURE0 + i);
-
         std::string type = m_textures[i].type;
         std::string number;
 
@@ -58,12 +56,9 @@ void Mesh::Draw(Shader& shader) {
         }
 
         shader.setInt(type + number, i);
-        glBindTexture(GL_TEXTURE_2D, m_textures[i].id);
+        glState().bindTexture(static_cast<unsigned int>(i), m_textures[i].id);
     }
 
-    glBindVertexArray(VAO);
+    glState().bindVertexArray(VAO);
     glDrawElements(GL_TRIANGLES, m_indices.size(), GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
-
-    glActiveTexture(GL_TEXTURE0);
 }
\ No newline at end of file
@@ -40,4 +40,6 @@ class Mesh {
         std::vector<Vertex>& Vertices() {return m_vertices;}
         std::vector<unsigned int>& Indices() {return m_indices;}
         std::vector<Texture>& Textures() {return m_textures;}
+        unsigned int VertexBuffer() const {return VBO;}
+        unsigned int ElementBuffer() const {return EBO;}
 };
\ No newline at end of file
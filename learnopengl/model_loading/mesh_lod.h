@@ -0,0 +1,66 @@
+#pragma once
+
+#include "mesh.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Coarser index list for the same vertices by vertex clustering: positions are snapped to a grid
+// of cellSize, every cell is represented by the first vertex that falls into it and triangles whose
+// corners collapse into fewer than three cells are dropped. Crude next to edge collapse, but fast,
+// needs no new vertices and is good enough for geometry that only covers a few pixels.
+inline std::vector<unsigned int> simplifyByClustering(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, float cellSize) {
+    std::unordered_map<uint64_t, unsigned int> cells;
+    std::vector<unsigned int> representative(vertices.size());
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        glm::vec3 cell = glm::floor(vertices[i].position / cellSize);
+        // 21 bits per axis, offset so negative cells stay distinct
+        uint64_t key = (static_cast<uint64_t>(static_cast<int64_t>(cell.x) + (1 << 20)) & 0x1fffff) << 42
+                     | (static_cast<uint64_t>(static_cast<int64_t>(cell.y) + (1 << 20)) & 0x1fffff) << 21
+                     | (static_cast<uint64_t>(static_cast<int64_t>(cell.z) + (1 << 20)) & 0x1fffff);
+        representative[i] = cells.emplace(key, static_cast<unsigned int>(i)).first->second;
+    }
+
+    std::vector<unsigned int> simplified;
+    simplified.reserve(indices.size() / 2);
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        unsigned int a = representative[indices[i]];
+        unsigned int b = representative[indices[i + 1]];
+        unsigned int c = representative[indices[i + 2]];
+        if (a != b && b != c && a != c) {
+            simplified.push_back(a);
+            simplified.push_back(b);
+            simplified.push_back(c);
+        }
+    }
+    return simplified;
+}
+
+// lodCount index lists, the first one the original. Each further level clusters on a grid with
+// 'firstCells' cells along the largest extent, halved per level.
+inline std::vector<std::vector<unsigned int>> buildLods(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, unsigned int lodCount, float firstCells = 16.0f) {
+    glm::vec3 minimum(0.0f), maximum(0.0f);
+    if (!vertices.empty()) {
+        minimum = maximum = vertices[0].position;
+    }
+    for (const Vertex& vertex : vertices) {
+        minimum = glm::min(minimum, vertex.position);
+        maximum = glm::max(maximum, vertex.position);
+    }
+    glm::vec3 size = maximum - minimum;
+    float extent = std::max(size.x, std::max(size.y, size.z));
+
+    std::vector<std::vector<unsigned int>> lods(1, indices);
+    float cells = firstCells;
+    for (unsigned int lod = 1; lod < lodCount; ++lod, cells *= 0.5f) {
+        std::vector<unsigned int> simplified = extent > 0.0f ? simplifyByClustering(vertices, indices, extent / cells) : indices;
+        // a level that collapsed completely would make the object vanish, keep the previous one
+        lods.push_back(simplified.empty() ? lods.back() : simplified);
+    }
+    return lods;
+}
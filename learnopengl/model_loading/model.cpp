@@ -3,6 +3,7 @@
 #include <iostream>
 
 #include "../stb_image.h"
+#include "../profiling/profiler.h"
 
 void Model::Draw(Shader& shader) {
     for (unsigned int i = 0; i < m_meshes.size(); ++i) {
@@ -11,6 +12,7 @@ void Model::Draw(Shader& shader) {
 }
 
 void Model::loadModel(const std::string& path) {
+    PROFILE_CPU("Model::loadModel");
     Assimp::Importer importer;
     const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenSmoothNormals | aiProcess_CalcTangentSpace);
 
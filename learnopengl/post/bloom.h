@@ -0,0 +1,82 @@
+#pragma once
+
+#include "fullscreen_triangle.h"
+#include "../rendering/gl_state.h"
+#include "../rendering/render_graph.h"
+#include "../shader.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+// read every frame, only levels is fixed once the passes are added
+struct BloomSettings {
+    unsigned int levels = 6;        // half, quarter ... resolution steps
+    float threshold = 1.0f;         // luminance where bloom starts
+    float knee = 0.5f;              // soft ramp below the threshold
+    float radius = 1.0f;            // upsample tent size in texels, widens the glow without more passes
+};
+
+// Progressive bloom as render graph passes (shaders/bloom_downsample.fs, shaders/bloom_upsample.fs):
+// hdrColor is filtered down a chain of half resolution R11G11B10F targets with a 13 tap filter,
+// the first step also applies the bright pass, so the scene needs no second color output. Then a
+// tent filter walks back up, blending every level additively onto the next larger one. Each pass
+// touches a quarter of the pixels of the one before, so the whole chain costs about as much as a
+// single pass at half resolution, while the glow reaches 2^levels texels. Returns the half
+// resolution result, PostProcess (post/post_process.h) adds it to the scene scaled down, as every
+// level contributes its own glow. Leaves blending disabled.
+inline RenderResource addBloomPasses(RenderGraph& graph, RenderResource hdrColor, Shader& downsample, Shader& upsample, const BloomSettings& settings) {
+    downsample.use();
+    downsample.setInt("source", 0);
+    upsample.use();
+    upsample.setInt("source", 0);
+
+    unsigned int levelCount = std::max(1u, settings.levels);
+    std::vector<RenderResource> levels(levelCount);
+    RenderResource source = hdrColor;
+    for (unsigned int level = 0; level < levelCount; ++level) {
+        float scale = std::pow(0.5f, static_cast<float>(level + 1));
+        graph.addPass("bloom downsample " + std::to_string(level),
+            [&](RenderPassBuilder& builder)
+            {
+                builder.read(source);
+                levels[level] = builder.create("bloom " + std::to_string(level), RenderTargetDesc(GL_R11F_G11F_B10F, scale));
+            },
+            [&downsample, &settings, source, level](const RenderPassResources& targets)
+            {
+                glState().disable(GL_BLEND);
+                downsample.use();
+                downsample.setBool("prefilter", level == 0);
+                downsample.setFloat("threshold", settings.threshold);
+                downsample.setFloat("knee", settings.knee);
+                glState().bindTexture(0, targets.texture(source));
+                fullscreenTriangle().draw();
+            });
+        source = levels[level];
+    }
+
+    for (unsigned int level = levelCount - 1; level > 0; --level) {
+        RenderResource smaller = levels[level];
+        RenderResource larger = levels[level - 1];
+        graph.addPass("bloom upsample " + std::to_string(level),
+            [&](RenderPassBuilder& builder)
+            {
+                builder.read(smaller);
+                builder.write(larger);
+            },
+            [&upsample, &settings, smaller](const RenderPassResources& targets)
+            {
+                glState().enable(GL_BLEND);
+                glState().blendFunc(GL_ONE, GL_ONE);
+                upsample.use();
+                upsample.setFloat("radius", settings.radius);
+                glState().bindTexture(0, targets.texture(smaller));
+                fullscreenTriangle().draw();
+                glState().disable(GL_BLEND);
+            });
+    }
+    return levels[0];
+}
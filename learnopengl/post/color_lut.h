@@ -0,0 +1,140 @@
+#pragma once
+
+#include "../rendering/gl_state.h"
+#include "../shader.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+enum TonemapOperator {
+    TONEMAP_REINHARD = 0,       // x / (1 + x)
+    TONEMAP_EXPONENTIAL,        // 1 - exp(-x)
+    TONEMAP_ACES                // Narkowicz's fit of the ACES filmic curve
+};
+
+// everything after exposure, applied in this order to the exposed scene linear color
+struct ColorGrading {
+    glm::vec3 colorFilter = glm::vec3(1.0f);    // white balance / tint, multiplied in linear space
+    float contrast = 1.0f;                      // around middle grey, in log space
+    float saturation = 1.0f;                    // 0 is greyscale
+    TonemapOperator tonemap = TONEMAP_REINHARD;
+    float gamma = 2.2f;                         // of the display
+
+    bool operator==(const ColorGrading& other) const {
+        return colorFilter == other.colorFilter && contrast == other.contrast && saturation == other.saturation
+            && tonemap == other.tonemap && gamma == other.gamma;
+    }
+    bool operator!=(const ColorGrading& other) const { return !(*this == other); }
+};
+
+// the reference the LUT is baked from: exposed scene linear color to display color
+inline glm::vec3 gradeColor(glm::vec3 color, const ColorGrading& grading) {
+    const float MIDDLE_GREY = 0.18f;
+    const glm::vec3 LUMA(0.2126f, 0.7152f, 0.0722f);
+    color = glm::max(color, glm::vec3(0.0f)) * grading.colorFilter;
+    color = MIDDLE_GREY * glm::pow(color / MIDDLE_GREY, glm::vec3(grading.contrast));
+    color = glm::max(glm::mix(glm::vec3(glm::dot(color, LUMA)), color, grading.saturation), glm::vec3(0.0f));
+    switch (grading.tonemap) {
+        case TONEMAP_REINHARD:
+            color = color / (color + glm::vec3(1.0f));
+            break;
+        case TONEMAP_EXPONENTIAL:
+            color = glm::vec3(1.0f) - glm::exp(-color);
+            break;
+        case TONEMAP_ACES:
+            color = glm::clamp(color * (2.51f * color + 0.03f) / (color * (2.43f * color + 0.59f) + 0.14f), glm::vec3(0.0f), glm::vec3(1.0f));
+            break;
+    }
+    return glm::pow(color, glm::vec3(1.0f / grading.gamma));
+}
+
+// Tonemapping, color grading and gamma baked on the CPU into a size^3 RGB10A2 texture, so a shader
+// applies all of them with one filtered fetch (shaders/include/color_lut.glsl). HDR input doesn't
+// fit a [0, 1] cube, the LUT is indexed by log2(color + 2^LOG_MIN) over [LOG_MIN, LOG_MAX] stops:
+// black lands exactly on the first texel, the texels are spread evenly over the stops and colors
+// above 2^LOG_MAX clamp to the last one. Exposure stays in the shader, it changes every frame.
+// update() rebakes only when the grading changed. GL thread only.
+class ColorLut {
+    private:
+        GLuint m_texture = 0;
+        unsigned int m_size;
+        ColorGrading m_grading;
+        bool m_baked = false;
+
+    public:
+        static constexpr float LOG_MIN = -10.0f;
+        static constexpr float LOG_MAX = 8.0f;
+
+        explicit ColorLut(unsigned int size = 32) : m_size{ std::max(2u, size) } {}
+
+        ~ColorLut() {
+            if (m_texture) {
+                glState().forgetTexture(m_texture);
+                glDeleteTextures(1, &m_texture);
+            }
+        }
+
+        ColorLut(const ColorLut&) = delete;
+        ColorLut& operator=(const ColorLut&) = delete;
+
+        // exposed scene linear value of texel 'index' along an axis
+        float texelValue(unsigned int index) const {
+            float stops = LOG_MIN + (LOG_MAX - LOG_MIN) * index / (m_size - 1);
+            return std::exp2(stops) - std::exp2(LOG_MIN);
+        }
+
+        // bakes the LUT if 'grading' differs from the baked one, returns true if it did
+        bool update(const ColorGrading& grading) {
+            if (m_baked && grading == m_grading) {
+                return false;
+            }
+            if (!m_texture) {
+                glCreateTextures(GL_TEXTURE_3D, 1, &m_texture);
+                glTextureStorage3D(m_texture, 1, GL_RGB10_A2, m_size, m_size, m_size);
+                glTextureParameteri(m_texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+                glTextureParameteri(m_texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+                glTextureParameteri(m_texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+                glTextureParameteri(m_texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+                glTextureParameteri(m_texture, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+            }
+            std::vector<float> values(m_size);
+            for (unsigned int i = 0; i < m_size; ++i) {
+                values[i] = texelValue(i);
+            }
+            std::vector<float> texels(m_size * m_size * m_size * 3);
+            float* texel = texels.data();
+            for (unsigned int b = 0; b < m_size; ++b) {
+                for (unsigned int g = 0; g < m_size; ++g) {
+                    for (unsigned int r = 0; r < m_size; ++r) {
+                        glm::vec3 color = gradeColor(glm::vec3(values[r], values[g], values[b]), grading);
+                        *texel++ = color.r;
+                        *texel++ = color.g;
+                        *texel++ = color.b;
+                    }
+                }
+            }
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+            glTextureSubImage3D(m_texture, 0, 0, 0, 0, m_size, m_size, m_size, GL_RGB, GL_FLOAT, texels.data());
+            m_grading = grading;
+            m_baked = true;
+            return true;
+        }
+
+        // binds the LUT to 'unit' and sets the uniforms of shaders/include/color_lut.glsl, 'shader' has to be in use
+        void apply(Shader& shader, unsigned int unit) const {
+            float scale = (m_size - 1.0f) / m_size;
+            float range = LOG_MAX - LOG_MIN;
+            glState().bindTexture(unit, m_texture);
+            shader.setInt("colorLut", static_cast<int>(unit));
+            // texture coordinate = log2(color + x) * y + z
+            shader.setVec3("colorLutDomain", std::exp2(LOG_MIN), scale / range, 0.5f / m_size - LOG_MIN * scale / range);
+        }
+
+        GLuint texture() const { return m_texture; }
+        unsigned int size() const { return m_size; }
+        const ColorGrading& grading() const { return m_grading; }
+};
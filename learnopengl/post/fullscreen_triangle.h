@@ -0,0 +1,28 @@
+#pragma once
+
+#include "../rendering/gl_state.h"
+
+#include <glad/glad.h>
+
+// One triangle covering the viewport for full screen passes. shaders/fullscreen.vs derives the
+// positions and texture coordinates from gl_VertexID, so there is no vertex buffer, and unlike a
+// quad there is no diagonal where fragments get shaded twice. The vertex array is empty and never
+// deleted, it goes away with the context. GL thread only.
+class FullscreenTriangle {
+    private:
+        GLuint m_vertexArray = 0;
+
+    public:
+        void draw() {
+            if (!m_vertexArray) {
+                glCreateVertexArrays(1, &m_vertexArray);
+            }
+            glState().bindVertexArray(m_vertexArray);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+        }
+};
+
+inline FullscreenTriangle& fullscreenTriangle() {
+    static FullscreenTriangle instance;
+    return instance;
+}
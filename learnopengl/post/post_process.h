@@ -0,0 +1,102 @@
+#pragma once
+
+#include "color_lut.h"
+#include "fullscreen_triangle.h"
+#include "../rendering/gl_state.h"
+#include "../rendering/render_graph.h"
+#include "../shader.h"
+#include "../shading/permutations.h"
+#include "../shading/preprocessor.h"
+
+#include <glad/glad.h>
+
+#include <string>
+
+// read every frame; toggling an effect switches to another program, changing the grading rebakes the LUT
+struct PostSettings {
+    bool bloom = true;
+    float bloomIntensity = 0.25f;
+    float exposure = 1.0f;
+    bool colorGrading = true;       // tonemapping, grading and gamma through the LUT
+    ColorGrading grading;
+};
+
+// Everything between the HDR scene and the display in one full screen pass (shaders/post.fs): bloom
+// composite, exposure, then tonemapping, grading and gamma with a single fetch from a ColorLut. The
+// enabled effects select a permutation of the shader through defines, so a disabled effect costs
+// nothing, and each permutation is compiled the first time it is used through the ShaderLibrary it
+// shares with the rest of the renderer (the program cache keeps them cheap after that). No
+// intermediate target exists between the effects.
+class PostProcess {
+    private:
+        ShaderLibrary& m_library;
+        std::string m_vertexPath;
+        std::string m_fragmentPath;
+        ColorLut m_lut;
+
+        static const unsigned int SCENE_UNIT = 0;
+        static const unsigned int BLOOM_UNIT = 1;
+        static const unsigned int LUT_UNIT = 2;
+
+    public:
+        explicit PostProcess(ShaderLibrary& library, const char* vertexPath = "shaders/fullscreen.vs", const char* fragmentPath = "shaders/post.fs", unsigned int lutSize = 32)
+            : m_library(library), m_vertexPath(vertexPath), m_fragmentPath(fragmentPath), m_lut(lutSize) {}
+
+        static ShaderDefines defines(const PostSettings& settings) {
+            ShaderDefines defines;
+            if (settings.bloom) {
+                defines.set("POST_BLOOM");
+            }
+            if (settings.colorGrading) {
+                defines.set("POST_COLOR_LUT");
+            }
+            return defines;
+        }
+
+        Shader& program(const PostSettings& settings) {
+            return m_library.get(m_vertexPath, m_fragmentPath, defines(settings));
+        }
+
+        // draws the pass into the bound framebuffer, 'bloom' is ignored unless settings.bloom is set
+        void apply(const PostSettings& settings, GLuint scene, GLuint bloom) {
+            Shader& shader = program(settings);
+            shader.use();
+            glState().bindTexture(SCENE_UNIT, scene);
+            shader.setInt("scene", static_cast<int>(SCENE_UNIT));
+            shader.setFloat("exposure", settings.exposure);
+            if (settings.bloom) {
+                glState().bindTexture(BLOOM_UNIT, bloom);
+                shader.setInt("bloom", static_cast<int>(BLOOM_UNIT));
+                shader.setFloat("bloomIntensity", settings.bloomIntensity);
+            }
+            if (settings.colorGrading) {
+                m_lut.update(settings.grading);
+                m_lut.apply(shader, LUT_UNIT);
+            }
+            // the output may have a depth buffer the triangle would be tested against
+            glState().disable(GL_DEPTH_TEST);
+            glState().disable(GL_BLEND);
+            fullscreenTriangle().draw();
+        }
+
+        ColorLut& lut() { return m_lut; }
+};
+
+// the post pass as the last pass of a graph: reads hdrColor (and bloom, if valid), writes output
+inline void addPostProcessPass(RenderGraph& graph, RenderResource hdrColor, RenderResource bloom, RenderResource output, PostProcess& post, const PostSettings& settings) {
+    graph.addPass("post",
+        [&](RenderPassBuilder& builder)
+        {
+            builder.read(hdrColor);
+            if (bloom != INVALID_RENDER_RESOURCE) {
+                builder.read(bloom);
+            }
+            builder.write(output);
+        },
+        [&post, &settings, hdrColor, bloom](const RenderPassResources& targets)
+        {
+            PostSettings frameSettings = settings;
+            frameSettings.bloom = settings.bloom && bloom != INVALID_RENDER_RESOURCE;
+            post.apply(frameSettings, targets.texture(hdrColor), frameSettings.bloom ? targets.texture(bloom) : 0);
+        });
+}
@@ -0,0 +1,289 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// CPU/GPU instrumentation. Scopes record CPU begin/end timestamps; GPU scopes additionally bracket
+// their GL commands with a GL_TIMESTAMP query pair. Queries of a frame are read back QUERY_FRAMES
+// frames later and only when the driver reports them available, so reading never stalls the
+// pipeline (late results are dropped). Finished events go to a ring buffer, which feeds the
+// per-scope averages for an on-screen summary and the Chrome trace export (chrome://tracing,
+// https://ui.perfetto.dev). All timestamps are microseconds since the profiler was created, GPU
+// times are shifted onto the same timeline.
+class Profiler {
+    public:
+        struct Event {
+            const char* name;
+            bool gpu;
+            uint32_t thread;
+            uint32_t depth;
+            uint64_t frame;
+            double start;       // us
+            double duration;    // us
+        };
+
+        struct Stat {
+            const char* name;
+            bool gpu;
+            double average;     // ms, exponential moving average over frames
+            double last;        // ms, summed over the last frame it appeared in
+        };
+
+        // an open GPU scope: the frame it began in and its place among that frame's scopes
+        struct GpuScopeHandle {
+            uint64_t frame;
+            size_t index;
+        };
+
+    private:
+        static const unsigned int QUERY_FRAMES = 2;
+
+        struct GpuScope {
+            const char* name;
+            uint32_t depth;
+            uint64_t frame;
+            GLuint queries[2];
+        };
+
+        std::chrono::steady_clock::time_point m_epoch = std::chrono::steady_clock::now();
+        std::mutex m_mutex;
+
+        std::vector<Event> m_events;
+        size_t m_capacity;
+        size_t m_head = 0;      // next slot to write, the ring is full once m_events.size() == m_capacity
+
+        uint64_t m_frame = 0;
+        std::vector<GpuScope> m_gpuScopes[QUERY_FRAMES];
+        std::vector<GLuint> m_freeQueries;
+        uint32_t m_gpuDepth = 0;
+        bool m_calibrated = false;
+        double m_gpuOffset = 0.0;   // CPU us minus GPU us
+
+        std::map<std::string, Stat> m_stats;
+        std::map<std::string, double> m_frameTotals;
+
+        std::map<std::thread::id, uint32_t> m_threads;
+
+        uint32_t threadIndex() {
+            auto inserted = m_threads.insert(std::make_pair(std::this_thread::get_id(), static_cast<uint32_t>(m_threads.size())));
+            return inserted.first->second;
+        }
+
+        void push(const Event& event) {
+            if (m_events.size() < m_capacity) {
+                m_events.push_back(event);
+            } else {
+                m_events[m_head] = event;
+            }
+            m_head = (m_head + 1) % m_capacity;
+
+            std::string key = std::string(event.gpu ? "gpu " : "cpu ") + event.name;
+            m_frameTotals[key] += event.duration / 1000.0;
+            Stat& stat = m_stats[key];
+            stat.name = event.name;
+            stat.gpu = event.gpu;
+        }
+
+        void calibrate() {
+            GLint64 gpuNow = 0;
+            glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+            m_gpuOffset = now() - gpuNow / 1000.0;
+            m_calibrated = true;
+        }
+
+        GLuint acquireQuery() {
+            if (m_freeQueries.empty()) {
+                GLuint queries[16];
+                glGenQueries(16, queries);
+                m_freeQueries.insert(m_freeQueries.end(), queries, queries + 16);
+            }
+            GLuint query = m_freeQueries.back();
+            m_freeQueries.pop_back();
+            return query;
+        }
+
+        // reads back the scopes recorded in the slot that's about to be reused
+        void resolveGpuScopes(std::vector<GpuScope>& scopes) {
+            for (const GpuScope& scope : scopes) {
+                GLint available = 0;
+                glGetQueryObjectiv(scope.queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+                if (available) {
+                    GLuint64 begin = 0, end = 0;
+                    glGetQueryObjectui64v(scope.queries[0], GL_QUERY_RESULT, &begin);
+                    glGetQueryObjectui64v(scope.queries[1], GL_QUERY_RESULT, &end);
+                    Event event = { scope.name, true, 0, scope.depth, scope.frame, begin / 1000.0 + m_gpuOffset, (end - begin) / 1000.0 };
+                    push(event);
+                }
+                m_freeQueries.push_back(scope.queries[0]);
+                m_freeQueries.push_back(scope.queries[1]);
+            }
+            scopes.clear();
+        }
+
+    public:
+        explicit Profiler(size_t capacity = 1 << 16) : m_capacity{ capacity } {
+            m_events.reserve(m_capacity);
+        }
+
+        Profiler(const Profiler&) = delete;
+        Profiler& operator=(const Profiler&) = delete;
+
+        // us since the profiler was created
+        double now() const {
+            return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - m_epoch).count();
+        }
+
+        // call once per frame before any scope of the frame
+        void beginFrame() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            // fold the totals of the finished frame into the averages
+            for (std::pair<const std::string, Stat>& entry : m_stats) {
+                std::map<std::string, double>::iterator total = m_frameTotals.find(entry.first);
+                if (total != m_frameTotals.end()) {
+                    Stat& stat = entry.second;
+                    stat.average = stat.last == 0.0 && stat.average == 0.0 ? total->second : stat.average * 0.9 + total->second * 0.1;
+                    stat.last = total->second;
+                }
+            }
+            m_frameTotals.clear();
+
+            ++m_frame;
+            resolveGpuScopes(m_gpuScopes[m_frame % QUERY_FRAMES]);
+        }
+
+        void recordCpu(const char* name, uint32_t depth, double start, double end) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            Event event = { name, false, threadIndex(), depth, m_frame, start, end - start };
+            push(event);
+        }
+
+        // GPU scopes are issued from the GL thread only, returns the handle for endGpu()
+        GpuScopeHandle beginGpu(const char* name) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_calibrated) {
+                calibrate();
+            }
+            std::vector<GpuScope>& scopes = m_gpuScopes[m_frame % QUERY_FRAMES];
+            GpuScope scope = { name, m_gpuDepth++, m_frame, { acquireQuery(), acquireQuery() } };
+            glQueryCounter(scope.queries[0], GL_TIMESTAMP);
+            scopes.push_back(scope);
+            GpuScopeHandle handle = { m_frame, scopes.size() - 1 };
+            return handle;
+        }
+
+        // ends the scope in the slot of the frame it began in, even if beginFrame() ran in between.
+        // a scope open for QUERY_FRAMES frames has already been resolved (and dropped) with its frame
+        void endGpu(const GpuScopeHandle& handle) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            --m_gpuDepth;
+            if (m_frame - handle.frame >= QUERY_FRAMES) {
+                return;
+            }
+            glQueryCounter(m_gpuScopes[handle.frame % QUERY_FRAMES][handle.index].queries[1], GL_TIMESTAMP);
+        }
+
+        // per scope averages, sorted by name with CPU before GPU
+        std::vector<Stat> stats() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            std::vector<Stat> result;
+            for (const std::pair<const std::string, Stat>& entry : m_stats) {
+                result.push_back(entry.second);
+            }
+            return result;
+        }
+
+        // the ring buffer, oldest event first
+        std::vector<Event> events() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_events.size() < m_capacity) {
+                return m_events;
+            }
+            std::vector<Event> ordered(m_events.begin() + m_head, m_events.end());
+            ordered.insert(ordered.end(), m_events.begin(), m_events.begin() + m_head);
+            return ordered;
+        }
+
+        // Chrome trace event format, CPU threads and the GPU as separate tracks
+        bool writeChromeTrace(const std::string& path) {
+            std::vector<Event> ordered = events();
+            std::ofstream file(path);
+            if (!file) {
+                return false;
+            }
+            file << "{\"traceEvents\":[\n";
+            file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":1000,\"args\":{\"name\":\"GPU\"}}";
+            for (const Event& event : ordered) {
+                file << ",\n{\"name\":\"" << event.name << "\",\"cat\":\"" << (event.gpu ? "gpu" : "cpu")
+                     << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << (event.gpu ? 1000 : event.thread)
+                     << ",\"ts\":" << std::fixed << event.start << ",\"dur\":" << event.duration
+                     << ",\"args\":{\"frame\":" << event.frame << "}}";
+            }
+            file << "\n]}\n";
+            return static_cast<bool>(file);
+        }
+
+        uint64_t frame() const { return m_frame; }
+};
+
+// process wide profiler, created on first use
+inline Profiler& profiler() {
+    static Profiler instance;
+    return instance;
+}
+
+// RAII CPU scope, nesting depth is tracked per thread
+class ProfileScope {
+    private:
+        static uint32_t& depth() {
+            static thread_local uint32_t value = 0;
+            return value;
+        }
+
+        const char* m_name;
+        double m_start;
+
+    public:
+        explicit ProfileScope(const char* name) : m_name{ name }, m_start{ profiler().now() } {
+            ++depth();
+        }
+
+        ~ProfileScope() {
+            --depth();
+            profiler().recordCpu(m_name, depth(), m_start, profiler().now());
+        }
+
+        ProfileScope(const ProfileScope&) = delete;
+        ProfileScope& operator=(const ProfileScope&) = delete;
+};
+
+// RAII CPU + GPU scope, for code issuing GL commands on the context thread
+class GpuProfileScope {
+    private:
+        ProfileScope m_cpu;
+        Profiler::GpuScopeHandle m_scope;
+
+    public:
+        explicit GpuProfileScope(const char* name) : m_cpu(name), m_scope{ profiler().beginGpu(name) } {}
+
+        ~GpuProfileScope() {
+            profiler().endGpu(m_scope);
+        }
+
+        GpuProfileScope(const GpuProfileScope&) = delete;
+        GpuProfileScope& operator=(const GpuProfileScope&) = delete;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+// name has to outlive the profiler, i.e. a string literal
+#define PROFILE_CPU(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_GPU(name) GpuProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
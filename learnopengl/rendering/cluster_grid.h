@@ -0,0 +1,254 @@
+#pragma once
+
+#include "light_buffer.h"
+#include "../threading/thread_pool.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CLUSTER_GRID_SSE 1
+#endif
+
+// Light-to-cluster assignment for clustered shading, CPU only (see LightClusters for the GPU side).
+// The view frustum is split into dimX * dimY screen tiles and dimZ exponential depth slices. Every
+// cluster (froxel) gets a view space AABB, assign() tests each light sphere against the clusters of
+// the slices it overlaps and produces per-cluster (offset, count) ranges into one compact index list.
+// Slices are independent, so they're binned in parallel; within a slice four AABBs are tested per
+// SSE instruction.
+class ClusterGrid {
+    public:
+        struct Range {
+            uint32_t offset;
+            uint32_t count;
+        };
+
+    private:
+        // light in view space, depth is the positive distance along the view direction
+        struct ViewLight {
+            float x, y, depth, radius;
+            int sliceBegin, sliceEnd;   // inclusive
+            bool unbounded;
+        };
+
+        unsigned int m_dimX, m_dimY, m_dimZ;
+        unsigned int m_tilesPerSlice;   // dimX * dimY rounded up to a multiple of 4 for the SIMD loop
+        float m_near = 0.1f;
+        float m_far = 100.0f;
+        float m_sliceScale = 0.0f;
+        float m_sliceBias = 0.0f;
+
+        // per slice, structure of arrays over the tiles of that slice
+        std::vector<float> m_minX, m_maxX, m_minY, m_maxY;
+        std::vector<float> m_sliceNear;     // dimZ + 1 depth boundaries
+
+        std::vector<ViewLight> m_viewLights;
+        std::vector<std::vector<uint32_t>> m_clusterLights;
+        std::vector<Range> m_ranges;
+        std::vector<uint32_t> m_indices;
+
+        size_t clusterIndex(unsigned int x, unsigned int y, unsigned int z) const {
+            return (static_cast<size_t>(z) * m_dimY + y) * m_dimX + x;
+        }
+
+        int sliceOf(float depth) const {
+            if (depth <= m_near) {
+                return 0;
+            }
+            int slice = static_cast<int>(std::floor(std::log(depth) * m_sliceScale + m_sliceBias));
+            return std::min(std::max(slice, 0), static_cast<int>(m_dimZ) - 1);
+        }
+
+        void transformLights(const glm::mat4& view, const std::vector<PointLight>& lights, size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                glm::vec4 p = view * glm::vec4(lights[i].position, 1.0f);
+                ViewLight& light = m_viewLights[i];
+                light.x = p.x;
+                light.y = p.y;
+                light.depth = -p.z;
+                light.radius = lights[i].radius;
+                light.unbounded = lights[i].radius <= 0.0f;
+                if (light.unbounded) {
+                    light.sliceBegin = 0;
+                    light.sliceEnd = static_cast<int>(m_dimZ) - 1;
+                } else if (light.depth + light.radius < m_near || light.depth - light.radius > m_far) {
+                    light.sliceBegin = 0;
+                    light.sliceEnd = -1;
+                } else {
+                    light.sliceBegin = sliceOf(light.depth - light.radius);
+                    light.sliceEnd = sliceOf(light.depth + light.radius);
+                }
+            }
+        }
+
+        void binSlice(unsigned int z) {
+            const unsigned int tiles = m_dimX * m_dimY;
+            const size_t first = clusterIndex(0, 0, z);
+            for (unsigned int t = 0; t < tiles; ++t) {
+                m_clusterLights[first + t].clear();
+            }
+
+            const float sliceNear = m_sliceNear[z];
+            const float sliceFar = m_sliceNear[z + 1];
+            const float* minX = &m_minX[static_cast<size_t>(z) * m_tilesPerSlice];
+            const float* maxX = &m_maxX[static_cast<size_t>(z) * m_tilesPerSlice];
+            const float* minY = &m_minY[static_cast<size_t>(z) * m_tilesPerSlice];
+            const float* maxY = &m_maxY[static_cast<size_t>(z) * m_tilesPerSlice];
+
+            for (size_t i = 0; i < m_viewLights.size(); ++i) {
+                const ViewLight& light = m_viewLights[i];
+                if (static_cast<int>(z) < light.sliceBegin || static_cast<int>(z) > light.sliceEnd) {
+                    continue;
+                }
+                const uint32_t index = static_cast<uint32_t>(i);
+                if (light.unbounded) {
+                    for (unsigned int t = 0; t < tiles; ++t) {
+                        m_clusterLights[first + t].push_back(index);
+                    }
+                    continue;
+                }
+
+                // the depth range is shared by the whole slice, what's left of r^2 goes to x/y
+                float dz = std::max(0.0f, std::max(sliceNear - light.depth, light.depth - sliceFar));
+                float remaining = light.radius * light.radius - dz * dz;
+                if (remaining < 0.0f) {
+                    continue;
+                }
+
+#ifdef CLUSTER_GRID_SSE
+                const __m128 zero = _mm_setzero_ps();
+                const __m128 cx = _mm_set1_ps(light.x);
+                const __m128 cy = _mm_set1_ps(light.y);
+                const __m128 r2 = _mm_set1_ps(remaining);
+                for (unsigned int t = 0; t < m_tilesPerSlice; t += 4) {
+                    __m128 dx = _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(minX + t), cx), _mm_sub_ps(cx, _mm_loadu_ps(maxX + t)));
+                    __m128 dy = _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(minY + t), cy), _mm_sub_ps(cy, _mm_loadu_ps(maxY + t)));
+                    dx = _mm_max_ps(dx, zero);
+                    dy = _mm_max_ps(dy, zero);
+                    __m128 d2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+                    int mask = _mm_movemask_ps(_mm_cmple_ps(d2, r2));
+                    for (unsigned int lane = 0; mask; ++lane, mask >>= 1) {
+                        if (mask & 1) {
+                            m_clusterLights[first + t + lane].push_back(index);
+                        }
+                    }
+                }
+#else
+                for (unsigned int t = 0; t < tiles; ++t) {
+                    float dx = std::max(0.0f, std::max(minX[t] - light.x, light.x - maxX[t]));
+                    float dy = std::max(0.0f, std::max(minY[t] - light.y, light.y - maxY[t]));
+                    if (dx * dx + dy * dy <= remaining) {
+                        m_clusterLights[first + t].push_back(index);
+                    }
+                }
+#endif
+            }
+        }
+
+    public:
+        ClusterGrid(unsigned int dimX = 16, unsigned int dimY = 9, unsigned int dimZ = 24)
+            : m_dimX{ dimX }, m_dimY{ dimY }, m_dimZ{ dimZ } {
+            m_tilesPerSlice = (m_dimX * m_dimY + 3) & ~3u;
+            m_clusterLights.resize(clusterCount());
+            m_ranges.resize(clusterCount());
+        }
+
+        // rebuilds the cluster AABBs, only needed when the projection changes
+        void setProjection(float fovY, float aspect, float nearPlane, float farPlane) {
+            m_near = nearPlane;
+            m_far = farPlane;
+            float logRatio = std::log(m_far / m_near);
+            m_sliceScale = static_cast<float>(m_dimZ) / logRatio;
+            m_sliceBias = -static_cast<float>(m_dimZ) * std::log(m_near) / logRatio;
+
+            m_sliceNear.resize(m_dimZ + 1);
+            for (unsigned int z = 0; z <= m_dimZ; ++z) {
+                m_sliceNear[z] = m_near * std::pow(m_far / m_near, static_cast<float>(z) / m_dimZ);
+            }
+
+            const float inf = std::numeric_limits<float>::infinity();
+            size_t size = static_cast<size_t>(m_tilesPerSlice) * m_dimZ;
+            // padding tiles get an empty box, which never passes the overlap test
+            m_minX.assign(size, inf);
+            m_maxX.assign(size, -inf);
+            m_minY.assign(size, inf);
+            m_maxY.assign(size, -inf);
+
+            const float tanY = std::tan(fovY * 0.5f);
+            const float tanX = tanY * aspect;
+            for (unsigned int z = 0; z < m_dimZ; ++z) {
+                float depths[2] = { m_sliceNear[z], m_sliceNear[z + 1] };
+                for (unsigned int y = 0; y < m_dimY; ++y) {
+                    float ndcY0 = -1.0f + 2.0f * y / m_dimY;
+                    float ndcY1 = -1.0f + 2.0f * (y + 1) / m_dimY;
+                    for (unsigned int x = 0; x < m_dimX; ++x) {
+                        float ndcX0 = -1.0f + 2.0f * x / m_dimX;
+                        float ndcX1 = -1.0f + 2.0f * (x + 1) / m_dimX;
+                        size_t slot = static_cast<size_t>(z) * m_tilesPerSlice + y * m_dimX + x;
+                        for (float depth : depths) {
+                            m_minX[slot] = std::min(m_minX[slot], std::min(ndcX0, ndcX1) * tanX * depth);
+                            m_maxX[slot] = std::max(m_maxX[slot], std::max(ndcX0, ndcX1) * tanX * depth);
+                            m_minY[slot] = std::min(m_minY[slot], std::min(ndcY0, ndcY1) * tanY * depth);
+                            m_maxY[slot] = std::max(m_maxY[slot], std::max(ndcY0, ndcY1) * tanY * depth);
+                        }
+                    }
+                }
+            }
+        }
+
+        // bins the world space lights for the given view, pool == nullptr runs everything on the caller
+        void assign(const glm::mat4& view, const std::vector<PointLight>& lights, ThreadPool* pool = &threadPool()) {
+            m_viewLights.resize(lights.size());
+            if (pool) {
+                pool->parallelFor(lights.size(), 1024, [&](size_t begin, size_t end) {
+                    transformLights(view, lights, begin, end);
+                });
+                pool->parallelFor(m_dimZ, 1, [&](size_t begin, size_t end) {
+                    for (size_t z = begin; z < end; ++z) {
+                        binSlice(static_cast<unsigned int>(z));
+                    }
+                });
+            } else {
+                transformLights(view, lights, 0, lights.size());
+                for (unsigned int z = 0; z < m_dimZ; ++z) {
+                    binSlice(z);
+                }
+            }
+
+            // compact the per-cluster lists into one index list
+            uint32_t offset = 0;
+            for (size_t i = 0; i < m_clusterLights.size(); ++i) {
+                m_ranges[i].offset = offset;
+                m_ranges[i].count = static_cast<uint32_t>(m_clusterLights[i].size());
+                offset += m_ranges[i].count;
+            }
+            m_indices.resize(offset);
+            auto copy = [this](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    std::copy(m_clusterLights[i].begin(), m_clusterLights[i].end(), m_indices.begin() + m_ranges[i].offset);
+                }
+            };
+            if (pool) {
+                pool->parallelFor(m_clusterLights.size(), 256, copy);
+            } else {
+                copy(0, m_clusterLights.size());
+            }
+        }
+
+        const std::vector<Range>& ranges() const { return m_ranges; }
+        const std::vector<uint32_t>& indices() const { return m_indices; }
+
+        size_t clusterCount() const { return static_cast<size_t>(m_dimX) * m_dimY * m_dimZ; }
+        unsigned int dimX() const { return m_dimX; }
+        unsigned int dimY() const { return m_dimY; }
+        unsigned int dimZ() const { return m_dimZ; }
+        // slice = floor(log(depth) * sliceScale + sliceBias)
+        float sliceScale() const { return m_sliceScale; }
+        float sliceBias() const { return m_sliceBias; }
+};
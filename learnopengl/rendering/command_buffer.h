@@ -0,0 +1,121 @@
+#pragma once
+
+#include "../threading/linear_allocator.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// Backend agnostic draw commands. A CommandBuffer is filled by one recording thread: the commands
+// only carry handles and counts, uniform and per-instance data are packed into the buffer's own
+// LinearAllocator, so recording never touches the graphics API and any number of buffers can be
+// recorded in parallel. A backend (see GLCommandReplay) executes the buffers later on the thread
+// that owns the context. Handles are opaque here, the GL backend reads them as object names.
+enum class CommandType : uint8_t {
+    USE_PROGRAM,
+    BIND_TEXTURE,
+    SET_MAT4,
+    DRAW
+};
+
+// geometry of a draw, indexType 0 draws arrays
+struct CommandMesh {
+    uint32_t vertexArray = 0;
+    uint32_t mode = 0;
+    uint32_t count = 0;
+    uint32_t indexType = 0;
+};
+
+struct Command {
+    CommandType type;
+    uint32_t handle;            // program, texture or vertex array
+    uint32_t slot;              // texture unit or uniform location
+    uint32_t mode;              // DRAW: primitive mode
+    uint32_t indexType;         // DRAW: index type, 0 for arrays
+    uint32_t count;             // DRAW: elements or vertices
+    uint32_t instanceCount;     // DRAW: instances
+    const void* data;           // SET_MAT4: the matrix, DRAW: per instance data (nullptr if none)
+};
+
+class CommandBuffer {
+    private:
+        std::vector<Command> m_commands;
+        LinearAllocator m_data;
+        size_t m_instanceBytes = 0;
+        size_t m_instanceCount = 0;
+
+        Command& push(CommandType type) {
+            m_commands.push_back(Command());
+            Command& command = m_commands.back();
+            command.type = type;
+            return command;
+        }
+
+    public:
+        explicit CommandBuffer(size_t dataBlockSize = 256 * 1024) : m_data(dataBlockSize) {}
+
+        CommandBuffer(const CommandBuffer&) = delete;
+        CommandBuffer& operator=(const CommandBuffer&) = delete;
+        CommandBuffer(CommandBuffer&&) = default;
+        CommandBuffer& operator=(CommandBuffer&&) = default;
+
+        void useProgram(uint32_t program) {
+            push(CommandType::USE_PROGRAM).handle = program;
+        }
+
+        void bindTexture(uint32_t unit, uint32_t texture) {
+            Command& command = push(CommandType::BIND_TEXTURE);
+            command.handle = texture;
+            command.slot = unit;
+        }
+
+        // the matrix is copied, location as returned by the backend's uniform lookup
+        void setMat4(int location, const glm::mat4& value) {
+            glm::mat4* copy = m_data.allocate<glm::mat4>(1);
+            *copy = value;
+            Command& command = push(CommandType::SET_MAT4);
+            command.slot = static_cast<uint32_t>(location);
+            command.data = copy;
+        }
+
+        // storage for per instance data of the next drawInstanced(), written by the caller
+        glm::mat4* allocateInstances(size_t count) {
+            return m_data.allocate<glm::mat4>(count);
+        }
+
+        // instances: matrices from allocateInstances() (or nullptr), one per instance
+        void drawInstanced(const CommandMesh& mesh, uint32_t instanceCount, const glm::mat4* instances = nullptr) {
+            if (instanceCount == 0) {
+                return;
+            }
+            Command& command = push(CommandType::DRAW);
+            command.handle = mesh.vertexArray;
+            command.mode = mesh.mode;
+            command.indexType = mesh.indexType;
+            command.count = mesh.count;
+            command.instanceCount = instanceCount;
+            command.data = instances;
+            if (instances) {
+                m_instanceBytes += instanceCount * sizeof(glm::mat4);
+                m_instanceCount += instanceCount;
+            }
+        }
+
+        void draw(const CommandMesh& mesh) {
+            drawInstanced(mesh, 1);
+        }
+
+        // call at the start of the frame, keeps the allocated memory
+        void reset() {
+            m_commands.clear();
+            m_data.reset();
+            m_instanceBytes = 0;
+            m_instanceCount = 0;
+        }
+
+        const std::vector<Command>& commands() const { return m_commands; }
+        size_t instanceBytes() const { return m_instanceBytes; }
+        size_t instanceCount() const { return m_instanceCount; }
+        size_t dataBytes() const { return m_data.used(); }
+};
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+
+// a piece of this frame's segment. data is write-only, coherent memory: stores are visible to
+// draws issued after them without a flush. data is nullptr if the segment ran out of space.
+struct DynamicAllocation {
+    void* data = nullptr;
+    GLuint buffer = 0;
+    GLintptr offset = 0;
+    GLsizeiptr size = 0;
+};
+
+struct DynamicBufferStats {
+    size_t allocated = 0;       // bytes handed out this frame, padding included
+    unsigned int allocations = 0;
+    unsigned int stalls = 0;    // frames that had to wait for the GPU to release their segment
+};
+
+// Ring of SEGMENTS per-frame segments in one buffer created with glBufferStorage and mapped once,
+// persistently and coherently. Every system streaming per-frame data (vertices, instances,
+// uniforms) takes aligned sub-allocations from the current frame's segment and writes straight
+// into the mapping; there is no glBufferSubData, orphaning or map/unmap, so the driver never has
+// to synchronize or copy. endFrame() fences the segment, beginFrame() waits for the fence of the
+// segment it is about to reuse, which was submitted SEGMENTS - 1 frames earlier and is normally
+// long done. The buffer name never changes, VAOs and bindings can point at it once and select the
+// data by offset. The buffer is never deleted, it goes away with the context. GL thread only.
+class DynamicBufferRing {
+    private:
+        static const unsigned int SEGMENTS = 3;
+
+        GLuint m_buffer = 0;
+        unsigned char* m_mapping = nullptr;
+        size_t m_segmentSize;
+        unsigned int m_segment = 0;
+        size_t m_offset = 0;                // next free byte in the current segment
+        GLsync m_fences[SEGMENTS] = {};
+        DynamicBufferStats m_stats;
+        bool m_reportedFull = false;
+
+        void create() {
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glCreateBuffers(1, &m_buffer);
+            glNamedBufferStorage(m_buffer, m_segmentSize * SEGMENTS, nullptr, flags);
+            m_mapping = static_cast<unsigned char*>(glMapNamedBufferRange(m_buffer, 0, m_segmentSize * SEGMENTS, flags));
+            if (!m_mapping) {
+                std::cout << "ERROR::DYNAMIC_BUFFER::MAP_FAILED" << std::endl;
+            }
+        }
+
+    public:
+        // segmentSize: bytes one frame can allocate, kept a multiple of 256 so every segment
+        // starts at an offset any binding accepts
+        explicit DynamicBufferRing(size_t segmentSize = 4 * 1024 * 1024) : m_segmentSize{ (segmentSize + 255) & ~size_t(255) } {}
+
+        DynamicBufferRing(const DynamicBufferRing&) = delete;
+        DynamicBufferRing& operator=(const DynamicBufferRing&) = delete;
+
+        // only before the first use, the buffer keeps its size once created
+        void setSegmentSize(size_t segmentSize) {
+            if (m_buffer) {
+                std::cout << "ERROR::DYNAMIC_BUFFER::ALREADY_CREATED" << std::endl;
+                return;
+            }
+            m_segmentSize = (segmentSize + 255) & ~size_t(255);
+        }
+
+        void beginFrame() {
+            if (!m_buffer) {
+                create();
+            }
+            m_segment = (m_segment + 1) % SEGMENTS;
+            m_offset = 0;
+            m_stats = DynamicBufferStats();
+            GLsync& fence = m_fences[m_segment];
+            if (fence) {
+                GLenum result = glClientWaitSync(fence, 0, 0);
+                if (result == GL_TIMEOUT_EXPIRED) {
+                    ++m_stats.stalls;
+                    // the flush makes sure the fence gets submitted, otherwise this could wait forever
+                    while (result == GL_TIMEOUT_EXPIRED) {
+                        result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+                    }
+                }
+                glDeleteSync(fence);
+                fence = nullptr;
+            }
+        }
+
+        // after the last draw reading this frame's allocations
+        void endFrame() {
+            if (m_buffer) {
+                m_fences[m_segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            }
+        }
+
+        // alignment has to be a power of two, at most 256
+        DynamicAllocation allocate(size_t size, size_t alignment = 16) {
+            if (!m_buffer) {
+                create();
+            }
+            DynamicAllocation allocation;
+            size_t offset = (m_offset + alignment - 1) & ~(alignment - 1);
+            if (!m_mapping || offset + size > m_segmentSize) {
+                if (!m_reportedFull) {
+                    std::cout << "ERROR::DYNAMIC_BUFFER::SEGMENT_FULL " << size << " bytes requested, " << m_segmentSize - m_offset << " left" << std::endl;
+                    m_reportedFull = true;
+                }
+                return allocation;
+            }
+            m_stats.allocated += offset + size - m_offset;
+            ++m_stats.allocations;
+            m_offset = offset + size;
+
+            allocation.buffer = m_buffer;
+            allocation.offset = static_cast<GLintptr>(m_segment * m_segmentSize + offset);
+            allocation.size = static_cast<GLsizeiptr>(size);
+            allocation.data = m_mapping + allocation.offset;
+            return allocation;
+        }
+
+        GLuint buffer() {
+            if (!m_buffer) {
+                create();
+            }
+            return m_buffer;
+        }
+
+        size_t segmentSize() const { return m_segmentSize; }
+        // counters of the current frame
+        const DynamicBufferStats& stats() const { return m_stats; }
+};
+
+// per-frame streaming memory of the (single) GL context
+inline DynamicBufferRing& dynamicBuffers() {
+    static DynamicBufferRing instance;
+    return instance;
+}
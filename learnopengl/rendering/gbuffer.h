@@ -0,0 +1,192 @@
+#pragma once
+
+#include "../shader.h"
+#include "gl_state.h"
+
+#include <glad/glad.h>
+
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+// G-buffer layouts of the deferred path (shaders/geometry_pass.fs, shaders/lighting_pass.fs).
+//   CLASSIC: world position RGBA32F, normal RGBA16F, albedo + specular RGBA8, depth only for testing
+//   COMPACT: octahedral normal RG16_SNORM, albedo + specular RGBA8, position rebuilt from the depth texture
+enum class GBufferLayout {
+    CLASSIC,
+    COMPACT
+};
+
+struct GBufferTarget {
+    const char* name;           // sampler name in lighting_pass.fs
+    GLenum internalFormat;
+    unsigned int bytesPerPixel;
+    bool depth;
+    bool readByLighting;
+};
+
+inline std::vector<GBufferTarget> gbufferTargets(GBufferLayout layout) {
+    if (layout == GBufferLayout::COMPACT) {
+        return {
+            { "gNormal",     GL_RG16_SNORM,          4, false, true },
+            { "gAlbedoSpec", GL_RGBA8,               4, false, true },
+            { "gDepth",      GL_DEPTH_COMPONENT32F,  4, true,  true },
+        };
+    }
+    return {
+        { "gPosition",   GL_RGBA32F,             16, false, true },
+        { "gNormal",     GL_RGBA16F,              8, false, true },
+        { "gAlbedoSpec", GL_RGBA8,                4, false, true },
+        { "gDepth",      GL_DEPTH_COMPONENT32F,   4, true,  false },
+    };
+}
+
+inline const char* gbufferLayoutName(GBufferLayout layout) {
+    return layout == GBufferLayout::COMPACT ? "compact" : "classic";
+}
+
+// bytes per pixel the geometry pass writes and the lighting pass fetches (one fetch per target)
+struct GBufferBandwidth {
+    unsigned int writeBytesPerPixel = 0;
+    unsigned int readBytesPerPixel = 0;
+};
+
+inline GBufferBandwidth gbufferBandwidth(GBufferLayout layout) {
+    GBufferBandwidth bandwidth;
+    for (const GBufferTarget& target : gbufferTargets(layout)) {
+        bandwidth.writeBytesPerPixel += target.bytesPerPixel;
+        if (target.readByLighting) {
+            bandwidth.readBytesPerPixel += target.bytesPerPixel;
+        }
+    }
+    return bandwidth;
+}
+
+// prints the per layout cost at the given resolution, ignoring caches and framebuffer compression
+inline void reportGBufferBandwidth(unsigned int width, unsigned int height) {
+    const double pixels = static_cast<double>(width) * height;
+    const double classicRead = gbufferBandwidth(GBufferLayout::CLASSIC).readBytesPerPixel;
+
+    std::cout << "G-buffer bandwidth at " << width << "x" << height << std::endl;
+    std::cout << std::fixed << std::setprecision(1);
+    for (GBufferLayout layout : { GBufferLayout::CLASSIC, GBufferLayout::COMPACT }) {
+        GBufferBandwidth bandwidth = gbufferBandwidth(layout);
+        std::cout << "  " << std::setw(8) << gbufferLayoutName(layout) << ":";
+        for (const GBufferTarget& target : gbufferTargets(layout)) {
+            std::cout << " " << target.name << " " << target.bytesPerPixel << "B" << (target.readByLighting ? "" : " (not read)");
+        }
+        std::cout << std::endl;
+        std::cout << "            geometry writes " << bandwidth.writeBytesPerPixel << " B/px, "
+                  << bandwidth.writeBytesPerPixel * pixels / (1024.0 * 1024.0) << " MiB per frame" << std::endl;
+        std::cout << "            lighting reads  " << bandwidth.readBytesPerPixel << " B/px, "
+                  << bandwidth.readBytesPerPixel * pixels / (1024.0 * 1024.0) << " MiB per frame ("
+                  << 100.0 * bandwidth.readBytesPerPixel / classicRead << "% of classic)" << std::endl;
+    }
+}
+
+// Framebuffer with the render targets of one layout. Color attachments follow the output locations
+// of geometry_pass.fs, bindTextures() binds the targets the lighting pass reads to consecutive units
+// in declaration order (see setSamplers).
+class GBuffer {
+    private:
+        GBufferLayout m_layout;
+        unsigned int m_fbo = 0;
+        std::vector<GBufferTarget> m_targets;
+        std::vector<unsigned int> m_textures;
+        unsigned int m_width = 0;
+        unsigned int m_height = 0;
+
+        void release() {
+            if (!m_textures.empty()) {
+                for (unsigned int texture : m_textures) {
+                    glState().forgetTexture(texture);
+                }
+                glDeleteTextures(static_cast<GLsizei>(m_textures.size()), m_textures.data());
+                m_textures.clear();
+            }
+        }
+
+    public:
+        GBuffer(GBufferLayout layout, unsigned int width, unsigned int height) : m_layout{ layout }, m_targets{ gbufferTargets(layout) } {
+            glCreateFramebuffers(1, &m_fbo);
+            resize(width, height);
+        }
+
+        ~GBuffer() {
+            release();
+            glState().forgetFramebuffer(m_fbo);
+            glDeleteFramebuffers(1, &m_fbo);
+        }
+
+        GBuffer(const GBuffer&) = delete;
+        GBuffer& operator=(const GBuffer&) = delete;
+
+        void resize(unsigned int width, unsigned int height) {
+            if (width == m_width && height == m_height) {
+                return;
+            }
+            release();
+            m_width = width;
+            m_height = height;
+
+            m_textures.resize(m_targets.size());
+            glCreateTextures(GL_TEXTURE_2D, static_cast<GLsizei>(m_textures.size()), m_textures.data());
+            std::vector<GLenum> drawBuffers;
+            for (size_t i = 0; i < m_targets.size(); ++i) {
+                glTextureStorage2D(m_textures[i], 1, m_targets[i].internalFormat, m_width, m_height);
+                glTextureParameteri(m_textures[i], GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+                glTextureParameteri(m_textures[i], GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+                glTextureParameteri(m_textures[i], GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+                glTextureParameteri(m_textures[i], GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+                if (m_targets[i].depth) {
+                    glNamedFramebufferTexture(m_fbo, GL_DEPTH_ATTACHMENT, m_textures[i], 0);
+                } else {
+                    GLenum attachment = GL_COLOR_ATTACHMENT0 + static_cast<GLenum>(drawBuffers.size());
+                    glNamedFramebufferTexture(m_fbo, attachment, m_textures[i], 0);
+                    drawBuffers.push_back(attachment);
+                }
+            }
+            glNamedFramebufferDrawBuffers(m_fbo, static_cast<GLsizei>(drawBuffers.size()), drawBuffers.data());
+            if (glCheckNamedFramebufferStatus(m_fbo, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+                std::cout << "ERROR::GBUFFER::FRAMEBUFFER_INCOMPLETE (" << gbufferLayoutName(m_layout) << ")" << std::endl;
+            }
+        }
+
+        // geometry pass target
+        void bind() const {
+            glState().bindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+        }
+
+        // points the lighting shader's samplers at the units bindTextures() uses
+        void setSamplers(Shader& shader, int firstUnit = 0) const {
+            int unit = firstUnit;
+            for (const GBufferTarget& target : m_targets) {
+                if (target.readByLighting) {
+                    shader.setInt(std::string(target.name), unit++);
+                }
+            }
+        }
+
+        void bindTextures(unsigned int firstUnit = 0) const {
+            unsigned int unit = firstUnit;
+            for (size_t i = 0; i < m_targets.size(); ++i) {
+                if (m_targets[i].readByLighting) {
+                    glState().bindTexture(unit++, m_textures[i]);
+                }
+            }
+        }
+
+        // defines selecting the matching code path in geometry_pass.fs / lighting_pass.fs
+        ShaderDefines defines() const {
+            ShaderDefines defines;
+            if (m_layout == GBufferLayout::COMPACT) {
+                defines.set("GBUFFER_COMPACT");
+            }
+            return defines;
+        }
+
+        GBufferLayout layout() const { return m_layout; }
+        unsigned int id() const { return m_fbo; }
+        unsigned int width() const { return m_width; }
+        unsigned int height() const { return m_height; }
+};
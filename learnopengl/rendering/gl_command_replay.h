@@ -0,0 +1,144 @@
+#pragma once
+
+#include "command_buffer.h"
+#include "dynamic_buffer.h"
+#include "gl_state.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+struct CommandReplayStats {
+    unsigned int commands = 0;
+    unsigned int draws = 0;
+    unsigned int instances = 0;
+    size_t uploadedBytes = 0;
+    double milliseconds = 0.0;
+};
+
+// GL backend of CommandBuffer, runs on the context thread. replay() first copies the per instance
+// data of all buffers into one allocation from the frame's DynamicBufferRing, then executes the
+// commands in buffer order through the state cache. Instanced attributes read the whole ring and
+// start at the draw's base instance, so VAOs are attached to it once and never rebound per draw.
+// The ring has to fit a frame's instances (64 bytes each), see DynamicBufferRing::setSegmentSize.
+class GLCommandReplay {
+    private:
+        static const GLuint INSTANCE_BINDING = 8;   // above the bindings glVertexAttribPointer uses for attributes 0-7
+
+        DynamicBufferRing& m_ring;
+        std::vector<GLuint> m_baseInstances;        // per DRAW command in replay order
+        CommandReplayStats m_stats;
+
+    public:
+        explicit GLCommandReplay(DynamicBufferRing& ring = dynamicBuffers()) : m_ring(ring) {}
+
+        GLCommandReplay(const GLCommandReplay&) = delete;
+        GLCommandReplay& operator=(const GLCommandReplay&) = delete;
+
+        // sources the mat4 attribute at [location, location + 4) of the VAO from the instance stream
+        void attachInstanceAttributes(GLuint vertexArray, GLuint location) {
+            glVertexArrayVertexBuffer(vertexArray, INSTANCE_BINDING, m_ring.buffer(), 0, sizeof(glm::mat4));
+            glVertexArrayBindingDivisor(vertexArray, INSTANCE_BINDING, 1);
+            for (GLuint column = 0; column < 4; ++column) {
+                glEnableVertexArrayAttrib(vertexArray, location + column);
+                glVertexArrayAttribFormat(vertexArray, location + column, 4, GL_FLOAT, GL_FALSE, column * sizeof(glm::vec4));
+                glVertexArrayAttribBinding(vertexArray, location + column, INSTANCE_BINDING);
+            }
+        }
+
+        void replay(const std::vector<const CommandBuffer*>& buffers) {
+            auto start = std::chrono::steady_clock::now();
+            m_stats = CommandReplayStats();
+
+            // lay out the instance data, draws sharing a block (e.g. the meshes of one model) share it.
+            // draws without instance data in between don't break the sharing, so the block's base is
+            // kept next to it rather than read back from the previous draw
+            m_baseInstances.clear();
+            size_t instances = 0;
+            const void* lastData = nullptr;
+            GLuint lastBase = 0;
+            for (const CommandBuffer* buffer : buffers) {
+                for (const Command& command : buffer->commands()) {
+                    if (command.type != CommandType::DRAW) {
+                        continue;
+                    }
+                    if (command.data && command.data != lastData) {
+                        lastData = command.data;
+                        lastBase = static_cast<GLuint>(instances);
+                        instances += command.instanceCount;
+                    }
+                    m_baseInstances.push_back(command.data ? lastBase : 0);
+                }
+            }
+
+            // mat4 aligned, so the allocation starts at a whole instance of the ring
+            size_t bytes = instances * sizeof(glm::mat4);
+            bool uploaded = true;
+            if (bytes > 0) {
+                DynamicAllocation allocation = m_ring.allocate(bytes, sizeof(glm::mat4));
+                unsigned char* mapped = static_cast<unsigned char*>(allocation.data);
+                uploaded = mapped != nullptr;
+                if (mapped) {
+                    GLuint first = static_cast<GLuint>(allocation.offset / sizeof(glm::mat4));
+                    size_t draw = 0;
+                    lastData = nullptr;
+                    for (const CommandBuffer* buffer : buffers) {
+                        for (const Command& command : buffer->commands()) {
+                            if (command.type != CommandType::DRAW) {
+                                continue;
+                            }
+                            if (command.data && command.data != lastData) {
+                                lastData = command.data;
+                                std::memcpy(mapped + m_baseInstances[draw] * sizeof(glm::mat4), command.data, command.instanceCount * sizeof(glm::mat4));
+                            }
+                            if (command.data) {
+                                m_baseInstances[draw] += first;
+                            }
+                            ++draw;
+                        }
+                    }
+                    m_stats.uploadedBytes = bytes;
+                }
+            }
+
+            size_t draw = 0;
+            for (const CommandBuffer* buffer : buffers) {
+                for (const Command& command : buffer->commands()) {
+                    switch (command.type) {
+                        case CommandType::USE_PROGRAM:
+                            glState().useProgram(command.handle);
+                            break;
+                        case CommandType::BIND_TEXTURE:
+                            glState().bindTexture(command.slot, command.handle);
+                            break;
+                        case CommandType::SET_MAT4:
+                            glUniformMatrix4fv(static_cast<GLint>(command.slot), 1, GL_FALSE, static_cast<const float*>(command.data));
+                            break;
+                        case CommandType::DRAW: {
+                            GLuint baseInstance = m_baseInstances[draw++];
+                            if (command.data && !uploaded) {
+                                break;
+                            }
+                            glState().bindVertexArray(command.handle);
+                            if (command.indexType) {
+                                glDrawElementsInstancedBaseInstance(command.mode, command.count, command.indexType, nullptr, command.instanceCount, baseInstance);
+                            } else {
+                                glDrawArraysInstancedBaseInstance(command.mode, 0, command.count, command.instanceCount, baseInstance);
+                            }
+                            ++m_stats.draws;
+                            m_stats.instances += command.instanceCount;
+                            break;
+                        }
+                    }
+                    ++m_stats.commands;
+                }
+            }
+            m_stats.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        // counters of the last replay()
+        const CommandReplayStats& stats() const { return m_stats; }
+};
@@ -0,0 +1,251 @@
+#pragma once
+
+#include <glad/glad.h>
+
+// issued: calls forwarded to the driver, filtered: calls dropped because the state was already set
+struct GLStateStats {
+    unsigned int issued = 0;
+    unsigned int filtered = 0;
+};
+
+// Shadow copy of the context's bindings and fixed function state. Every setter compares against the
+// last value it set and only calls GL when it differs, so code can bind what it needs before each
+// draw without paying for redundant driver calls (and without unbinding afterwards). Only calls made
+// through the cache are tracked: code that changes this state directly, or deletes an object that
+// may still be bound, has to call invalidate()/forget*() afterwards. Textures are bound with
+// glBindTextureUnit, which leaves the active texture selector alone. GL thread only.
+class GLStateCache {
+    private:
+        static const GLuint UNKNOWN = ~0u;
+        static const unsigned int MAX_UNITS = 32;
+
+        enum Capability {
+            CAP_BLEND = 0,
+            CAP_DEPTH_TEST,
+            CAP_CULL_FACE,
+            CAP_SCISSOR_TEST,
+            CAP_STENCIL_TEST,
+            CAP_COUNT
+        };
+
+        GLuint m_program;
+        GLuint m_vertexArray;
+        GLuint m_drawFramebuffer;
+        GLuint m_readFramebuffer;
+        GLuint m_textures[MAX_UNITS];
+        GLuint m_samplers[MAX_UNITS];
+        int m_capabilities[CAP_COUNT];      // -1 unknown
+        GLenum m_blendSource;
+        GLenum m_blendDestination;
+        GLenum m_depthFunc;
+        int m_depthMask;
+        GLenum m_cullFace;
+        GLint m_viewport[4];
+
+        GLStateStats m_stats;
+
+        static int capabilityIndex(GLenum capability) {
+            switch (capability) {
+                case GL_BLEND: return CAP_BLEND;
+                case GL_DEPTH_TEST: return CAP_DEPTH_TEST;
+                case GL_CULL_FACE: return CAP_CULL_FACE;
+                case GL_SCISSOR_TEST: return CAP_SCISSOR_TEST;
+                case GL_STENCIL_TEST: return CAP_STENCIL_TEST;
+                default: return -1;
+            }
+        }
+
+        // records the new value and returns true when the call has to be issued
+        template <typename T>
+        bool update(T& cached, T value) {
+            if (cached == value) {
+                ++m_stats.filtered;
+                return false;
+            }
+            cached = value;
+            ++m_stats.issued;
+            return true;
+        }
+
+        void setCapability(GLenum capability, bool enabled) {
+            int index = capabilityIndex(capability);
+            if (index < 0) {
+                ++m_stats.issued;
+            } else if (!update(m_capabilities[index], enabled ? 1 : 0)) {
+                return;
+            }
+            if (enabled) {
+                glEnable(capability);
+            } else {
+                glDisable(capability);
+            }
+        }
+
+    public:
+        GLStateCache() {
+            invalidate();
+        }
+
+        GLStateCache(const GLStateCache&) = delete;
+        GLStateCache& operator=(const GLStateCache&) = delete;
+
+        // forgets everything, the next call of every setter is issued
+        void invalidate() {
+            m_program = UNKNOWN;
+            m_vertexArray = UNKNOWN;
+            m_drawFramebuffer = UNKNOWN;
+            m_readFramebuffer = UNKNOWN;
+            for (unsigned int i = 0; i < MAX_UNITS; ++i) {
+                m_textures[i] = UNKNOWN;
+                m_samplers[i] = UNKNOWN;
+            }
+            for (int& capability : m_capabilities) {
+                capability = -1;
+            }
+            m_blendSource = UNKNOWN;
+            m_blendDestination = UNKNOWN;
+            m_depthFunc = UNKNOWN;
+            m_depthMask = -1;
+            m_cullFace = UNKNOWN;
+            m_viewport[0] = m_viewport[1] = m_viewport[2] = m_viewport[3] = -1;
+        }
+
+        // call before deleting an object that may be bound through the cache, GL unbinds deleted
+        // objects and a recycled name would otherwise be mistaken for the bound one
+        void forgetProgram(GLuint program) {
+            if (m_program == program) {
+                m_program = UNKNOWN;
+            }
+        }
+
+        void forgetVertexArray(GLuint vertexArray) {
+            if (m_vertexArray == vertexArray) {
+                m_vertexArray = UNKNOWN;
+            }
+        }
+
+        void forgetFramebuffer(GLuint framebuffer) {
+            if (m_drawFramebuffer == framebuffer) {
+                m_drawFramebuffer = UNKNOWN;
+            }
+            if (m_readFramebuffer == framebuffer) {
+                m_readFramebuffer = UNKNOWN;
+            }
+        }
+
+        void forgetTexture(GLuint texture) {
+            for (GLuint& bound : m_textures) {
+                if (bound == texture) {
+                    bound = UNKNOWN;
+                }
+            }
+        }
+
+        void useProgram(GLuint program) {
+            if (update(m_program, program)) {
+                glUseProgram(program);
+            }
+        }
+
+        void bindVertexArray(GLuint vertexArray) {
+            if (update(m_vertexArray, vertexArray)) {
+                glBindVertexArray(vertexArray);
+            }
+        }
+
+        // GL_FRAMEBUFFER binds both the draw and the read framebuffer
+        void bindFramebuffer(GLenum target, GLuint framebuffer) {
+            if (target == GL_FRAMEBUFFER) {
+                if (m_drawFramebuffer == framebuffer && m_readFramebuffer == framebuffer) {
+                    ++m_stats.filtered;
+                    return;
+                }
+                m_drawFramebuffer = m_readFramebuffer = framebuffer;
+                ++m_stats.issued;
+                glBindFramebuffer(target, framebuffer);
+            } else if (update(target == GL_READ_FRAMEBUFFER ? m_readFramebuffer : m_drawFramebuffer, framebuffer)) {
+                glBindFramebuffer(target, framebuffer);
+            }
+        }
+
+        // binds the texture to its own target on the unit, 0 unbinds every target of the unit
+        void bindTexture(unsigned int unit, GLuint texture) {
+            if (unit >= MAX_UNITS) {
+                ++m_stats.issued;
+                glBindTextureUnit(unit, texture);
+            } else if (update(m_textures[unit], texture)) {
+                glBindTextureUnit(unit, texture);
+            }
+        }
+
+        void bindSampler(unsigned int unit, GLuint sampler) {
+            if (unit >= MAX_UNITS) {
+                ++m_stats.issued;
+                glBindSampler(unit, sampler);
+            } else if (update(m_samplers[unit], sampler)) {
+                glBindSampler(unit, sampler);
+            }
+        }
+
+        // GL_BLEND, GL_DEPTH_TEST, GL_CULL_FACE, GL_SCISSOR_TEST and GL_STENCIL_TEST are tracked,
+        // other capabilities are passed through
+        void enable(GLenum capability) {
+            setCapability(capability, true);
+        }
+
+        void disable(GLenum capability) {
+            setCapability(capability, false);
+        }
+
+        void blendFunc(GLenum source, GLenum destination) {
+            if (m_blendSource == source && m_blendDestination == destination) {
+                ++m_stats.filtered;
+                return;
+            }
+            m_blendSource = source;
+            m_blendDestination = destination;
+            ++m_stats.issued;
+            glBlendFunc(source, destination);
+        }
+
+        void depthFunc(GLenum func) {
+            if (update(m_depthFunc, func)) {
+                glDepthFunc(func);
+            }
+        }
+
+        void depthMask(bool write) {
+            if (update(m_depthMask, write ? 1 : 0)) {
+                glDepthMask(write ? GL_TRUE : GL_FALSE);
+            }
+        }
+
+        void cullFace(GLenum face) {
+            if (update(m_cullFace, face)) {
+                glCullFace(face);
+            }
+        }
+
+        void viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+            if (m_viewport[0] == x && m_viewport[1] == y && m_viewport[2] == width && m_viewport[3] == height) {
+                ++m_stats.filtered;
+                return;
+            }
+            m_viewport[0] = x;
+            m_viewport[1] = y;
+            m_viewport[2] = width;
+            m_viewport[3] = height;
+            ++m_stats.issued;
+            glViewport(x, y, width, height);
+        }
+
+        // per-frame counters, reset them at the start of every frame
+        const GLStateStats& stats() const { return m_stats; }
+        void resetStats() { m_stats = GLStateStats(); }
+};
+
+// state cache of the (single) GL context
+inline GLStateCache& glState() {
+    static GLStateCache instance;
+    return instance;
+}
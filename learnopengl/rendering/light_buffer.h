@@ -0,0 +1,163 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+// point light as stored in the light SSBO, mirrors PointLight in shaders/include/lights.glsl.
+// std430 lays the vec3/float pairs out back to back, so the struct matches the C++ layout as is.
+struct PointLight {
+    glm::vec3 position;
+    float radius = 0.0f;        // influence radius, lights are skipped beyond it (0 = unbounded)
+    glm::vec3 color;
+    float linear = 0.0f;        // attenuation = 1 / (1 + linear * d + quadratic * d^2)
+    float quadratic = 0.0f;
+    float padding[3] = {};
+};
+static_assert(offsetof(PointLight, position) == 0, "std430 layout of PointLight");
+static_assert(offsetof(PointLight, radius) == 12, "std430 layout of PointLight");
+static_assert(offsetof(PointLight, color) == 16, "std430 layout of PointLight");
+static_assert(offsetof(PointLight, linear) == 28, "std430 layout of PointLight");
+static_assert(offsetof(PointLight, quadratic) == 32, "std430 layout of PointLight");
+static_assert(sizeof(PointLight) == 48, "std430 array stride of PointLight");
+
+// distance at which 1 / (constant + linear * d + quadratic * d^2) scales the brightest channel of
+// 'color' below 'threshold', i.e. where the light stops being visible. with threshold 5/256 the cut
+// off stays below what an 8 bit target can show. returns 0 (unbounded) when there is no falloff.
+inline float attenuationRadius(const glm::vec3& color, float linear, float quadratic,
+                               float constant = 1.0f, float threshold = 5.0f / 256.0f) {
+    if (linear <= 0.0f && quadratic <= 0.0f) {
+        return 0.0f;
+    }
+    float brightest = std::max(std::max(color.r, color.g), color.b);
+    float c = constant - brightest / threshold;
+    if (c >= 0.0f) {
+        return 1e-4f;   // never bright enough to show, keep it bounded so it's culled everywhere
+    }
+    if (quadratic <= 0.0f) {
+        return -c / linear;
+    }
+    return (-linear + std::sqrt(linear * linear - 4.0f * quadratic * c)) / (2.0f * quadratic);
+}
+
+// point light with linear/quadratic falloff and the matching radius
+inline PointLight attenuatedLight(const glm::vec3& position, const glm::vec3& color, float linear, float quadratic) {
+    PointLight light;
+    light.position = position;
+    light.color = color;
+    light.linear = linear;
+    light.quadratic = quadratic;
+    light.radius = attenuationRadius(color, linear, quadratic);
+    return light;
+}
+
+// Owns the lights of a scene and their shader storage buffer: a 16 byte header holding the light
+// count, followed by the PointLight array. Edits only mark the touched range dirty, upload() then
+// writes that range (and the count when it changed) and grows the buffer when it's too small.
+class LightBuffer {
+    private:
+        static const size_t HEADER_SIZE = 16;
+
+        unsigned int m_buffer = 0;
+        GLuint m_binding;
+        size_t m_capacity = 0;
+        std::vector<PointLight> m_lights;
+        size_t m_dirtyBegin = 0;
+        size_t m_dirtyEnd = 0;
+        bool m_countDirty = true;
+
+        void markDirty(size_t begin, size_t end) {
+            if (m_dirtyBegin == m_dirtyEnd) {
+                m_dirtyBegin = begin;
+                m_dirtyEnd = end;
+            } else {
+                m_dirtyBegin = std::min(m_dirtyBegin, begin);
+                m_dirtyEnd = std::max(m_dirtyEnd, end);
+            }
+        }
+
+        void allocate(size_t capacity) {
+            m_capacity = capacity;
+            glNamedBufferData(m_buffer, HEADER_SIZE + m_capacity * sizeof(PointLight), nullptr, GL_DYNAMIC_DRAW);
+            markDirty(0, m_lights.size());
+            m_countDirty = true;
+        }
+
+    public:
+        explicit LightBuffer(GLuint binding, size_t capacity = 64) : m_binding{ binding } {
+            glCreateBuffers(1, &m_buffer);
+            allocate(std::max<size_t>(capacity, 1));
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, m_binding, m_buffer);
+        }
+
+        ~LightBuffer() {
+            glDeleteBuffers(1, &m_buffer);
+        }
+
+        LightBuffer(const LightBuffer&) = delete;
+        LightBuffer& operator=(const LightBuffer&) = delete;
+
+        // returns the index of the new light
+        size_t add(const PointLight& light) {
+            m_lights.push_back(light);
+            markDirty(m_lights.size() - 1, m_lights.size());
+            m_countDirty = true;
+            return m_lights.size() - 1;
+        }
+
+        void set(size_t index, const PointLight& light) {
+            m_lights[index] = light;
+            markDirty(index, index + 1);
+        }
+
+        // mutable access, marks the light dirty
+        PointLight& edit(size_t index) {
+            markDirty(index, index + 1);
+            return m_lights[index];
+        }
+
+        // removes a light by moving the last one into its slot, indices past it aren't stable
+        void remove(size_t index) {
+            if (index + 1 != m_lights.size()) {
+                m_lights[index] = m_lights.back();
+                markDirty(index, index + 1);
+            }
+            m_lights.pop_back();
+            m_dirtyEnd = std::min(m_dirtyEnd, m_lights.size());
+            m_countDirty = true;
+        }
+
+        void clear() {
+            m_lights.clear();
+            m_dirtyBegin = m_dirtyEnd = 0;
+            m_countDirty = true;
+        }
+
+        // writes the pending changes, typically once per frame before drawing
+        void upload() {
+            if (m_lights.size() > m_capacity)
+                allocate(std::max(m_lights.size(), m_capacity * 2));
+
+            if (m_countDirty) {
+                GLuint count = static_cast<GLuint>(m_lights.size());
+                glNamedBufferSubData(m_buffer, 0, sizeof(count), &count);
+                m_countDirty = false;
+            }
+            if (m_dirtyBegin < m_dirtyEnd) {
+                glNamedBufferSubData(m_buffer, HEADER_SIZE + m_dirtyBegin * sizeof(PointLight),
+                    (m_dirtyEnd - m_dirtyBegin) * sizeof(PointLight), &m_lights[m_dirtyBegin]);
+            }
+            m_dirtyBegin = m_dirtyEnd = 0;
+        }
+
+        const PointLight& operator[](size_t index) const { return m_lights[index]; }
+        const std::vector<PointLight>& lights() const { return m_lights; }
+        size_t size() const { return m_lights.size(); }
+
+        unsigned int id() const { return m_buffer; }
+        GLuint binding() const { return m_binding; }
+};
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "cluster_grid.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <chrono>
+
+// GPU side of clustered shading, mirrors shaders/include/clusters.glsl. Owns a ClusterGrid and two
+// shader storage buffers: the cluster ranges (behind a small header with the grid parameters) and
+// the compact light index list. update() bins the lights on the CPU and uploads both each frame.
+class LightClusters {
+    private:
+        struct Header {
+            GLuint grid[4];     // cluster counts x, y, z
+            float depth[4];     // slice scale, slice bias, tile width and height in pixels
+        };
+        static_assert(sizeof(Header) == 32, "std430 layout of the cluster header");
+        static_assert(sizeof(ClusterGrid::Range) == 8, "std430 layout of uvec2");
+
+        ClusterGrid m_grid;
+        unsigned int m_clusterBuffer = 0;
+        unsigned int m_indexBuffer = 0;
+        size_t m_indexCapacity = 0;
+        double m_binMilliseconds = 0.0;
+
+    public:
+        LightClusters(GLuint clusterBinding, GLuint indexBinding, unsigned int dimX = 16, unsigned int dimY = 9, unsigned int dimZ = 24)
+            : m_grid(dimX, dimY, dimZ) {
+            glCreateBuffers(1, &m_clusterBuffer);
+            glNamedBufferData(m_clusterBuffer, sizeof(Header) + m_grid.clusterCount() * sizeof(ClusterGrid::Range), nullptr, GL_DYNAMIC_DRAW);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, clusterBinding, m_clusterBuffer);
+
+            m_indexCapacity = 4 * m_grid.clusterCount();
+            glCreateBuffers(1, &m_indexBuffer);
+            glNamedBufferData(m_indexBuffer, m_indexCapacity * sizeof(uint32_t), nullptr, GL_DYNAMIC_DRAW);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, indexBinding, m_indexBuffer);
+        }
+
+        ~LightClusters() {
+            glDeleteBuffers(1, &m_clusterBuffer);
+            glDeleteBuffers(1, &m_indexBuffer);
+        }
+
+        LightClusters(const LightClusters&) = delete;
+        LightClusters& operator=(const LightClusters&) = delete;
+
+        // call whenever the projection or the viewport changes
+        void setProjection(float fovY, float aspect, float nearPlane, float farPlane, unsigned int width, unsigned int height) {
+            m_grid.setProjection(fovY, aspect, nearPlane, farPlane);
+
+            Header header = {
+                { m_grid.dimX(), m_grid.dimY(), m_grid.dimZ(), 0 },
+                { m_grid.sliceScale(), m_grid.sliceBias(),
+                  static_cast<float>(width) / m_grid.dimX(), static_cast<float>(height) / m_grid.dimY() }
+            };
+            glNamedBufferSubData(m_clusterBuffer, 0, sizeof(Header), &header);
+        }
+
+        void update(const glm::mat4& view, const std::vector<PointLight>& lights) {
+            auto start = std::chrono::high_resolution_clock::now();
+            m_grid.assign(view, lights);
+            m_binMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+            const std::vector<ClusterGrid::Range>& ranges = m_grid.ranges();
+            glNamedBufferSubData(m_clusterBuffer, sizeof(Header), ranges.size() * sizeof(ClusterGrid::Range), ranges.data());
+
+            const std::vector<uint32_t>& indices = m_grid.indices();
+            if (indices.size() > m_indexCapacity) {
+                m_indexCapacity = std::max(indices.size(), m_indexCapacity * 2);
+                glNamedBufferData(m_indexBuffer, m_indexCapacity * sizeof(uint32_t), nullptr, GL_DYNAMIC_DRAW);
+            }
+            if (!indices.empty()) {
+                glNamedBufferSubData(m_indexBuffer, 0, indices.size() * sizeof(uint32_t), indices.data());
+            }
+        }
+
+        const ClusterGrid& grid() const { return m_grid; }
+        // CPU time of the last binning
+        double binMilliseconds() const { return m_binMilliseconds; }
+        size_t indexCount() const { return m_grid.indices().size(); }
+};
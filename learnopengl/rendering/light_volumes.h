@@ -0,0 +1,121 @@
+#pragma once
+
+#include "gbuffer.h"
+#include "gl_state.h"
+#include "light_buffer.h"
+#include "../post/fullscreen_triangle.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cmath>
+#include <vector>
+
+// Deferred light accumulation with light volumes: every light of the LightBuffer is drawn as an
+// instance of a low poly sphere scaled to its radius (shaders/light_volume.vs/.fs), so a light only
+// shades the pixels it covers and the cost follows screen coverage instead of lights * pixels.
+// Usage per frame, after the geometry pass (all shaders set up once with gbuffer.setSamplers):
+//   lighting_pass.fs built with LIGHT_VOLUMES (ambient only) as a full screen triangle, then
+//   lightVolumes.render(lightVolumeShader, unboundedShader, gbuffer, lightBuffer.lights()) into the
+//   same target. Lights with radius 0 (unbounded) reach every pixel and have no volume, they are
+//   collapsed out of the instanced draw and each shaded by a full screen triangle instead
+//   (unboundedShader: light_volume.vs/.fs built with UNBOUNDED_LIGHT).
+class LightVolumes {
+    private:
+        unsigned int m_vao = 0;
+        unsigned int m_vbo = 0;
+        unsigned int m_ebo = 0;
+        unsigned int m_indexCount = 0;
+
+    public:
+        explicit LightVolumes(unsigned int segments = 16, unsigned int rings = 12) {
+            const float PI = 3.14159265359f;
+            // the faces of the tessellated sphere lie inside the unit sphere, push the vertices out
+            // so the mesh encloses it and no lit pixel at the edge of the radius is missed
+            const float scale = 1.0f / (std::cos(PI / segments) * std::cos(PI / rings));
+
+            std::vector<glm::vec3> positions;
+            for (unsigned int y = 0; y <= rings; ++y) {
+                float theta = PI * y / rings;
+                for (unsigned int x = 0; x <= segments; ++x) {
+                    float phi = 2.0f * PI * x / segments;
+                    positions.push_back(scale * glm::vec3(std::cos(phi) * std::sin(theta), std::cos(theta), std::sin(phi) * std::sin(theta)));
+                }
+            }
+            std::vector<unsigned int> indices;
+            for (unsigned int y = 0; y < rings; ++y) {
+                for (unsigned int x = 0; x < segments; ++x) {
+                    unsigned int i0 = y * (segments + 1) + x;
+                    unsigned int i1 = i0 + segments + 1;
+                    // counter-clockwise seen from outside
+                    indices.insert(indices.end(), { i0, i0 + 1, i1, i0 + 1, i1 + 1, i1 });
+                }
+            }
+            m_indexCount = static_cast<unsigned int>(indices.size());
+
+            glCreateBuffers(1, &m_vbo);
+            glNamedBufferStorage(m_vbo, positions.size() * sizeof(glm::vec3), positions.data(), 0);
+            glCreateBuffers(1, &m_ebo);
+            glNamedBufferStorage(m_ebo, indices.size() * sizeof(unsigned int), indices.data(), 0);
+
+            glCreateVertexArrays(1, &m_vao);
+            glVertexArrayVertexBuffer(m_vao, 0, m_vbo, 0, sizeof(glm::vec3));
+            glVertexArrayElementBuffer(m_vao, m_ebo);
+            glEnableVertexArrayAttrib(m_vao, 0);
+            glVertexArrayAttribFormat(m_vao, 0, 3, GL_FLOAT, GL_FALSE, 0);
+            glVertexArrayAttribBinding(m_vao, 0, 0);
+        }
+
+        ~LightVolumes() {
+            glState().forgetVertexArray(m_vao);
+            glDeleteVertexArrays(1, &m_vao);
+            glDeleteBuffers(1, &m_vbo);
+            glDeleteBuffers(1, &m_ebo);
+        }
+
+        LightVolumes(const LightVolumes&) = delete;
+        LightVolumes& operator=(const LightVolumes&) = delete;
+
+        // adds the lights to the bound framebuffer. only back faces are drawn, without depth test,
+        // so every covered pixel is shaded once per light even with the camera inside the volume.
+        // 'lights' are the lights of the bound light buffer, in the same order
+        void render(Shader& shader, Shader& unboundedShader, const GBuffer& gbuffer, const std::vector<PointLight>& lights) const {
+            if (lights.empty()) {
+                return;
+            }
+            shader.use();
+            shader.setVec2("screenSize", glm::vec2(gbuffer.width(), gbuffer.height()));
+            gbuffer.bindTextures();
+
+            glState().enable(GL_BLEND);
+            glState().blendFunc(GL_ONE, GL_ONE);
+            glState().enable(GL_CULL_FACE);
+            glState().cullFace(GL_FRONT);
+            glState().disable(GL_DEPTH_TEST);
+            glState().depthMask(false);
+
+            glState().bindVertexArray(m_vao);
+            glDrawElementsInstanced(GL_TRIANGLES, m_indexCount, GL_UNSIGNED_INT, 0, static_cast<GLsizei>(lights.size()));
+
+            // the full screen triangle faces the camera
+            glState().disable(GL_CULL_FACE);
+            bool unboundedReady = false;
+            for (size_t i = 0; i < lights.size(); ++i) {
+                if (lights[i].radius > 0.0f) {
+                    continue;
+                }
+                if (!unboundedReady) {
+                    unboundedShader.use();
+                    unboundedShader.setVec2("screenSize", glm::vec2(gbuffer.width(), gbuffer.height()));
+                    unboundedReady = true;
+                }
+                unboundedShader.setInt("lightIndex", static_cast<int>(i));
+                fullscreenTriangle().draw();
+            }
+
+            glState().depthMask(true);
+            glState().enable(GL_DEPTH_TEST);
+            glState().cullFace(GL_BACK);
+            glState().disable(GL_BLEND);
+        }
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "command_buffer.h"
+#include "../threading/thread_pool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+// Records a frame's commands on the thread pool. [0, count) is split into chunks, each chunk
+// records into its own CommandBuffer, so workers never share a buffer and the replay order (chunk
+// order) doesn't depend on scheduling. There are more chunks than threads to even out the load.
+// Buffers and their allocators are reused from frame to frame.
+class ParallelRecorder {
+    private:
+        std::vector<CommandBuffer> m_buffers;
+        std::vector<const CommandBuffer*> m_used;
+        double m_milliseconds = 0.0;
+
+    public:
+        ParallelRecorder() = default;
+        ParallelRecorder(const ParallelRecorder&) = delete;
+        ParallelRecorder& operator=(const ParallelRecorder&) = delete;
+
+        // func(begin, end, CommandBuffer&) records the items of one chunk. With pool nullptr the
+        // chunks are recorded one after the other on the calling thread.
+        template <typename F>
+        void record(size_t count, size_t minChunk, F func, ThreadPool* pool = &threadPool()) {
+            auto start = std::chrono::steady_clock::now();
+            minChunk = std::max<size_t>(minChunk, 1);
+            size_t threads = pool ? pool->size() + 1 : 1;
+            size_t chunks = std::min((count + minChunk - 1) / minChunk, 4 * threads);
+            size_t chunkSize = chunks ? (count + chunks - 1) / chunks : 0;
+            while (m_buffers.size() < chunks) {
+                m_buffers.emplace_back();
+            }
+
+            auto recordChunks = [&](size_t first, size_t last) {
+                for (size_t chunk = first; chunk < last; ++chunk) {
+                    CommandBuffer& buffer = m_buffers[chunk];
+                    buffer.reset();
+                    size_t begin = chunk * chunkSize;
+                    size_t end = std::min(begin + chunkSize, count);
+                    if (begin < end) {
+                        func(begin, end, buffer);
+                    }
+                }
+            };
+            if (pool) {
+                pool->parallelFor(chunks, 1, recordChunks);
+            } else {
+                recordChunks(0, chunks);
+            }
+
+            m_used.clear();
+            for (size_t chunk = 0; chunk < chunks; ++chunk) {
+                m_used.push_back(&m_buffers[chunk]);
+            }
+            m_milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        // the buffers of the last record(), in replay order
+        const std::vector<const CommandBuffer*>& buffers() const { return m_used; }
+        double milliseconds() const { return m_milliseconds; }
+};
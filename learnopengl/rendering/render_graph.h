@@ -0,0 +1,442 @@
+#pragma once
+
+#include "gl_state.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Render graph over 2D render targets. Passes declare what they read, write and create in a setup
+// callback; compile() then
+//   - culls passes whose results nobody reads (imported resources and keep() passes are the roots),
+//   - computes the lifetime of every transient target over the surviving passes,
+//   - assigns transients to pooled GL textures, two transients with the same format and size share
+//     a texture when their lifetimes don't overlap,
+//   - builds one framebuffer per pass from the targets it writes.
+// Transient sizes are relative to the output size, setOutputSize() (e.g. every frame from the window
+// size) recompiles and reallocates only when it actually changed. The graph is built once, execute()
+// runs the surviving passes in declaration order every frame.
+
+typedef uint32_t RenderResource;
+const RenderResource INVALID_RENDER_RESOURCE = ~0u;
+
+struct RenderTargetDesc {
+    GLenum format = GL_RGBA16F;
+    float scale = 1.0f;             // of the output size, unless width and height are set
+    unsigned int width = 0;
+    unsigned int height = 0;
+    GLenum filter = GL_LINEAR;
+
+    RenderTargetDesc() = default;
+    RenderTargetDesc(GLenum format, float scale = 1.0f, GLenum filter = GL_LINEAR) : format{ format }, scale{ scale }, filter{ filter } {}
+};
+
+inline bool isDepthFormat(GLenum format) {
+    return format == GL_DEPTH_COMPONENT16 || format == GL_DEPTH_COMPONENT24 || format == GL_DEPTH_COMPONENT32F
+        || format == GL_DEPTH24_STENCIL8 || format == GL_DEPTH32F_STENCIL8;
+}
+
+inline unsigned int formatBytesPerPixel(GLenum format) {
+    switch (format) {
+        case GL_R8: return 1;
+        case GL_R16F: case GL_RG8: case GL_DEPTH_COMPONENT16: return 2;
+        case GL_RGBA32F: return 16;
+        case GL_RGBA16F: case GL_RG32F: case GL_DEPTH32F_STENCIL8: return 8;
+        case GL_RGB16F: return 6;
+        default: return 4;  // RGBA8, R11F_G11F_B10F, RG16F, R32F, 24/32 bit depth...
+    }
+}
+
+class RenderGraph;
+
+// handed to a pass' setup callback
+class RenderPassBuilder {
+    private:
+        RenderGraph& m_graph;
+        size_t m_pass;
+
+    public:
+        RenderPassBuilder(RenderGraph& graph, size_t pass) : m_graph(graph), m_pass{ pass } {}
+
+        // new transient target written by this pass
+        RenderResource create(const std::string& name, const RenderTargetDesc& desc);
+        RenderResource read(RenderResource resource);
+        // renders into an existing resource (imported target, depth of an earlier pass...)
+        RenderResource write(RenderResource resource);
+        // never cull this pass, for passes with side effects outside the graph
+        void keep();
+};
+
+// handed to a pass' execute callback
+class RenderPassResources {
+    private:
+        const RenderGraph& m_graph;
+        size_t m_pass;
+
+    public:
+        RenderPassResources(const RenderGraph& graph, size_t pass) : m_graph(graph), m_pass{ pass } {}
+
+        unsigned int texture(RenderResource resource) const;
+        // size of the targets the pass renders into
+        unsigned int width() const;
+        unsigned int height() const;
+};
+
+class RenderGraph {
+    private:
+        friend class RenderPassBuilder;
+        friend class RenderPassResources;
+
+        struct Resource {
+            std::string name;
+            RenderTargetDesc desc;
+            bool imported = false;
+            bool backbuffer = false;
+            unsigned int texture = 0;       // imported texture, or the pooled texture after compile()
+            unsigned int width = 0;
+            unsigned int height = 0;
+            int refCount = 0;
+            int firstPass = -1;
+            int lastPass = -1;
+        };
+
+        struct Pass {
+            std::string name;
+            std::function<void(const RenderPassResources&)> execute;
+            std::vector<RenderResource> reads;
+            std::vector<RenderResource> writes;
+            bool keep = false;
+            bool culled = false;
+            int refCount = 0;
+            unsigned int fbo = 0;
+            unsigned int width = 0;
+            unsigned int height = 0;
+        };
+
+        struct PooledTexture {
+            unsigned int texture;
+            GLenum format;
+            unsigned int width, height;
+            GLenum filter;
+            int busyUntil;      // last pass of the transient currently aliased onto it
+        };
+
+        std::vector<Resource> m_resources;
+        std::vector<Pass> m_passes;
+        std::vector<PooledTexture> m_pool;
+        unsigned int m_width;
+        unsigned int m_height;
+        bool m_dirty = true;
+
+        size_t m_transientBytes = 0;
+        size_t m_pooledBytes = 0;
+
+        void targetSize(const RenderTargetDesc& desc, unsigned int& width, unsigned int& height) const {
+            if (desc.width && desc.height) {
+                width = desc.width;
+                height = desc.height;
+            } else {
+                width = std::max(1u, static_cast<unsigned int>(m_width * desc.scale));
+                height = std::max(1u, static_cast<unsigned int>(m_height * desc.scale));
+            }
+        }
+
+        void releaseFramebuffers() {
+            for (Pass& pass : m_passes) {
+                if (pass.fbo) {
+                    glState().forgetFramebuffer(pass.fbo);
+                    glDeleteFramebuffers(1, &pass.fbo);
+                    pass.fbo = 0;
+                }
+            }
+        }
+
+        void cull() {
+            for (Resource& resource : m_resources) {
+                resource.refCount = resource.imported ? 1 : 0;
+            }
+            for (Pass& pass : m_passes) {
+                pass.culled = false;
+                pass.refCount = static_cast<int>(pass.writes.size());
+                for (RenderResource read : pass.reads) {
+                    ++m_resources[read].refCount;
+                }
+            }
+
+            std::vector<RenderResource> unused;
+            for (RenderResource i = 0; i < m_resources.size(); ++i) {
+                if (m_resources[i].refCount == 0) {
+                    unused.push_back(i);
+                }
+            }
+            while (!unused.empty()) {
+                RenderResource resource = unused.back();
+                unused.pop_back();
+                for (Pass& pass : m_passes) {
+                    if (pass.culled || pass.keep || std::find(pass.writes.begin(), pass.writes.end(), resource) == pass.writes.end()) {
+                        continue;
+                    }
+                    if (--pass.refCount == 0) {
+                        pass.culled = true;
+                        for (RenderResource read : pass.reads) {
+                            if (--m_resources[read].refCount == 0) {
+                                unused.push_back(read);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        void allocate() {
+            for (Resource& resource : m_resources) {
+                resource.firstPass = resource.lastPass = -1;
+            }
+            for (size_t p = 0; p < m_passes.size(); ++p) {
+                if (m_passes[p].culled) {
+                    continue;
+                }
+                auto touch = [&](RenderResource r) {
+                    Resource& resource = m_resources[r];
+                    if (resource.firstPass < 0) {
+                        resource.firstPass = static_cast<int>(p);
+                    }
+                    resource.lastPass = static_cast<int>(p);
+                };
+                std::for_each(m_passes[p].reads.begin(), m_passes[p].reads.end(), touch);
+                std::for_each(m_passes[p].writes.begin(), m_passes[p].writes.end(), touch);
+            }
+
+            // resources are created in pass order, so handing out textures in resource order is a
+            // greedy interval assignment by start time
+            std::vector<bool> used(m_pool.size(), false);
+            for (PooledTexture& pooled : m_pool) {
+                pooled.busyUntil = -1;
+            }
+            m_transientBytes = 0;
+            for (Resource& resource : m_resources) {
+                if (resource.imported) {
+                    continue;
+                }
+                resource.texture = 0;
+                if (resource.firstPass < 0) {
+                    continue;
+                }
+                targetSize(resource.desc, resource.width, resource.height);
+                m_transientBytes += static_cast<size_t>(resource.width) * resource.height * formatBytesPerPixel(resource.desc.format);
+
+                size_t slot = m_pool.size();
+                for (size_t i = 0; i < m_pool.size(); ++i) {
+                    const PooledTexture& pooled = m_pool[i];
+                    if (pooled.busyUntil < resource.firstPass && pooled.format == resource.desc.format && pooled.filter == resource.desc.filter
+                        && pooled.width == resource.width && pooled.height == resource.height) {
+                        slot = i;
+                        break;
+                    }
+                }
+                if (slot == m_pool.size()) {
+                    PooledTexture pooled = { 0, resource.desc.format, resource.width, resource.height, resource.desc.filter, -1 };
+                    glCreateTextures(GL_TEXTURE_2D, 1, &pooled.texture);
+                    glTextureStorage2D(pooled.texture, 1, pooled.format, pooled.width, pooled.height);
+                    glTextureParameteri(pooled.texture, GL_TEXTURE_MIN_FILTER, pooled.filter);
+                    glTextureParameteri(pooled.texture, GL_TEXTURE_MAG_FILTER, pooled.filter);
+                    glTextureParameteri(pooled.texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+                    glTextureParameteri(pooled.texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+                    m_pool.push_back(pooled);
+                    used.push_back(false);
+                }
+                m_pool[slot].busyUntil = resource.lastPass;
+                used[slot] = true;
+                resource.texture = m_pool[slot].texture;
+            }
+
+            // drop what this compile didn't need, e.g. the targets of the previous output size
+            m_pooledBytes = 0;
+            size_t kept = 0;
+            for (size_t i = 0; i < m_pool.size(); ++i) {
+                if (used[i]) {
+                    m_pooledBytes += static_cast<size_t>(m_pool[i].width) * m_pool[i].height * formatBytesPerPixel(m_pool[i].format);
+                    m_pool[kept++] = m_pool[i];
+                } else {
+                    glState().forgetTexture(m_pool[i].texture);
+                    glDeleteTextures(1, &m_pool[i].texture);
+                }
+            }
+            m_pool.resize(kept);
+        }
+
+        void buildFramebuffers() {
+            releaseFramebuffers();
+            for (Pass& pass : m_passes) {
+                if (pass.culled || pass.writes.empty()) {
+                    continue;
+                }
+                const Resource& first = m_resources[pass.writes.front()];
+                pass.width = first.backbuffer ? m_width : first.width;
+                pass.height = first.backbuffer ? m_height : first.height;
+                if (first.backbuffer) {
+                    continue;   // default framebuffer
+                }
+
+                glCreateFramebuffers(1, &pass.fbo);
+                std::vector<GLenum> drawBuffers;
+                for (RenderResource write : pass.writes) {
+                    const Resource& resource = m_resources[write];
+                    if (isDepthFormat(resource.desc.format)) {
+                        GLenum attachment = resource.desc.format == GL_DEPTH24_STENCIL8 || resource.desc.format == GL_DEPTH32F_STENCIL8
+                            ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT;
+                        glNamedFramebufferTexture(pass.fbo, attachment, resource.texture, 0);
+                    } else {
+                        GLenum attachment = GL_COLOR_ATTACHMENT0 + static_cast<GLenum>(drawBuffers.size());
+                        glNamedFramebufferTexture(pass.fbo, attachment, resource.texture, 0);
+                        drawBuffers.push_back(attachment);
+                    }
+                }
+                glNamedFramebufferDrawBuffers(pass.fbo, static_cast<GLsizei>(drawBuffers.size()), drawBuffers.data());
+                if (glCheckNamedFramebufferStatus(pass.fbo, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+                    std::cout << "ERROR::RENDER_GRAPH::FRAMEBUFFER_INCOMPLETE: " << pass.name << std::endl;
+                }
+            }
+        }
+
+    public:
+        RenderGraph(unsigned int width, unsigned int height) : m_width{ width }, m_height{ height } {}
+
+        ~RenderGraph() {
+            releaseFramebuffers();
+            for (PooledTexture& pooled : m_pool) {
+                glState().forgetTexture(pooled.texture);
+                glDeleteTextures(1, &pooled.texture);
+            }
+        }
+
+        RenderGraph(const RenderGraph&) = delete;
+        RenderGraph& operator=(const RenderGraph&) = delete;
+
+        // the default framebuffer, always the size of the output
+        RenderResource importBackbuffer(const std::string& name = "backbuffer") {
+            Resource resource;
+            resource.name = name;
+            resource.imported = true;
+            resource.backbuffer = true;
+            m_resources.push_back(resource);
+            m_dirty = true;
+            return static_cast<RenderResource>(m_resources.size() - 1);
+        }
+
+        // a texture owned outside the graph (history buffers, baked maps...)
+        RenderResource importTexture(const std::string& name, unsigned int texture, GLenum format, unsigned int width, unsigned int height) {
+            Resource resource;
+            resource.name = name;
+            resource.desc.format = format;
+            resource.imported = true;
+            resource.texture = texture;
+            resource.width = width;
+            resource.height = height;
+            m_resources.push_back(resource);
+            m_dirty = true;
+            return static_cast<RenderResource>(m_resources.size() - 1);
+        }
+
+        void addPass(const std::string& name, const std::function<void(RenderPassBuilder&)>& setup,
+                     std::function<void(const RenderPassResources&)> execute) {
+            Pass pass;
+            pass.name = name;
+            pass.execute = std::move(execute);
+            m_passes.push_back(std::move(pass));
+            RenderPassBuilder builder(*this, m_passes.size() - 1);
+            setup(builder);
+            m_dirty = true;
+        }
+
+        void setOutputSize(unsigned int width, unsigned int height) {
+            if (width == 0 || height == 0 || (width == m_width && height == m_height)) {
+                return;
+            }
+            m_width = width;
+            m_height = height;
+            m_dirty = true;
+        }
+
+        void compile() {
+            cull();
+            allocate();
+            buildFramebuffers();
+            m_dirty = false;
+        }
+
+        void execute() {
+            if (m_dirty) {
+                compile();
+            }
+            for (size_t p = 0; p < m_passes.size(); ++p) {
+                const Pass& pass = m_passes[p];
+                if (pass.culled) {
+                    continue;
+                }
+                if (!pass.writes.empty()) {
+                    glState().bindFramebuffer(GL_FRAMEBUFFER, pass.fbo);
+                    glState().viewport(0, 0, pass.width, pass.height);
+                }
+                pass.execute(RenderPassResources(*this, p));
+            }
+            glState().bindFramebuffer(GL_FRAMEBUFFER, 0);
+            glState().viewport(0, 0, m_width, m_height);
+        }
+
+        // one line per pass and the memory the transients take with and without aliasing
+        void print() const {
+            for (const Pass& pass : m_passes) {
+                std::cout << "  " << (pass.culled ? "[culled] " : "") << pass.name << std::endl;
+            }
+            std::cout << "  transient targets: " << m_transientBytes / (1024 * 1024) << " MiB, "
+                      << m_pooledBytes / (1024 * 1024) << " MiB in " << m_pool.size() << " aliased textures" << std::endl;
+        }
+
+        unsigned int width() const { return m_width; }
+        unsigned int height() const { return m_height; }
+        // bytes all live transients would take with a texture each, and what the pool actually holds
+        size_t transientBytes() const { return m_transientBytes; }
+        size_t pooledBytes() const { return m_pooledBytes; }
+};
+
+inline RenderResource RenderPassBuilder::create(const std::string& name, const RenderTargetDesc& desc) {
+    RenderGraph::Resource resource;
+    resource.name = name;
+    resource.desc = desc;
+    m_graph.m_resources.push_back(resource);
+    RenderResource handle = static_cast<RenderResource>(m_graph.m_resources.size() - 1);
+    m_graph.m_passes[m_pass].writes.push_back(handle);
+    return handle;
+}
+
+inline RenderResource RenderPassBuilder::read(RenderResource resource) {
+    m_graph.m_passes[m_pass].reads.push_back(resource);
+    return resource;
+}
+
+inline RenderResource RenderPassBuilder::write(RenderResource resource) {
+    m_graph.m_passes[m_pass].writes.push_back(resource);
+    return resource;
+}
+
+inline void RenderPassBuilder::keep() {
+    m_graph.m_passes[m_pass].keep = true;
+}
+
+inline unsigned int RenderPassResources::texture(RenderResource resource) const {
+    return m_graph.m_resources[resource].texture;
+}
+
+inline unsigned int RenderPassResources::width() const {
+    return m_graph.m_passes[m_pass].width;
+}
+
+inline unsigned int RenderPassResources::height() const {
+    return m_graph.m_passes[m_pass].height;
+}
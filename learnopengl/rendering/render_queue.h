@@ -0,0 +1,267 @@
+#pragma once
+
+#include "gl_state.h"
+#include "../shader.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+// Draw buckets inside a pass, submitted in this order. Opaque draws go front to back grouped by
+// program, material and mesh; background draws (the skybox, drawn at the far plane with GL_LEQUAL)
+// follow them so they only shade uncovered pixels; translucent draws go last, back to front, and are
+// the only ones with blending enabled and depth writes disabled.
+enum RenderBucket {
+    RENDER_BUCKET_OPAQUE = 0,
+    RENDER_BUCKET_BACKGROUND = 1,
+    RENDER_BUCKET_TRANSLUCENT = 2
+};
+
+// vertex array and draw parameters, indexType 0 draws arrays
+struct RenderMesh {
+    GLuint vao = 0;
+    GLenum mode = GL_TRIANGLES;
+    GLsizei count = 0;
+    GLenum indexType = 0;
+};
+
+// textures bound to consecutive units starting at 0
+struct RenderMaterial {
+    static const unsigned int MAX_TEXTURES = 8;
+    GLuint textures[MAX_TEXTURES] = {};
+    unsigned int textureCount = 0;
+};
+
+struct RenderQueueStats {
+    unsigned int commands = 0;
+    unsigned int programChanges = 0;
+    unsigned int materialChanges = 0;
+    unsigned int meshChanges = 0;
+    unsigned int bucketChanges = 0;
+};
+
+// 64 bit sort key, most significant field first:
+//   pass 4 | bucket 2 | opaque and background: program 10 | material 12 | mesh 12 | depth 24
+//                       translucent:           inverted depth 24 | program 10 | material 12 | mesh 12
+// Depth is the top 24 bits of the positive float view distance, which keep the float ordering.
+namespace RenderKey {
+    const unsigned int PASS_BITS = 4, BUCKET_BITS = 2, PROGRAM_BITS = 10, MATERIAL_BITS = 12, MESH_BITS = 12, DEPTH_BITS = 24;
+
+    inline uint64_t depthBits(float distance) {
+        distance = distance > 0.0f ? distance : 0.0f;
+        uint32_t bits;
+        std::memcpy(&bits, &distance, sizeof(bits));
+        return bits >> (32 - DEPTH_BITS);
+    }
+
+    inline uint64_t field(uint64_t value, unsigned int bits) {
+        return value & ((1ull << bits) - 1);
+    }
+
+    // ids wider than their field are truncated, which only weakens the grouping
+    inline uint64_t make(unsigned int pass, RenderBucket bucket, uint32_t program, uint32_t material, uint32_t mesh, float distance) {
+        uint64_t state = field(program, PROGRAM_BITS) << (MATERIAL_BITS + MESH_BITS) | field(material, MATERIAL_BITS) << MESH_BITS | field(mesh, MESH_BITS);
+        uint64_t depth = depthBits(distance);
+        uint64_t key = field(pass, PASS_BITS) << (64 - PASS_BITS) | field(bucket, BUCKET_BITS) << (64 - PASS_BITS - BUCKET_BITS);
+        if (bucket == RENDER_BUCKET_TRANSLUCENT) {
+            return key | (((1ull << DEPTH_BITS) - 1 - depth) << (PROGRAM_BITS + MATERIAL_BITS + MESH_BITS)) | state;
+        }
+        return key | (state << DEPTH_BITS) | depth;
+    }
+
+    inline RenderBucket bucket(uint64_t key) {
+        return static_cast<RenderBucket>((key >> (64 - PASS_BITS - BUCKET_BITS)) & ((1u << BUCKET_BITS) - 1));
+    }
+}
+
+// sorts key/value pairs by key, LSD radix sort with 8 bit digits. Digits every key shares are
+// skipped, so keys that only differ in a few fields cost a few passes. Stable.
+template <typename T>
+void radixSort(std::vector<std::pair<uint64_t, T>>& items, std::vector<std::pair<uint64_t, T>>& scratch) {
+    const size_t count = items.size();
+    if (count < 2) {
+        return;
+    }
+    uint32_t histograms[8][256] = {};
+    for (const std::pair<uint64_t, T>& item : items) {
+        for (unsigned int digit = 0; digit < 8; ++digit) {
+            ++histograms[digit][(item.first >> (digit * 8)) & 0xff];
+        }
+    }
+    scratch.resize(count);
+    std::pair<uint64_t, T>* source = items.data();
+    std::pair<uint64_t, T>* destination = scratch.data();
+    for (unsigned int digit = 0; digit < 8; ++digit) {
+        uint32_t* histogram = histograms[digit];
+        if (histogram[(source[0].first >> (digit * 8)) & 0xff] == count) {
+            continue;
+        }
+        uint32_t offset = 0;
+        for (unsigned int bin = 0; bin < 256; ++bin) {
+            uint32_t binCount = histogram[bin];
+            histogram[bin] = offset;
+            offset += binCount;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            destination[histogram[(source[i].first >> (digit * 8)) & 0xff]++] = source[i];
+        }
+        std::swap(source, destination);
+    }
+    if (source != items.data()) {
+        items.swap(scratch);
+    }
+}
+
+// Per-frame draw queue. Programs, materials and meshes are registered once and referenced by their
+// small ids; submit() records a compact command with its sort key, flush() radix sorts the frame's
+// commands and issues them, only touching state when the next command's program, material, mesh
+// or bucket differs from the previous one. Per draw transforms go to the program's "model" uniform.
+class RenderQueue {
+    private:
+        struct Command {
+            uint32_t program;
+            uint32_t material;
+            uint32_t mesh;
+            uint32_t instanceCount;
+            uint32_t transform;     // index into m_transforms, NO_TRANSFORM if none
+        };
+        static const uint32_t NO_TRANSFORM = ~0u;
+        static const uint32_t NONE = ~0u;
+
+        std::vector<Shader*> m_programs;
+        std::vector<UniformLocation> m_modelLocations;
+        std::vector<RenderMaterial> m_materials;
+        std::vector<RenderMesh> m_meshes;
+
+        std::vector<Command> m_commands;
+        std::vector<glm::mat4> m_transforms;
+        std::vector<std::pair<uint64_t, uint32_t>> m_keys;
+        std::vector<std::pair<uint64_t, uint32_t>> m_scratch;
+        RenderQueueStats m_stats;
+
+        void setBucketState(RenderBucket bucket) {
+            if (bucket == RENDER_BUCKET_TRANSLUCENT) {
+                glState().enable(GL_BLEND);
+                glState().blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+                glState().depthMask(false);
+            } else {
+                glState().disable(GL_BLEND);
+                glState().depthMask(true);
+            }
+        }
+
+    public:
+        explicit RenderQueue(size_t capacity = 1024) {
+            m_commands.reserve(capacity);
+            m_keys.reserve(capacity);
+        }
+
+        RenderQueue(const RenderQueue&) = delete;
+        RenderQueue& operator=(const RenderQueue&) = delete;
+
+        // the queue reads shader.ID at flush time, so hot reloaded programs keep working
+        uint32_t addProgram(Shader& shader) {
+            m_programs.push_back(&shader);
+            m_modelLocations.push_back(UniformLocation());
+            return static_cast<uint32_t>(m_programs.size() - 1);
+        }
+
+        uint32_t addMaterial(const RenderMaterial& material) {
+            m_materials.push_back(material);
+            return static_cast<uint32_t>(m_materials.size() - 1);
+        }
+
+        uint32_t addMesh(const RenderMesh& mesh) {
+            m_meshes.push_back(mesh);
+            return static_cast<uint32_t>(m_meshes.size() - 1);
+        }
+
+        RenderMaterial& material(uint32_t id) { return m_materials[id]; }
+        RenderMesh& mesh(uint32_t id) { return m_meshes[id]; }
+
+        // distance: view space distance used to order the draw inside its bucket
+        void submit(unsigned int pass, RenderBucket bucket, uint32_t program, uint32_t material, uint32_t mesh, float distance,
+                    uint32_t instanceCount = 1, const glm::mat4* model = nullptr) {
+            uint32_t transform = NO_TRANSFORM;
+            if (model) {
+                transform = static_cast<uint32_t>(m_transforms.size());
+                m_transforms.push_back(*model);
+            }
+            uint32_t index = static_cast<uint32_t>(m_commands.size());
+            m_commands.push_back({ program, material, mesh, instanceCount, transform });
+            m_keys.push_back(std::make_pair(RenderKey::make(pass, bucket, program, material, mesh, distance), index));
+        }
+
+        // sorts only, for measuring and for callers that walk sorted() themselves
+        void sort() {
+            radixSort(m_keys, m_scratch);
+        }
+
+        const std::vector<std::pair<uint64_t, uint32_t>>& sorted() const { return m_keys; }
+
+        // sorts, issues and clears the frame's commands, returns with blending off and depth writes on
+        void flush() {
+            sort();
+            m_stats = RenderQueueStats();
+            m_stats.commands = static_cast<unsigned int>(m_keys.size());
+
+            uint32_t program = NONE, material = NONE, mesh = NONE;
+            int bucket = -1;
+            for (const std::pair<uint64_t, uint32_t>& entry : m_keys) {
+                const Command& command = m_commands[entry.second];
+                RenderBucket commandBucket = RenderKey::bucket(entry.first);
+                if (commandBucket != bucket) {
+                    bucket = commandBucket;
+                    setBucketState(commandBucket);
+                    ++m_stats.bucketChanges;
+                }
+                if (command.program != program) {
+                    program = command.program;
+                    m_programs[program]->use();
+                    m_modelLocations[program] = m_programs[program]->uniform("model");
+                    ++m_stats.programChanges;
+                }
+                if (command.material != material) {
+                    material = command.material;
+                    const RenderMaterial& bound = m_materials[material];
+                    for (unsigned int unit = 0; unit < bound.textureCount; ++unit) {
+                        glState().bindTexture(unit, bound.textures[unit]);
+                    }
+                    ++m_stats.materialChanges;
+                }
+                if (command.mesh != mesh) {
+                    mesh = command.mesh;
+                    glState().bindVertexArray(m_meshes[mesh].vao);
+                    ++m_stats.meshChanges;
+                }
+                if (command.transform != NO_TRANSFORM) {
+                    m_programs[program]->setMat4(m_modelLocations[program], m_transforms[command.transform]);
+                }
+
+                const RenderMesh& drawn = m_meshes[mesh];
+                if (drawn.indexType) {
+                    glDrawElementsInstanced(drawn.mode, drawn.count, drawn.indexType, 0, command.instanceCount);
+                } else {
+                    glDrawArraysInstanced(drawn.mode, 0, drawn.count, command.instanceCount);
+                }
+            }
+            if (bucket != RENDER_BUCKET_OPAQUE) {
+                setBucketState(RENDER_BUCKET_OPAQUE);
+            }
+            clear();
+        }
+
+        void clear() {
+            m_commands.clear();
+            m_transforms.clear();
+            m_keys.clear();
+        }
+
+        size_t size() const { return m_commands.size(); }
+        // counters of the last flush()
+        const RenderQueueStats& stats() const { return m_stats; }
+};
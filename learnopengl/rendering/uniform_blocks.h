@@ -0,0 +1,34 @@
+#pragma once
+
+#include "uniform_buffer.h"
+
+#include <glm/glm.hpp>
+
+// fixed binding points, shared with the layout(binding = N) of the blocks in shaders/include/*.glsl
+enum UniformBinding {
+    CAMERA_BINDING = 0
+};
+
+// fixed shader storage binding points, same convention
+enum StorageBinding {
+    LIGHTS_BINDING = 0,
+    CLUSTERS_BINDING = 1,
+    CLUSTER_LIGHTS_BINDING = 2
+};
+
+// per-frame camera data, shaders/include/camera.glsl
+struct CameraBlock {
+    glm::mat4 projection;
+    glm::mat4 view;
+    glm::mat4 viewProjection;
+    glm::mat4 inverseViewProjection;    // clip space back to world space, for depth based position reconstruction
+    glm::vec3 position;
+    float time;
+};
+STD140_FIRST(CameraBlock, projection);
+STD140_NEXT(CameraBlock, projection, view);
+STD140_NEXT(CameraBlock, view, viewProjection);
+STD140_NEXT(CameraBlock, viewProjection, inverseViewProjection);
+STD140_NEXT(CameraBlock, inverseViewProjection, position);
+STD140_NEXT(CameraBlock, position, time);
+STD140_END(CameraBlock, time)
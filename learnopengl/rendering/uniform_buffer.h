@@ -0,0 +1,93 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+
+// std140 layout rules, used to check at compile time that a C++ struct mirrors a GLSL uniform block.
+// Layout<T> gives the std140 base alignment and size of T. Declare the members of a block struct with
+// the STD140_* macros below: every member's offset is static_asserted against the offset std140 gives
+// it, so a missing padding field fails the build instead of silently corrupting the block.
+namespace std140 {
+    constexpr size_t alignUp(size_t value, size_t alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    template <typename T> struct Layout;
+    template <> struct Layout<float>        { static constexpr size_t align = 4;  static constexpr size_t size = 4; };
+    template <> struct Layout<int>          { static constexpr size_t align = 4;  static constexpr size_t size = 4; };
+    template <> struct Layout<unsigned int> { static constexpr size_t align = 4;  static constexpr size_t size = 4; };
+    template <> struct Layout<glm::vec2>    { static constexpr size_t align = 8;  static constexpr size_t size = 8; };
+    template <> struct Layout<glm::ivec2>   { static constexpr size_t align = 8;  static constexpr size_t size = 8; };
+    template <> struct Layout<glm::vec3>    { static constexpr size_t align = 16; static constexpr size_t size = 12; };
+    template <> struct Layout<glm::vec4>    { static constexpr size_t align = 16; static constexpr size_t size = 16; };
+    template <> struct Layout<glm::ivec4>   { static constexpr size_t align = 16; static constexpr size_t size = 16; };
+    template <> struct Layout<glm::uvec4>   { static constexpr size_t align = 16; static constexpr size_t size = 16; };
+    template <> struct Layout<glm::mat4>    { static constexpr size_t align = 16; static constexpr size_t size = 64; };
+
+    // arrays: every element is rounded up to a vec4 stride, the C++ element type has to match it
+    template <typename T, size_t N> struct Layout<T[N]> {
+        static constexpr size_t align = alignUp(Layout<T>::align, 16);
+        static constexpr size_t stride = alignUp(Layout<T>::size, 16);
+        static constexpr size_t size = stride * N;
+        static_assert(sizeof(T) == stride, "std140 array elements need a vec4 aligned stride, pad the element type");
+    };
+
+    // a mat3 is three vec4 columns in std140, glm::mat3 (three vec3) can't be used directly
+    struct mat3 {
+        glm::vec4 columns[3];
+
+        mat3() = default;
+        mat3(const glm::mat3& m) : columns{ glm::vec4(m[0], 0.0f), glm::vec4(m[1], 0.0f), glm::vec4(m[2], 0.0f) } {}
+    };
+    template <> struct Layout<mat3> { static constexpr size_t align = 16; static constexpr size_t size = 48; };
+}
+
+#define STD140_MEMBER_TYPE(Struct, member) decltype(Struct::member)
+
+// first member sits at offset 0
+#define STD140_FIRST(Struct, member) \
+    static_assert(offsetof(Struct, member) == 0, #Struct "::" #member " must be the first member")
+
+// 'member' directly follows 'previous' in the GLSL block
+#define STD140_NEXT(Struct, previous, member) \
+    static_assert(offsetof(Struct, member) == std140::alignUp(offsetof(Struct, previous) + std140::Layout<STD140_MEMBER_TYPE(Struct, previous)>::size, \
+        std140::Layout<STD140_MEMBER_TYPE(Struct, member)>::align), #Struct "::" #member " is not at its std140 offset")
+
+// closes the block: struct size rounded to a vec4 so it can be used as an array element or nested struct
+#define STD140_END(Struct, last) \
+    static_assert(sizeof(Struct) == std140::alignUp(offsetof(Struct, last) + std140::Layout<STD140_MEMBER_TYPE(Struct, last)>::size, 16), \
+        #Struct " size is not a multiple of 16 or has trailing members not declared to std140"); \
+    namespace std140 { template <> struct Layout<Struct> { static constexpr size_t align = 16; static constexpr size_t size = sizeof(Struct); }; }
+
+// Uniform buffer holding one T, bound once to a fixed binding point. update() is a single buffer write.
+template <typename T>
+class UniformBuffer {
+    private:
+        unsigned int m_buffer = 0;
+        GLuint m_binding;
+
+    public:
+        explicit UniformBuffer(GLuint binding) : m_binding{ binding } {
+            glGenBuffers(1, &m_buffer);
+            glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+            glBufferData(GL_UNIFORM_BUFFER, sizeof(T), nullptr, GL_DYNAMIC_DRAW);
+            glBindBuffer(GL_UNIFORM_BUFFER, 0);
+            glBindBufferBase(GL_UNIFORM_BUFFER, m_binding, m_buffer);
+        }
+
+        ~UniformBuffer() {
+            glDeleteBuffers(1, &m_buffer);
+        }
+
+        UniformBuffer(const UniformBuffer&) = delete;
+        UniformBuffer& operator=(const UniformBuffer&) = delete;
+
+        void update(const T& data) {
+            glNamedBufferSubData(m_buffer, 0, sizeof(T), &data);
+        }
+
+        unsigned int id() const { return m_buffer; }
+        GLuint binding() const { return m_binding; }
+};
@@ -4,11 +4,58 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include "shading/program_cache.h"
+#include "shading/compile_queue.h"
+#include "shading/preprocessor.h"
+#include "rendering/gl_state.h"
+
+#include <algorithm>
+#include <cstdint>
 #include <string>
-#include <fstream>
-#include <sstream>
+#include <vector>
 #include <iostream>
 
+// 32 bit FNV-1a, constexpr so uniform names written as string literals are hashed at compile time
+constexpr uint32_t fnv1a(const char* str, size_t length)
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; ++i)
+    {
+        hash ^= static_cast<uint8_t>(str[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// name of a uniform together with its hash. Implicitly built from string literals (hashed at compile time)
+// or from std::string for names assembled at runtime (hashed on the spot, still no allocation or driver call)
+struct UniformName
+{
+    uint32_t hash;
+    const char* str;
+
+    template <size_t N>
+    constexpr UniformName(const char (&name)[N]) : hash(fnv1a(name, N - 1)), str(name) {}
+    UniformName(const std::string& name) : hash(fnv1a(name.c_str(), name.size())), str(name.c_str()) {}
+};
+
+// cheap handle to a uniform location, resolve it once with Shader::uniform() and reuse it every frame
+struct UniformLocation
+{
+    GLint value = -1;
+
+    UniformLocation() = default;
+    explicit UniformLocation(GLint location) : value(location) {}
+    bool valid() const { return value >= 0; }
+};
+
+// number of uniform location lookups served from the reflected table vs. the ones that had to ask the driver
+struct UniformStats
+{
+    unsigned int cached = 0;
+    unsigned int driver = 0;
+};
+
 class Shader
 {
 public:
@@ -16,174 +63,469 @@ public:
     // constructor generates the shader on the fly
     // ------------------------------------------------------------------------
     Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr)
+        : Shader(vertexPath, fragmentPath, ShaderDefines(), geometryPath)
     {
-        // 1. retrieve the vertex/fragment source code from filePath
-        std::string vertexCode;
-        std::string fragmentCode;
-        std::string geometryCode;
-        std::ifstream vShaderFile;
-        std::ifstream fShaderFile;
-        std::ifstream gShaderFile;
-        // ensure ifstream objects can throw exceptions:
-        vShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-        fShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-        gShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-        try 
-        {
-            // open files
-            vShaderFile.open(vertexPath);
-            fShaderFile.open(fragmentPath);
-            std::stringstream vShaderStream, fShaderStream;
-            // read file's buffer contents into streams
-            vShaderStream << vShaderFile.rdbuf();
-            fShaderStream << fShaderFile.rdbuf();		
-            // close file handlers
-            vShaderFile.close();
-            fShaderFile.close();
-            // convert stream into string
-            vertexCode = vShaderStream.str();
-            fragmentCode = fShaderStream.str();			
-            // if geometry shader path is present, also load a geometry shader
-            if(geometryPath != nullptr)
-            {
-                gShaderFile.open(geometryPath);
-                std::stringstream gShaderStream;
-                gShaderStream << gShaderFile.rdbuf();
-                gShaderFile.close();
-                geometryCode = gShaderStream.str();
-            }
-        }
-        catch (std::ifstream::failure& e)
-        {
-            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << e.what() << std::endl;
-        }
-        const char* vShaderCode = vertexCode.c_str();
-        const char * fShaderCode = fragmentCode.c_str();
-        // 2. compile shaders
-        unsigned int vertex, fragment;
-        // vertex shader
-        vertex = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vertex, 1, &vShaderCode, NULL);
-        glCompileShader(vertex);
-        checkCompileErrors(vertex, "VERTEX");
-        // fragment Shader
-        fragment = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(fragment, 1, &fShaderCode, NULL);
-        glCompileShader(fragment);
-        checkCompileErrors(fragment, "FRAGMENT");
-        // if geometry shader is given, compile geometry shader
-        unsigned int geometry;
-        if(geometryPath != nullptr)
-        {
-            const char * gShaderCode = geometryCode.c_str();
-            geometry = glCreateShader(GL_GEOMETRY_SHADER);
-            glShaderSource(geometry, 1, &gShaderCode, NULL);
-            glCompileShader(geometry);
-            checkCompileErrors(geometry, "GEOMETRY");
-        }
-        // shader Program
-        ID = glCreateProgram();
-        glAttachShader(ID, vertex);
-        glAttachShader(ID, fragment);
-        if(geometryPath != nullptr)
-            glAttachShader(ID, geometry);
-        glLinkProgram(ID);
-        checkCompileErrors(ID, "PROGRAM");
-        // delete the shaders as they're linked into our program now and no longer necessary
-        glDeleteShader(vertex);
-        glDeleteShader(fragment);
-        if(geometryPath != nullptr)
-            glDeleteShader(geometry);
-
+    }
+    // same, compiling the permutation selected by 'defines'. The sources may #include other files.
+    // ------------------------------------------------------------------------
+    Shader(const char* vertexPath, const char* fragmentPath, const ShaderDefines& defines, const char* geometryPath = nullptr)
+        : m_vertexPath(vertexPath), m_fragmentPath(fragmentPath), m_geometryPath(geometryPath ? geometryPath : ""), m_defines(defines)
+    {
+        ID = build(m_pending);
+        if (!m_pending)
+            reflectUniforms();
+    }
+    // compute program from a single stage, same includes, defines and caching
+    // ------------------------------------------------------------------------
+    explicit Shader(const char* computePath, const ShaderDefines& defines = ShaderDefines())
+        : m_computePath(computePath), m_defines(defines)
+    {
+        ID = build(m_pending);
+        if (!m_pending)
+            reflectUniforms();
     }
     // activate the shader
     // ------------------------------------------------------------------------
     void use() 
     { 
-        glUseProgram(ID); 
+        ensureLinked();
+        glState().useProgram(ID); 
+    }
+    // blocks until this program's compile/link finished, returns false if it failed
+    bool ensureLinked() const
+    {
+        if (!m_pending)
+            return m_linked;
+        m_pending = false;
+        m_linked = shaderCompileQueue().wait(ID);
+        reflectUniforms();
+        return m_linked;
+    }
+    // uniform lookup
+    // ------------------------------------------------------------------------
+    UniformLocation uniform(const UniformName &name) const
+    {
+        return UniformLocation(location(name));
+    }
+    // location of element 'index' of a uniform array of basic type, the elements are laid out consecutively
+    UniformLocation uniform(const UniformName &arrayName, int index) const
+    {
+        GLint base = location(arrayName);
+        return UniformLocation(base < 0 ? -1 : base + index);
+    }
+    // hot reload: rebuilds the program from its source files in the background, the current
+    // program stays in use until applyReload() swaps the new one in
+    // ------------------------------------------------------------------------
+    void reload()
+    {
+        discardReload();
+        m_files.clear();
+        m_reloadID = build(m_reloadPending);
+    }
+    // call at a frame boundary. Swaps in the rebuilt program once it linked, keeps the old one if it
+    // failed. With 'block' false it returns without waiting when the driver is still compiling.
+    bool applyReload(bool block = false)
+    {
+        if (m_reloadID == 0)
+            return false;
+        if (m_reloadPending && !block && !shaderCompileQueue().ready(m_reloadID))
+            return false;
+        bool linked = shaderCompileQueue().wait(m_reloadID);
+        m_reloadPending = false;
+        if (!linked)
+        {
+            std::cout << "ERROR::SHADER::RELOAD_FAILED, keeping the previous program: " << label() << std::endl;
+            discardReload();
+            return false;
+        }
+        ensureLinked();
+        copyUniformValues(ID, m_reloadID);
+        glState().forgetProgram(ID);
+        glDeleteProgram(ID);
+        ID = m_reloadID;
+        m_reloadID = 0;
+        m_linked = true;
+        reflectUniforms();
+        std::cout << "Reloaded shader: " << label() << std::endl;
+        return true;
+    }
+    bool reloading() const
+    {
+        return m_reloadID != 0;
+    }
+    std::string label() const
+    {
+        if (!m_computePath.empty())
+            return m_computePath;
+        return m_vertexPath + " + " + m_fragmentPath;
+    }
+    // source files this program depends on, stage files first then includes
+    const std::vector<std::string>& files() const
+    {
+        return m_files;
+    }
+    // per-frame counters, reset them at the start of every frame
+    static UniformStats& frameStats()
+    {
+        static UniformStats stats;
+        return stats;
+    }
+    static void resetFrameStats()
+    {
+        frameStats() = UniformStats();
     }
     // utility uniform functions
     // ------------------------------------------------------------------------
-    void setBool(const std::string &name, bool value) const
+    void setBool(const UniformName &name, bool value) const
     {         
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value); 
+        setBool(uniform(name), value);
+    }
+    void setBool(UniformLocation location, bool value) const
+    {
+        glUniform1i(location.value, (int)value);
     }
     // ------------------------------------------------------------------------
-    void setInt(const std::string &name, int value) const
+    void setInt(const UniformName &name, int value) const
     { 
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value); 
+        setInt(uniform(name), value);
+    }
+    void setInt(UniformLocation location, int value) const
+    {
+        glUniform1i(location.value, value);
     }
     // ------------------------------------------------------------------------
-    void setFloat(const std::string &name, float value) const
+    void setFloat(const UniformName &name, float value) const
     { 
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value); 
+        setFloat(uniform(name), value);
+    }
+    void setFloat(UniformLocation location, float value) const
+    {
+        glUniform1f(location.value, value);
     }
     // ------------------------------------------------------------------------
-    void setVec2(const std::string &name, const glm::vec2 &value) const
+    void setVec2(const UniformName &name, const glm::vec2 &value) const
     { 
-        glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+        setVec2(uniform(name), value);
+    }
+    void setVec2(UniformLocation location, const glm::vec2 &value) const
+    {
+        glUniform2fv(location.value, 1, &value[0]);
     }
-    void setVec2(const std::string &name, float x, float y) const
+    void setVec2(const UniformName &name, float x, float y) const
     { 
-        glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y); 
+        glUniform2f(location(name), x, y); 
     }
     // ------------------------------------------------------------------------
-    void setVec3(const std::string &name, const glm::vec3 &value) const
+    void setVec3(const UniformName &name, const glm::vec3 &value) const
     { 
-        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+        setVec3(uniform(name), value);
+    }
+    void setVec3(UniformLocation location, const glm::vec3 &value) const
+    {
+        glUniform3fv(location.value, 1, &value[0]);
     }
-    void setVec3(const std::string &name, float x, float y, float z) const
+    void setVec3(const UniformName &name, float x, float y, float z) const
     { 
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z); 
+        glUniform3f(location(name), x, y, z); 
     }
     // ------------------------------------------------------------------------
-    void setVec4(const std::string &name, const glm::vec4 &value) const
+    void setVec4(const UniformName &name, const glm::vec4 &value) const
     { 
-        glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+        setVec4(uniform(name), value);
     }
-    void setVec4(const std::string &name, float x, float y, float z, float w) 
+    void setVec4(UniformLocation location, const glm::vec4 &value) const
+    {
+        glUniform4fv(location.value, 1, &value[0]);
+    }
+    void setVec4(const UniformName &name, float x, float y, float z, float w) const
     { 
-        glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w); 
+        glUniform4f(location(name), x, y, z, w); 
     }
     // ------------------------------------------------------------------------
-    void setMat2(const std::string &name, const glm::mat2 &mat) const
+    void setMat2(const UniformName &name, const glm::mat2 &mat) const
+    {
+        setMat2(uniform(name), mat);
+    }
+    void setMat2(UniformLocation location, const glm::mat2 &mat) const
     {
-        glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix2fv(location.value, 1, GL_FALSE, &mat[0][0]);
     }
     // ------------------------------------------------------------------------
-    void setMat3(const std::string &name, const glm::mat3 &mat) const
+    void setMat3(const UniformName &name, const glm::mat3 &mat) const
     {
-        glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        setMat3(uniform(name), mat);
+    }
+    void setMat3(UniformLocation location, const glm::mat3 &mat) const
+    {
+        glUniformMatrix3fv(location.value, 1, GL_FALSE, &mat[0][0]);
     }
     // ------------------------------------------------------------------------
-    void setMat4(const std::string &name, const glm::mat4 &mat) const
+    void setMat4(const UniformName &name, const glm::mat4 &mat) const
+    {
+        setMat4(uniform(name), mat);
+    }
+    void setMat4(UniformLocation location, const glm::mat4 &mat) const
     {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix4fv(location.value, 1, GL_FALSE, &mat[0][0]);
     }
 
 private:
-    // utility function for checking shader compilation/linking errors.
-    // ------------------------------------------------------------------------
-    void checkCompileErrors(GLuint shader, std::string type)
+    struct UniformEntry
+    {
+        uint32_t hash;
+        GLint location;
+        std::string name;   // compared on a hash hit, two names may share a hash
+
+        bool operator<(const UniformEntry& other) const { return hash < other.hash; }
+    };
+    // flat table sorted by name hash, filled from the active uniforms after linking. names with the
+    // same hash sit next to each other. mutable since names the reflection doesn't report are cached
+    // on first use.
+    mutable std::vector<UniformEntry> m_uniforms;
+    // set while the compile/link is still owned by the compile queue
+    mutable bool m_pending = false;
+    mutable bool m_linked = true;
+    // every file the program was built from, includes too
+    std::vector<std::string> m_files;
+    std::string m_vertexPath;
+    std::string m_fragmentPath;
+    std::string m_geometryPath;
+    std::string m_computePath;
+    ShaderDefines m_defines;
+    // program being rebuilt by reload(), 0 when there is none
+    GLuint m_reloadID = 0;
+    bool m_reloadPending = false;
+
+    // reads the sources and creates the program, either from the binary cache ('pending' false) or by
+    // submitting its compile and link to the compile queue ('pending' true)
+    GLuint build(bool &pending)
     {
-        GLint success;
-        GLchar infoLog[1024];
-        if(type != "PROGRAM")
+        if (!m_computePath.empty())
+            return buildCompute(pending);
+        // 1. retrieve the vertex/fragment source code from filePath, resolving includes and injecting defines
+        std::string vertexCode;
+        std::string fragmentCode;
+        std::string geometryCode;
+        bool hasGeometry = !m_geometryPath.empty();
+        if (!readStage(m_vertexPath.c_str(), m_defines, vertexCode) || !readStage(m_fragmentPath.c_str(), m_defines, fragmentCode) ||
+            (hasGeometry && !readStage(m_geometryPath.c_str(), m_defines, geometryCode)))
+        {
+            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ" << std::endl;
+        }
+        // 2. reuse the program binary of a previous run when the driver accepts it
+        GLuint program = glCreateProgram();
+        std::vector<std::string> sources = { vertexCode, fragmentCode, geometryCode };
+        uint64_t cacheKey = programBinaryCache().key(sources);
+        if (programBinaryCache().load(cacheKey, program))
+        {
+            pending = false;
+            return program;
+        }
+        // 3. compile shaders and link the program. Nothing here waits on the driver: the
+        // compile/link status is checked by the compile queue, at the latest on first use.
+        std::vector<GLuint> stages;
+        std::vector<const char*> types;
+        stages.push_back(compileStage(GL_VERTEX_SHADER, vertexCode));
+        types.push_back("VERTEX");
+        stages.push_back(compileStage(GL_FRAGMENT_SHADER, fragmentCode));
+        types.push_back("FRAGMENT");
+        // if geometry shader is given, compile geometry shader
+        if(hasGeometry)
         {
-            glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-            if(!success)
+            stages.push_back(compileStage(GL_GEOMETRY_SHADER, geometryCode));
+            types.push_back("GEOMETRY");
+        }
+        // shader Program
+        for (GLuint stage : stages)
+            glAttachShader(program, stage);
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        glLinkProgram(program);
+        shaderCompileQueue().submit(program, stages, types, cacheKey, label());
+        pending = true;
+        return program;
+    }
+
+    GLuint buildCompute(bool &pending)
+    {
+        std::string computeCode;
+        if (!readStage(m_computePath.c_str(), m_defines, computeCode))
+            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ" << std::endl;
+        GLuint program = glCreateProgram();
+        std::vector<std::string> sources = { computeCode };
+        uint64_t cacheKey = programBinaryCache().key(sources);
+        if (programBinaryCache().load(cacheKey, program))
+        {
+            pending = false;
+            return program;
+        }
+        std::vector<GLuint> stages(1, compileStage(GL_COMPUTE_SHADER, computeCode));
+        std::vector<const char*> types(1, "COMPUTE");
+        glAttachShader(program, stages[0]);
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        glLinkProgram(program);
+        shaderCompileQueue().submit(program, stages, types, cacheKey, label());
+        pending = true;
+        return program;
+    }
+
+    void discardReload()
+    {
+        if (m_reloadID == 0)
+            return;
+        if (m_reloadPending)
+            shaderCompileQueue().wait(m_reloadID);
+        glDeleteProgram(m_reloadID);
+        m_reloadID = 0;
+        m_reloadPending = false;
+    }
+
+    // carries the values set on the old program (sampler units, projection...) over to the reloaded one
+    static void copyUniformValues(GLuint from, GLuint to)
+    {
+        GLint count = 0;
+        GLint maxLength = 0;
+        glGetProgramiv(to, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(to, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+        std::vector<GLchar> buffer(maxLength > 0 ? maxLength : 1);
+        for (GLint i = 0; i < count; ++i)
+        {
+            GLsizei length = 0;
+            GLint size = 0;
+            GLenum type = 0;
+            glGetActiveUniform(to, (GLuint)i, maxLength, &length, &size, &type, buffer.data());
+            std::string name(buffer.data(), length);
+            bool array = name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0;
+            std::string base = array ? name.substr(0, name.size() - 3) : name;
+            for (GLint element = 0; element < size; ++element)
             {
-                glGetShaderInfoLog(shader, 1024, NULL, infoLog);
-                std::cout << "ERROR::SHADER_COMPILATION_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
+                std::string elementName = array ? base + "[" + std::to_string(element) + "]" : name;
+                GLint source = glGetUniformLocation(from, elementName.c_str());
+                GLint target = glGetUniformLocation(to, elementName.c_str());
+                if (source < 0 || target < 0)
+                    continue;
+                GLfloat f[16];
+                GLint n[4];
+                switch (type)
+                {
+                case GL_FLOAT:      glGetUniformfv(from, source, f); glProgramUniform1fv(to, target, 1, f); break;
+                case GL_FLOAT_VEC2: glGetUniformfv(from, source, f); glProgramUniform2fv(to, target, 1, f); break;
+                case GL_FLOAT_VEC3: glGetUniformfv(from, source, f); glProgramUniform3fv(to, target, 1, f); break;
+                case GL_FLOAT_VEC4: glGetUniformfv(from, source, f); glProgramUniform4fv(to, target, 1, f); break;
+                case GL_FLOAT_MAT2: glGetUniformfv(from, source, f); glProgramUniformMatrix2fv(to, target, 1, GL_FALSE, f); break;
+                case GL_FLOAT_MAT3: glGetUniformfv(from, source, f); glProgramUniformMatrix3fv(to, target, 1, GL_FALSE, f); break;
+                case GL_FLOAT_MAT4: glGetUniformfv(from, source, f); glProgramUniformMatrix4fv(to, target, 1, GL_FALSE, f); break;
+                case GL_INT_VEC2:
+                case GL_BOOL_VEC2:  glGetUniformiv(from, source, n); glProgramUniform2iv(to, target, 1, n); break;
+                case GL_INT_VEC3:
+                case GL_BOOL_VEC3:  glGetUniformiv(from, source, n); glProgramUniform3iv(to, target, 1, n); break;
+                case GL_INT_VEC4:
+                case GL_BOOL_VEC4:  glGetUniformiv(from, source, n); glProgramUniform4iv(to, target, 1, n); break;
+                case GL_UNSIGNED_INT:
+                    glGetUniformuiv(from, source, reinterpret_cast<GLuint*>(n)); glProgramUniform1uiv(to, target, 1, reinterpret_cast<GLuint*>(n)); break;
+                default:
+                    // int, bool and every sampler/image type are set as a single int
+                    glGetUniformiv(from, source, n); glProgramUniform1iv(to, target, 1, n); break;
+                }
             }
         }
-        else
+    }
+
+    bool readStage(const char* path, const ShaderDefines& defines, std::string& code)
+    {
+        std::vector<std::string> files;
+        bool success = preprocessShader(path, defines, code, files);
+        if (!success)
+            std::cout << "ERROR::SHADER::CANNOT_OPEN: " << path << std::endl;
+        for (const std::string& file : files)
+        {
+            if (std::find(m_files.begin(), m_files.end(), file) == m_files.end())
+                m_files.push_back(file);
+        }
+        return success;
+    }
+
+    static GLuint compileStage(GLenum type, const std::string &code)
+    {
+        const char* source = code.c_str();
+        GLuint shader = glCreateShader(type);
+        glShaderSource(shader, 1, &source, NULL);
+        glCompileShader(shader);
+        return shader;
+    }
+
+    // first entry with the hash of 'name' (or where it would go), then the one with its exact name
+    std::vector<UniformEntry>::iterator findUniform(uint32_t hash, const char* name, std::vector<UniformEntry>::iterator& insertAt) const
+    {
+        UniformEntry key = { hash, -1 };
+        std::vector<UniformEntry>::iterator it = std::lower_bound(m_uniforms.begin(), m_uniforms.end(), key);
+        for (; it != m_uniforms.end() && it->hash == hash; ++it)
+        {
+            if (it->name == name)
+                return it;
+        }
+        insertAt = it;
+        return m_uniforms.end();
+    }
+
+    GLint location(const UniformName &name) const
+    {
+        ensureLinked();
+        std::vector<UniformEntry>::iterator insertAt;
+        std::vector<UniformEntry>::iterator it = findUniform(name.hash, name.str, insertAt);
+        if (it != m_uniforms.end())
+        {
+            ++frameStats().cached;
+            return it->location;
+        }
+        // unknown name (misspelled or optimized out): ask the driver once and remember the answer, -1 included
+        ++frameStats().driver;
+        GLint location = glGetUniformLocation(ID, name.str);
+        m_uniforms.insert(insertAt, UniformEntry{ name.hash, location, name.str });
+        return location;
+    }
+
+    void addUniform(const std::string &name, GLint location) const
+    {
+        uint32_t hash = fnv1a(name.c_str(), name.size());
+        std::vector<UniformEntry>::iterator insertAt;
+        if (findUniform(hash, name.c_str(), insertAt) != m_uniforms.end())
+            return;
+        // still resolved correctly by the name comparison, only slower
+        if (insertAt != m_uniforms.begin() && (insertAt - 1)->hash == hash)
+            std::cout << "WARNING::SHADER::UNIFORM_HASH_COLLISION: " << name << " and " << (insertAt - 1)->name << std::endl;
+        m_uniforms.insert(insertAt, UniformEntry{ hash, location, name });
+    }
+
+    // builds the uniform table, array uniforms are registered under "name", "name[0]" ... "name[size - 1]"
+    void reflectUniforms() const
+    {
+        m_uniforms.clear();
+        GLint count = 0;
+        GLint maxLength = 0;
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+        std::vector<GLchar> buffer(maxLength > 0 ? maxLength : 1);
+        for (GLint i = 0; i < count; ++i)
         {
-            glGetProgramiv(shader, GL_LINK_STATUS, &success);
-            if(!success)
+            GLsizei length = 0;
+            GLint size = 0;
+            GLenum type = 0;
+            glGetActiveUniform(ID, (GLuint)i, maxLength, &length, &size, &type, buffer.data());
+            std::string name(buffer.data(), length);
+            GLint location = glGetUniformLocation(ID, name.c_str());
+            if (location < 0)
+                continue; // uniform block member
+            size_t bracket = name.size() > 3 ? name.size() - 3 : std::string::npos;
+            if (bracket != std::string::npos && name.compare(bracket, 3, "[0]") == 0)
+            {
+                std::string base = name.substr(0, bracket);
+                addUniform(base, location);
+                for (GLint element = 0; element < size; ++element)
+                    addUniform(base + "[" + std::to_string(element) + "]", location + element);
+            }
+            else
             {
-                glGetProgramInfoLog(shader, 1024, NULL, infoLog);
-                std::cout << "ERROR::PROGRAM_LINKING_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
+                addUniform(name, location);
             }
         }
     }
@@ -4,13 +4,14 @@ in vec3 WorldPos;
 
 uniform samplerCube environmentMap;
 
+#include "include/color_lut.glsl"
+
 void main()
 {		
     vec3 envColor = texture(environmentMap, WorldPos).rgb;
     
     // HDR tonemap and gamma correct
-    envColor = envColor / (envColor + vec3(1.0));
-    envColor = pow(envColor, vec3(1.0 / 2.2)); 
+    envColor = applyColorLut(envColor);
     
     FragColor = vec4(envColor, 1.0);
 }
\ No newline at end of file
@@ -1,8 +1,7 @@
 #version 450 core
 layout (location = 0) in vec3 aPos;
 
-uniform mat4 projection;
-uniform mat4 view;
+#include "include/camera.glsl"
 
 out vec3 WorldPos;
 
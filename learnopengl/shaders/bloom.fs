@@ -1,6 +1,6 @@
 #version 450 core
-layout (location = 0) out vec4 FragColor;
-layout (location = 1) out vec4 BrightColor;
+
+out vec4 FragColor;
 
 in VS_OUT {
     vec3 FragPos;
@@ -8,12 +8,8 @@ in VS_OUT {
     vec2 TexCoords;
 } fs_in;
 
-struct Light {
-    vec3 Position;
-    vec3 Color;
-};
+#include "include/lights.glsl"
 
-uniform Light lights[4];
 uniform sampler2D diffuseTexture;
 uniform vec3 viewPos;
 
@@ -26,24 +22,19 @@ void main()
     // lighting
     vec3 lighting = vec3(0.0);
     vec3 viewDir = normalize(viewPos - fs_in.FragPos);
-    for(int i = 0; i < 4; i++)
+    for(uint i = 0; i < lightCount; i++)
     {
         // diffuse
-        vec3 lightDir = normalize(lights[i].Position - fs_in.FragPos);
+        vec3 lightDir = normalize(lights[i].position - fs_in.FragPos);
         float diff = max(dot(lightDir, normal), 0.0);
-        vec3 result = lights[i].Color * diff * color;      
+        vec3 result = lights[i].color * diff * color;      
         // attenuation (use quadratic as we have gamma correction)
-        float distance = length(fs_in.FragPos - lights[i].Position);
+        float distance = length(fs_in.FragPos - lights[i].position);
         result *= 1.0 / (distance * distance);
         lighting += result;
                 
     }
     vec3 result = ambient + lighting;
-    // check whether result is higher than some threshold, if so, output as bloom threshold color
-    float brightness = dot(result, vec3(0.2126, 0.7152, 0.0722));
-    if(brightness > 1.0)
-        BrightColor = vec4(result, 1.0);
-    else
-        BrightColor = vec4(0.0, 0.0, 0.0, 1.0);
+    // the bright parts are picked by the first bloom downsample
     FragColor = vec4(result, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,71 @@
+#version 450 core
+
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D source;
+uniform bool prefilter;     // first level: bright pass and firefly suppression
+uniform float threshold;
+uniform float knee;
+
+const vec3 luma = vec3(0.2126, 0.7152, 0.0722);
+
+// luminance above threshold passes, with a quadratic ramp over 'knee' below it instead of a hard cut
+vec3 brightPass(vec3 color) {
+    float brightness = dot(color, luma);
+    float soft = clamp(brightness - threshold + knee, 0.0, 2.0 * knee);
+    soft = soft * soft / (4.0 * knee + 1e-4);
+    return color * max(soft, brightness - threshold) / max(brightness, 1e-4);
+}
+
+// single very bright texels would flicker as they move between the 2x2 boxes, weigh them down
+float karisWeight(vec3 color) {
+    return 1.0 / (1.0 + dot(color, luma));
+}
+
+// 13 taps around the destination texel (two texels of the source apart), the weighted sum of five
+// overlapping 2x2 boxes: the center one and the four corner ones
+void main() {
+    vec2 texel = 1.0 / textureSize(source, 0);
+    vec3 a = texture(source, TexCoords + texel * vec2(-2.0,  2.0)).rgb;
+    vec3 b = texture(source, TexCoords + texel * vec2( 0.0,  2.0)).rgb;
+    vec3 c = texture(source, TexCoords + texel * vec2( 2.0,  2.0)).rgb;
+    vec3 d = texture(source, TexCoords + texel * vec2(-2.0,  0.0)).rgb;
+    vec3 e = texture(source, TexCoords).rgb;
+    vec3 f = texture(source, TexCoords + texel * vec2( 2.0,  0.0)).rgb;
+    vec3 g = texture(source, TexCoords + texel * vec2(-2.0, -2.0)).rgb;
+    vec3 h = texture(source, TexCoords + texel * vec2( 0.0, -2.0)).rgb;
+    vec3 i = texture(source, TexCoords + texel * vec2( 2.0, -2.0)).rgb;
+    vec3 j = texture(source, TexCoords + texel * vec2(-1.0,  1.0)).rgb;
+    vec3 k = texture(source, TexCoords + texel * vec2( 1.0,  1.0)).rgb;
+    vec3 l = texture(source, TexCoords + texel * vec2(-1.0, -1.0)).rgb;
+    vec3 m = texture(source, TexCoords + texel * vec2( 1.0, -1.0)).rgb;
+
+    vec3 result;
+    if (prefilter) {
+        vec3 boxes[5] = vec3[](
+            (j + k + l + m) * 0.25,
+            (a + b + d + e) * 0.25,
+            (b + c + e + f) * 0.25,
+            (d + e + g + h) * 0.25,
+            (e + f + h + i) * 0.25
+        );
+        float weights[5] = float[](0.5, 0.125, 0.125, 0.125, 0.125);
+        result = vec3(0.0);
+        float total = 0.0;
+        for (int box = 0; box < 5; ++box) {
+            float weight = weights[box] * karisWeight(boxes[box]);
+            result += boxes[box] * weight;
+            total += weight;
+        }
+        result = brightPass(result / total);
+    } else {
+        result = e * 0.125;
+        result += (a + c + g + i) * 0.03125;
+        result += (b + d + f + h) * 0.0625;
+        result += (j + k + l + m) * 0.125;
+    }
+    // R11G11B10F can't hold negatives
+    FragColor = vec4(max(result, 0.0), 1.0);
+}
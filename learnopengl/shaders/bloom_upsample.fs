@@ -0,0 +1,19 @@
+#version 450 core
+
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D source;
+uniform float radius;       // tent size in texels of the source
+
+// 3x3 tent filter over the smaller level, blended additively onto the next larger one
+void main() {
+    vec2 texel = radius / textureSize(source, 0);
+    vec3 result = texture(source, TexCoords).rgb * 4.0;
+    result += (texture(source, TexCoords + vec2(texel.x, 0.0)).rgb + texture(source, TexCoords - vec2(texel.x, 0.0)).rgb) * 2.0;
+    result += (texture(source, TexCoords + vec2(0.0, texel.y)).rgb + texture(source, TexCoords - vec2(0.0, texel.y)).rgb) * 2.0;
+    result += texture(source, TexCoords + texel).rgb + texture(source, TexCoords - texel).rgb;
+    result += texture(source, TexCoords + vec2(texel.x, -texel.y)).rgb + texture(source, TexCoords + vec2(-texel.x, texel.y)).rgb;
+    FragColor = vec4(result / 16.0, 1.0);
+}
@@ -0,0 +1,9 @@
+#version 450 core
+
+out vec2 TexCoords;
+
+// vertices 0, 1, 2 at (0, 0), (2, 0), (0, 2) in texture space, the part inside [0, 1] covers the viewport
+void main() {
+    TexCoords = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    gl_Position = vec4(TexCoords * 2.0 - 1.0, 0.0, 1.0);
+}
@@ -1,7 +1,16 @@
 #version 450 core
+// GBUFFER_COMPACT: octahedral RG16 normals and RGBA8 albedo/specular, position comes from the depth
+// buffer in the lighting pass. Otherwise position, normal and albedo/specular are stored explicitly.
+#ifdef GBUFFER_COMPACT
+layout (location = 0) out vec2 gNormal;
+layout (location = 1) out vec4 gAlbedoSpec;
+
+#include "include/octahedral.glsl"
+#else
 layout (location = 0) out vec3 gPosition;
 layout (location = 1) out vec3 gNormal;
 layout (location = 2) out vec4 gAlbedoSpec;
+#endif
 
 in vec2 TexCoords;
 in vec3 FragPos;
@@ -13,15 +22,19 @@ uniform sampler2D texture_normal1;
 
 void main()
 {    
+    vec3 normal = texture(texture_normal1, TexCoords).rgb;
+    normal = normalize(TBN * (normal * 2.0 - 1.0));
+#ifdef GBUFFER_COMPACT
+    // world space normal, folded into two snorm channels
+    gNormal = octEncode(normal);
+#else
     // store the fragment position vector in the first gbuffer texture
     gPosition = FragPos;
-
-    vec3 normal = texture(texture_normal1, TexCoords).rgb;
-    normal = normal * 2.0 - 1.0;
     // also store the per-fragment normals into the gbuffer
-    gNormal = normalize(normal);
+    gNormal = normal;
+#endif
     // and the diffuse per-fragment color
     gAlbedoSpec.rgb = texture(texture_diffuse1, TexCoords).rgb;
     // store specular intensity in gAlbedoSpec's alpha component
     gAlbedoSpec.a = texture(texture_specular1, TexCoords).r;
-}
\ No newline at end of file
+}
@@ -0,0 +1,9 @@
+// per-frame camera data, mirrors CameraBlock in rendering/uniform_blocks.h
+layout(std140, binding = 0) uniform Camera {
+    mat4 projection;
+    mat4 view;
+    mat4 viewProjection;
+    mat4 inverseViewProjection;
+    vec3 camPos;
+    float time;
+};
@@ -0,0 +1,18 @@
+// clustered light lists, mirrors LightClusters in rendering/light_clusters.h
+layout(std430, binding = 1) readonly buffer Clusters {
+    uvec4 clusterGrid;      // cluster counts x, y, z
+    vec4 clusterDepth;      // slice = log(depth) * x + y, tile size in pixels in zw
+    uvec2 clusters[];       // offset into clusterLightIndices, light count
+};
+
+layout(std430, binding = 2) readonly buffer ClusterLightIndices {
+    uint clusterLightIndices[];
+};
+
+// (offset, count) of the lights touching the cluster of a fragment, viewDepth is positive
+uvec2 clusterLights(vec2 fragCoord, float viewDepth) {
+    uvec2 tile = min(uvec2(fragCoord / clusterDepth.zw), clusterGrid.xy - 1u);
+    float slice = floor(log(max(viewDepth, 1e-4)) * clusterDepth.x + clusterDepth.y);
+    uint z = uint(clamp(slice, 0.0, float(clusterGrid.z - 1u)));
+    return clusters[(z * clusterGrid.y + tile.y) * clusterGrid.x + tile.x];
+}
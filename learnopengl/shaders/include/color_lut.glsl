@@ -0,0 +1,9 @@
+// tonemapping, color grading and gamma baked into a 3D texture, mirrors ColorLut in post/color_lut.h
+uniform sampler3D colorLut;
+uniform vec3 colorLutDomain;    // texture coordinate = log2(color + x) * y + z
+
+// exposed scene linear color to display color
+vec3 applyColorLut(vec3 color) {
+    vec3 coordinate = log2(max(color, 0.0) + colorLutDomain.x) * colorLutDomain.y + colorLutDomain.z;
+    return texture(colorLut, coordinate).rgb;
+}
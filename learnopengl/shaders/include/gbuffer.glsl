@@ -0,0 +1,52 @@
+// G-buffer decoding and the per-light shading of the deferred path, shared by lighting_pass.fs and
+// light_volume.fs. Needs camera.glsl and lights.glsl; GBUFFER_COMPACT matches GBuffer in rendering/gbuffer.h
+#include "octahedral.glsl"
+
+#ifdef GBUFFER_COMPACT
+uniform sampler2D gDepth;
+#else
+uniform sampler2D gPosition;
+#endif
+uniform sampler2D gNormal;
+uniform sampler2D gAlbedoSpec;
+
+struct GBufferSample {
+    vec3 position;
+    vec3 normal;
+    vec3 albedo;
+    float specular;
+};
+
+GBufferSample readGBuffer(vec2 uv) {
+    GBufferSample g;
+#ifdef GBUFFER_COMPACT
+    // world position from the depth buffer: back through the inverse view projection
+    vec4 clipPos = vec4(vec3(uv, texture(gDepth, uv).r) * 2.0 - 1.0, 1.0);
+    vec4 worldPos = inverseViewProjection * clipPos;
+    g.position = worldPos.xyz / worldPos.w;
+    g.normal = octDecode(texture(gNormal, uv).rg);
+#else
+    g.position = texture(gPosition, uv).rgb;
+    g.normal = texture(gNormal, uv).rgb;
+#endif
+    vec4 albedoSpec = texture(gAlbedoSpec, uv);
+    g.albedo = albedoSpec.rgb;
+    g.specular = albedoSpec.a;
+    return g;
+}
+
+// blinn-phong with the light's linear/quadratic falloff, nothing beyond its radius (0 = unbounded)
+vec3 shadeDeferredLight(PointLight light, GBufferSample g, vec3 viewDir) {
+    float distance = length(light.position - g.position);
+    if (light.radius > 0.0 && distance >= light.radius)
+        return vec3(0.0);
+
+    vec3 lightDir = normalize(light.position - g.position);
+    vec3 diff = max(dot(g.normal, lightDir), 0.0) * g.albedo * light.color;
+
+    vec3 halfway = normalize(lightDir + viewDir);
+    vec3 spec = pow(max(dot(g.normal, halfway), 0.0), 32.0) * g.specular * light.color;
+
+    float attenuation = 1.0 / (1.0 + light.linear * distance + light.quadratic * distance * distance);
+    return (diff + spec) * attenuation;
+}
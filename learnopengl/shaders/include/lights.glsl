@@ -0,0 +1,13 @@
+// point lights, mirrors PointLight / LightBuffer in rendering/light_buffer.h
+struct PointLight {
+    vec3 position;
+    float radius;
+    vec3 color;
+    float linear;
+    float quadratic;
+};
+
+layout(std430, binding = 0) readonly buffer Lights {
+    uint lightCount;
+    PointLight lights[];
+};
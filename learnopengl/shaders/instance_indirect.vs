@@ -0,0 +1,22 @@
+#version 450 core
+
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+layout (location = 3) in uint aInstance;    // index into models, written by cull_instances.comp
+
+layout (std430, binding = 0) readonly buffer Instances {
+    mat4 models[];
+};
+
+out vec2 TexCoords;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform mat4 transform;
+
+void main() {
+    TexCoords = aTexCoords;
+
+    gl_Position = projection * view * transform * models[aInstance] * vec4(aPos, 1.0);
+}
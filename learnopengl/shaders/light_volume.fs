@@ -0,0 +1,18 @@
+#version 450 core
+// shades the G-buffer pixels covered by one light volume, accumulated with additive blending
+
+out vec4 FragColor;
+
+flat in uint LightIndex;
+
+uniform vec2 screenSize;
+
+#include "include/camera.glsl"
+#include "include/lights.glsl"
+#include "include/gbuffer.glsl"
+
+void main() {
+    GBufferSample g = readGBuffer(gl_FragCoord.xy / screenSize);
+    vec3 viewDir = normalize(camPos - g.position);
+    FragColor = vec4(shadeDeferredLight(lights[LightIndex], g, viewDir), 1.0);
+}
@@ -0,0 +1,32 @@
+#version 450 core
+// one instance per light: the unit sphere mesh scaled to the light's radius.
+// UNBOUNDED_LIGHT: a light without a radius covers the whole screen, the light 'lightIndex' is drawn
+// as a full screen triangle instead (vertices from gl_VertexID, as in fullscreen.vs)
+
+layout (location = 0) in vec3 aPos;
+
+flat out uint LightIndex;
+
+#include "include/camera.glsl"
+#include "include/lights.glsl"
+
+#ifdef UNBOUNDED_LIGHT
+uniform int lightIndex;
+#endif
+
+void main() {
+#ifdef UNBOUNDED_LIGHT
+    LightIndex = uint(lightIndex);
+    vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);
+#else
+    LightIndex = uint(gl_InstanceID);
+    PointLight light = lights[gl_InstanceID];
+    // unbounded lights have no volume, collapse them outside the clip volume
+    if (light.radius <= 0.0) {
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+        return;
+    }
+    gl_Position = viewProjection * vec4(light.position + aPos * light.radius, 1.0);
+#endif
+}
@@ -10,19 +10,24 @@ in VS_OUT {
 
 uniform sampler2D albedoMap;
 uniform sampler2D normalMap;
+#ifdef USE_ORM
+// packed occlusion (r), roughness (g), metallic (b)
+uniform sampler2D ormMap;
+#else
 uniform sampler2D metallicMap;
 uniform sampler2D roughnessMap;
 uniform sampler2D aoMap;
+#endif
 uniform samplerCube irradianceMap;
 uniform samplerCube prefilterMap;
 uniform sampler2D brdfLUT;
 
-uniform vec3 lightPositions[4];
-uniform vec3 lightColors[4];
+#include "include/camera.glsl"
+#include "include/lights.glsl"
+#include "include/clusters.glsl"
 
-uniform vec3 camPos;
-
-const float PI = 3.14159265359;
+#include "include/brdf_functions.glsl"
+#include "include/color_lut.glsl"
 
 vec3 getNormalFromMap()
 {
@@ -41,53 +46,19 @@ vec3 getNormalFromMap()
     return normalize(TBN * tangentNormal);
 }
 
-float DistributionGGX(vec3 N, vec3 H, float roughness) {
-    float a = roughness * roughness;
-    float a2 = a * a;
-    float NdotH = max(dot(N, H), 0.0);
-    float NdotH2 = NdotH * NdotH;
-
-    float nom = a2;
-    float denom = NdotH2 * (a2 - 1.0) + 1.0;
-    denom = PI * denom * denom;
-
-    return nom / denom;
-}
-
-float GeometrySchlickGGX(float NdotV, float roughness) {
-    float r = (roughness + 1.0);
-    float k = (r * r) / 8.0;
-    
-    float nom = NdotV;
-    float denom = NdotV * (1.0 - k) + k;
-
-    return nom / denom;
-}
-
-float GeometrySmith(vec3 N, vec3 V, vec3 L, float roughness) {
-    float NdotV = max(dot(N, V), 0.0);
-    float NdotL = max(dot(N, L), 0.0);
-
-    float ggx1 = GeometrySchlickGGX(NdotV, roughness);
-    float ggx2 = GeometrySchlickGGX(NdotL, roughness);
-
-    return ggx1 * ggx2;
-}
-
-vec3 FresnelSchlick(float cosTheta, vec3 F0) {
-    return F0 + (1.0 - F0) * pow(clamp(1.0 - cosTheta, 0.0, 1.0), 5);
-}
-
-vec3 FresnelSchlickRoughness(float cosTheta, vec3 F0, float roughness) {
-    return F0 + (max(vec3(1.0 - roughness), F0) - F0) * pow(clamp(1.0 - cosTheta, 0.0, 1.0), 5);
-}
-
 void main() {
     vec3 albedo = pow(texture(albedoMap, fs_in.TexCoords).rgb, vec3(2.2));
     vec3 normal = texture(normalMap, fs_in.TexCoords).rgb;
+#ifdef USE_ORM
+    vec3 orm = texture(ormMap, fs_in.TexCoords).rgb;
+    float ao = orm.r;
+    float roughness = orm.g;
+    float metallic = orm.b;
+#else
     float metallic = texture(metallicMap, fs_in.TexCoords).r;
     float roughness = texture(roughnessMap, fs_in.TexCoords).r;
     float ao = texture(aoMap, fs_in.TexCoords).r;
+#endif
 
     vec3 N = getNormalFromMap();
     vec3 V = normalize(camPos - fs_in.WorldPos);
@@ -97,12 +68,18 @@ void main() {
     F0 = mix(F0, albedo, metallic);
 
     vec3 L0 = vec3(0.0);
-    for (int i = 0; i < 4; ++i) {
-        vec3 L = normalize(lightPositions[i] - fs_in.WorldPos);
+    float viewDepth = -(view * vec4(fs_in.WorldPos, 1.0)).z;
+    uvec2 cluster = clusterLights(gl_FragCoord.xy, viewDepth);
+    for (uint c = 0; c < cluster.y; ++c) {
+        uint i = clusterLightIndices[cluster.x + c];
+        float distance = length(lights[i].position - fs_in.WorldPos);
+        if (lights[i].radius > 0.0 && distance > lights[i].radius)
+            continue;
+
+        vec3 L = normalize(lights[i].position - fs_in.WorldPos);
         vec3 H = normalize(V + L);
-        float distance = length(lightPositions[i] - fs_in.WorldPos);
         float attenuation = 1.0 / (distance * distance);
-        vec3 radiance = lightColors[i] * attenuation;
+        vec3 radiance = lights[i].color * attenuation;
 
         float NDF = DistributionGGX(N, H, roughness);
         float G = GeometrySmith(N, V, L, roughness);
@@ -139,8 +116,8 @@ void main() {
 
     vec3 color = ambient + L0;
 
-    color = color / (color + vec3(1.0));
-    color = pow(color, vec3(1.0 / 2.2));
+    // tonemapping and gamma correction
+    color = applyColorLut(color);
 
     FragColor = vec4(color, 1.0);
 }
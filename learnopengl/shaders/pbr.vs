@@ -3,6 +3,9 @@
 layout(location = 0) in vec3 aPos;
 layout(location = 1) in vec3 aNormal;
 layout(location = 2) in vec2 aTexCoords;
+// per-instance, see setSphereInstances() in main.cpp
+layout(location = 3) in mat4 model;
+layout(location = 7) in mat3 normalMatrix;
 
 out VS_OUT {
     vec2 TexCoords;
@@ -10,15 +13,12 @@ out VS_OUT {
     vec3 Normal;
 } vs_out;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
-uniform mat3 normalMatrix;
+#include "include/camera.glsl"
 
 void main() {
     vs_out.TexCoords = aTexCoords;
     vs_out.WorldPos = vec3(model * vec4(aPos, 1.0));
     vs_out.Normal = normalMatrix * aNormal;
 
-    gl_Position = projection * view * vec4(vs_out.WorldPos, 1.0);
+    gl_Position = viewProjection * vec4(vs_out.WorldPos, 1.0);
 }
\ No newline at end of file
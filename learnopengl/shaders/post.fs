@@ -0,0 +1,35 @@
+#version 450 core
+
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+// one program per combination of effects, generated by PostProcess in post/post_process.h:
+//   POST_BLOOM       adds the bloom chain's result
+//   POST_COLOR_LUT   tonemapping, grading and gamma from the baked LUT, without it the exposed
+//                    color is only clamped and gamma corrected
+uniform sampler2D scene;
+uniform float exposure;
+
+#ifdef POST_BLOOM
+uniform sampler2D bloom;
+uniform float bloomIntensity;
+#endif
+
+#ifdef POST_COLOR_LUT
+#include "include/color_lut.glsl"
+#endif
+
+void main() {
+    vec3 color = texture(scene, TexCoords).rgb;
+#ifdef POST_BLOOM
+    color += texture(bloom, TexCoords).rgb * bloomIntensity;
+#endif
+    color *= exposure;
+#ifdef POST_COLOR_LUT
+    color = applyColorLut(color);
+#else
+    color = pow(clamp(color, 0.0, 1.0), vec3(1.0 / 2.2));
+#endif
+    FragColor = vec4(color, 1.0);
+}
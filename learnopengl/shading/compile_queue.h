@@ -0,0 +1,244 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include "program_cache.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// GL_KHR_parallel_shader_compile / GL_ARB_parallel_shader_compile, not part of our glad profile
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+
+// utility function for checking shader compilation/linking errors, returns true on success.
+// ------------------------------------------------------------------------
+inline bool checkCompileErrors(GLuint shader, const std::string& type)
+{
+    GLint success;
+    GLchar infoLog[1024];
+    if(type != "PROGRAM")
+    {
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+        if(!success)
+        {
+            glGetShaderInfoLog(shader, 1024, NULL, infoLog);
+            std::cout << "ERROR::SHADER_COMPILATION_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
+        }
+    }
+    else
+    {
+        glGetProgramiv(shader, GL_LINK_STATUS, &success);
+        if(!success)
+        {
+            glGetProgramInfoLog(shader, 1024, NULL, infoLog);
+            std::cout << "ERROR::PROGRAM_LINKING_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
+        }
+    }
+    return success != 0;
+}
+
+// Programs whose compile and link have been issued but whose status hasn't been queried yet.
+// Querying GL_COMPILE_STATUS/GL_LINK_STATUS right after glLinkProgram forces the driver to finish
+// that program before the next one is even submitted, so Shader only submits and the checks happen
+// here: lazily on first use of the program, or in poll() once the driver reports completion
+// (GL_COMPLETION_STATUS_KHR, never blocks) when parallel compilation is available.
+class ShaderCompileQueue {
+    private:
+        typedef std::chrono::steady_clock Clock;
+
+        struct Stage {
+            GLuint shader;
+            const char* type;
+        };
+
+        struct PendingProgram {
+            GLuint program;
+            std::vector<Stage> stages;
+            uint64_t cacheKey;
+            std::string label;
+            Clock::time_point submitted;
+        };
+
+        struct Timing {
+            std::string label;
+            double submittedMs;
+            double finishedMs;
+            bool success;
+            bool blocked;
+        };
+
+        std::vector<PendingProgram> m_pending;
+        std::vector<Timing> m_timings;
+        Clock::time_point m_phaseStart;
+        bool m_initialized = false;
+        bool m_parallel = false;
+
+        void initialize() {
+            if (m_initialized) {
+                return;
+            }
+            m_initialized = true;
+
+            GLint count = 0;
+            glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+            for (GLint i = 0; i < count; ++i) {
+                const char* name = (const char*)glGetStringi(GL_EXTENSIONS, i);
+                if (name && (std::strcmp(name, "GL_KHR_parallel_shader_compile") == 0 || std::strcmp(name, "GL_ARB_parallel_shader_compile") == 0)) {
+                    m_parallel = true;
+                    break;
+                }
+            }
+        }
+
+        double since(Clock::time_point start, Clock::time_point now) const {
+            return std::chrono::duration<double, std::milli>(now - start).count();
+        }
+
+        bool complete(const PendingProgram& pending) const {
+            if (!m_parallel) {
+                return false;
+            }
+            GLint done = GL_FALSE;
+            glGetProgramiv(pending.program, GL_COMPLETION_STATUS_KHR, &done);
+            return done == GL_TRUE;
+        }
+
+        bool finish(std::vector<PendingProgram>::iterator it, bool blocked) {
+            bool success = true;
+            for (const Stage& stage : it->stages) {
+                success = checkCompileErrors(stage.shader, stage.type) && success;
+            }
+            success = checkCompileErrors(it->program, "PROGRAM") && success;
+            for (const Stage& stage : it->stages) {
+                glDetachShader(it->program, stage.shader);
+                glDeleteShader(stage.shader);
+            }
+            if (success) {
+                programBinaryCache().store(it->cacheKey, it->program);
+            }
+
+            Timing timing = { it->label, since(m_phaseStart, it->submitted), since(m_phaseStart, Clock::now()), success, blocked };
+            m_timings.push_back(timing);
+            m_pending.erase(it);
+            return success;
+        }
+
+    public:
+        // takes ownership of the shader objects, which must already be attached to the program and
+        // the program linked (glLinkProgram issued)
+        void submit(GLuint program, const std::vector<GLuint>& shaders, const std::vector<const char*>& types, uint64_t cacheKey, const std::string& label) {
+            initialize();
+            if (m_pending.empty() && m_timings.empty()) {
+                m_phaseStart = Clock::now();
+            }
+
+            PendingProgram pending;
+            pending.program = program;
+            for (size_t i = 0; i < shaders.size(); ++i) {
+                Stage stage = { shaders[i], types[i] };
+                pending.stages.push_back(stage);
+            }
+            pending.cacheKey = cacheKey;
+            pending.label = label;
+            pending.submitted = Clock::now();
+            m_pending.push_back(pending);
+        }
+
+        bool pending(GLuint program) const {
+            return std::any_of(m_pending.begin(), m_pending.end(), [program](const PendingProgram& p) { return p.program == program; });
+        }
+
+        // true when wait() on 'program' won't block. Without the parallel compile extension this can't be
+        // known and a pending program is reported ready, the wait then blocks.
+        bool ready(GLuint program) const {
+            for (const PendingProgram& pending : m_pending) {
+                if (pending.program == program) {
+                    return !m_parallel || complete(pending);
+                }
+            }
+            return true;
+        }
+
+        // blocks until 'program' is compiled and linked, returns the link result
+        bool wait(GLuint program) {
+            for (std::vector<PendingProgram>::iterator it = m_pending.begin(); it != m_pending.end(); ++it) {
+                if (it->program == program) {
+                    return finish(it, !complete(*it));
+                }
+            }
+            GLint success = GL_FALSE;
+            glGetProgramiv(program, GL_LINK_STATUS, &success);
+            return success == GL_TRUE;
+        }
+
+        // never blocks: finishes the programs the driver reports as done, needs parallel compile support
+        void poll() {
+            for (size_t i = 0; i < m_pending.size();) {
+                if (complete(m_pending[i])) {
+                    finish(m_pending.begin() + i, false);
+                }
+                else {
+                    ++i;
+                }
+            }
+        }
+
+        void waitAll() {
+            while (!m_pending.empty()) {
+                finish(m_pending.begin(), !complete(m_pending.front()));
+            }
+        }
+
+        bool parallel() {
+            initialize();
+            return m_parallel;
+        }
+
+        // lets the driver compile on up to 'count' threads (the default: as many as it likes) instead
+        // of its own initial choice, which may be none. 'load' resolves the entry point the way glad
+        // was loaded. Returns false without the parallel compile extension.
+        bool setCompilerThreads(GLADloadproc load, GLuint count = 0xFFFFFFFFu) {
+            initialize();
+            if (!m_parallel) {
+                return false;
+            }
+            PFNGLMAXSHADERCOMPILERTHREADSKHRPROC maxShaderCompilerThreads = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)load("glMaxShaderCompilerThreadsKHR");
+            if (!maxShaderCompilerThreads) {
+                maxShaderCompilerThreads = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)load("glMaxShaderCompilerThreadsARB");
+            }
+            if (!maxShaderCompilerThreads) {
+                return false;
+            }
+            maxShaderCompilerThreads(count);
+            return true;
+        }
+
+        // compile phase log: when each program was submitted and finished, relative to the first submit
+        void logTimings() {
+            double total = 0.0;
+            for (const Timing& timing : m_timings) {
+                total = std::max(total, timing.finishedMs);
+            }
+            std::cout << "Shader compile phase: " << m_timings.size() << " programs in " << total << " ms"
+                << (m_parallel ? " (parallel compile)" : " (no parallel compile extension)") << std::endl;
+            for (const Timing& timing : m_timings) {
+                std::cout << "  " << timing.label << ": submitted +" << timing.submittedMs << " ms, ready +" << timing.finishedMs << " ms"
+                    << (timing.blocked ? ", blocked on first use" : "") << (timing.success ? "" : ", FAILED") << std::endl;
+            }
+            if (!m_pending.empty()) {
+                std::cout << "  " << m_pending.size() << " programs still compiling" << std::endl;
+            }
+        }
+};
+
+inline ShaderCompileQueue& shaderCompileQueue() {
+    static ShaderCompileQueue queue;
+    return queue;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "../shader.h"
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+// Cache of compiled shader permutations: the same sources built with different define sets
+// (NUM_LIGHTS=N, USE_ORM...) are compiled once and shared, keyed by paths and canonical defines.
+class ShaderLibrary {
+    private:
+        std::unordered_map<std::string, std::unique_ptr<Shader>> m_programs;
+
+    public:
+        Shader& get(const std::string& vertexPath, const std::string& fragmentPath, const ShaderDefines& defines = ShaderDefines(), const std::string& geometryPath = "") {
+            std::string key = vertexPath + '|' + fragmentPath + '|' + geometryPath + '|' + defines.key();
+            std::unordered_map<std::string, std::unique_ptr<Shader>>::iterator it = m_programs.find(key);
+            if (it != m_programs.end()) {
+                return *it->second;
+            }
+            std::unique_ptr<Shader> shader(new Shader(vertexPath.c_str(), fragmentPath.c_str(), defines, geometryPath.empty() ? nullptr : geometryPath.c_str()));
+            Shader& result = *shader;
+            m_programs.emplace(key, std::move(shader));
+            return result;
+        }
+
+        size_t size() const { return m_programs.size(); }
+};
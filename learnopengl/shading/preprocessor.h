@@ -0,0 +1,154 @@
+#pragma once
+
+#include <algorithm>
+#include <fstream>
+#include <initializer_list>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// set of #define NAME VALUE lines injected right after the #version directive of every stage
+class ShaderDefines {
+    private:
+        std::vector<std::pair<std::string, std::string>> m_values;
+
+    public:
+        ShaderDefines() = default;
+        ShaderDefines(std::initializer_list<std::pair<std::string, std::string>> values) {
+            for (const std::pair<std::string, std::string>& value : values) {
+                set(value.first, value.second);
+            }
+        }
+
+        ShaderDefines& set(const std::string& name, const std::string& value = "1") {
+            for (std::pair<std::string, std::string>& existing : m_values) {
+                if (existing.first == name) {
+                    existing.second = value;
+                    return *this;
+                }
+            }
+            m_values.push_back(std::make_pair(name, value));
+            return *this;
+        }
+
+        ShaderDefines& set(const std::string& name, int value) {
+            return set(name, std::to_string(value));
+        }
+
+        bool empty() const { return m_values.empty(); }
+
+        // canonical "A=1;B=2" form, independent of the order the defines were set in
+        std::string key() const {
+            std::vector<std::pair<std::string, std::string>> sorted = m_values;
+            std::sort(sorted.begin(), sorted.end());
+            std::string result;
+            for (const std::pair<std::string, std::string>& value : sorted) {
+                result += value.first + '=' + value.second + ';';
+            }
+            return result;
+        }
+
+        std::string glsl() const {
+            std::string result;
+            for (const std::pair<std::string, std::string>& value : m_values) {
+                result += "#define " + value.first + ' ' + value.second + '\n';
+            }
+            return result;
+        }
+};
+
+// Resolves #include "file" (relative to the including file, each file included once) and injects the
+// defines. #line directives keep compiler errors pointing at the right line, the source string number
+// being the index of the file in 'files'.
+class ShaderPreprocessor {
+    private:
+        const ShaderDefines& m_defines;
+        std::vector<std::string>& m_files;
+        std::string m_output;
+
+        static std::string directoryOf(const std::string& path) {
+            size_t slash = path.find_last_of("/\\");
+            return slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+        }
+
+        static bool readFile(const std::string& path, std::string& contents) {
+            std::ifstream file(path);
+            if (!file) {
+                return false;
+            }
+            std::stringstream stream;
+            stream << file.rdbuf();
+            contents = stream.str();
+            return true;
+        }
+
+        bool process(const std::string& path, bool root) {
+            std::string contents;
+            if (!readFile(path, contents)) {
+                return false;
+            }
+            size_t fileIndex = m_files.size();
+            m_files.push_back(path);
+
+            std::istringstream lines(contents);
+            std::string line;
+            unsigned int lineNumber = 0;
+            if (!root) {
+                m_output += "#line 1 " + std::to_string(fileIndex) + '\n';
+            }
+            while (std::getline(lines, line)) {
+                ++lineNumber;
+                size_t start = line.find_first_not_of(" \t");
+                std::string directive = start == std::string::npos ? std::string() : line.substr(start);
+
+                if (directive.compare(0, 8, "#version") == 0) {
+                    if (!root) {
+                        std::cout << "WARNING::SHADER::#version in included file ignored: " << path << std::endl;
+                        m_output += '\n';
+                        continue;
+                    }
+                    m_output += line + '\n';
+                    m_output += m_defines.glsl();
+                    m_output += "#line " + std::to_string(lineNumber + 1) + ' ' + std::to_string(fileIndex) + '\n';
+                }
+                else if (directive.compare(0, 8, "#include") == 0) {
+                    size_t open = directive.find('"');
+                    size_t close = open == std::string::npos ? std::string::npos : directive.find('"', open + 1);
+                    if (close == std::string::npos) {
+                        std::cout << "ERROR::SHADER::MALFORMED_INCLUDE in " << path << ":" << lineNumber << std::endl;
+                        m_output += '\n';
+                        continue;
+                    }
+                    std::string includePath = directoryOf(path) + directive.substr(open + 1, close - open - 1);
+                    if (std::find(m_files.begin(), m_files.end(), includePath) == m_files.end()) {
+                        if (!process(includePath, false)) {
+                            std::cout << "ERROR::SHADER::INCLUDE_NOT_FOUND: " << includePath << " (from " << path << ":" << lineNumber << ")" << std::endl;
+                        }
+                    }
+                    m_output += "#line " + std::to_string(lineNumber + 1) + ' ' + std::to_string(fileIndex) + '\n';
+                }
+                else {
+                    m_output += line + '\n';
+                }
+            }
+            return true;
+        }
+
+    public:
+        ShaderPreprocessor(const ShaderDefines& defines, std::vector<std::string>& files) : m_defines{ defines }, m_files{ files } {}
+
+        bool run(const std::string& path, std::string& source) {
+            m_output.clear();
+            bool success = process(path, true);
+            source = m_output;
+            return success;
+        }
+};
+
+// preprocesses one stage, 'files' receives every file the result depends on (the stage itself first)
+inline bool preprocessShader(const std::string& path, const ShaderDefines& defines, std::string& source, std::vector<std::string>& files) {
+    ShaderPreprocessor preprocessor(defines, files);
+    return preprocessor.run(path, source);
+}
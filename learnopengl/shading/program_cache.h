@@ -0,0 +1,164 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+// On-disk cache of linked program binaries (glGetProgramBinary / glProgramBinary).
+// Entries are keyed by a hash of the final shader sources together with the driver vendor, renderer
+// and version strings, so a driver update or any edit of the GLSL (defines included) misses the cache.
+class ProgramBinaryCache {
+    private:
+        struct FileHeader {
+            uint32_t magic;
+            uint32_t format;
+            uint32_t length;
+        };
+
+        static const uint32_t MAGIC = 0x50424331; // "PBC1"
+
+        std::string m_directory;
+        std::string m_driver;
+        bool m_supported = false;
+        bool m_initialized = false;
+        unsigned int m_hits = 0;
+        unsigned int m_misses = 0;
+
+        void initialize() {
+            if (m_initialized) {
+                return;
+            }
+            m_initialized = true;
+
+            GLint formats = 0;
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+            m_supported = formats > 0;
+            if (!m_supported) {
+                return;
+            }
+
+            const GLubyte* vendor = glGetString(GL_VENDOR);
+            const GLubyte* renderer = glGetString(GL_RENDERER);
+            const GLubyte* version = glGetString(GL_VERSION);
+            m_driver = std::string(vendor ? (const char*)vendor : "") + '\n' +
+                (renderer ? (const char*)renderer : "") + '\n' +
+                (version ? (const char*)version : "");
+
+#ifdef _WIN32
+            _mkdir(m_directory.c_str());
+#else
+            mkdir(m_directory.c_str(), 0755);
+#endif
+        }
+
+        std::string pathFor(uint64_t key) const {
+            char name[32];
+            std::snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+            return m_directory + '/' + name;
+        }
+
+    public:
+        explicit ProgramBinaryCache(const std::string& directory = "shader_cache") : m_directory{ directory } {}
+
+        static uint64_t hash(const std::string& data, uint64_t seed = 14695981039346656037ull) {
+            uint64_t value = seed;
+            for (char c : data) {
+                value ^= static_cast<uint8_t>(c);
+                value *= 1099511628211ull;
+            }
+            return value;
+        }
+
+        // key for a program made of the given (fully preprocessed) stage sources
+        uint64_t key(const std::vector<std::string>& sources) {
+            initialize();
+            uint64_t value = hash(m_driver);
+            for (const std::string& source : sources) {
+                // separate the stages so moving code between them changes the key
+                value = hash(source, value ^ 0x9e3779b97f4a7c15ull);
+            }
+            return value;
+        }
+
+        bool supported() {
+            initialize();
+            return m_supported;
+        }
+
+        // loads the cached binary into 'program', returns false on a miss or when the driver rejects it
+        bool load(uint64_t key, GLuint program) {
+            if (!supported()) {
+                return false;
+            }
+
+            std::ifstream file(pathFor(key), std::ios::binary);
+            FileHeader header = {};
+            if (!file || !file.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != MAGIC) {
+                ++m_misses;
+                return false;
+            }
+            std::vector<char> binary(header.length);
+            if (!file.read(binary.data(), binary.size())) {
+                ++m_misses;
+                return false;
+            }
+
+            glProgramBinary(program, header.format, binary.data(), static_cast<GLsizei>(binary.size()));
+            GLint success = 0;
+            glGetProgramiv(program, GL_LINK_STATUS, &success);
+            if (!success) {
+                // stale or foreign binary, drop it so the next run doesn't try again
+                std::remove(pathFor(key).c_str());
+                ++m_misses;
+                return false;
+            }
+            ++m_hits;
+            return true;
+        }
+
+        // stores the binary of a successfully linked program, which should have been linked with
+        // GL_PROGRAM_BINARY_RETRIEVABLE_HINT set
+        void store(uint64_t key, GLuint program) {
+            if (!supported()) {
+                return;
+            }
+
+            GLint length = 0;
+            glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+            if (length <= 0) {
+                return;
+            }
+            std::vector<char> binary(length);
+            GLenum format = 0;
+            glGetProgramBinary(program, length, nullptr, &format, binary.data());
+
+            std::ofstream file(pathFor(key), std::ios::binary | std::ios::trunc);
+            if (!file) {
+                std::cout << "WARNING::SHADER_CACHE::CANNOT_WRITE: " << pathFor(key) << std::endl;
+                return;
+            }
+            FileHeader header = { MAGIC, format, static_cast<uint32_t>(length) };
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(binary.data(), binary.size());
+        }
+
+        unsigned int hits() const { return m_hits; }
+        unsigned int misses() const { return m_misses; }
+};
+
+// process wide cache used by Shader
+inline ProgramBinaryCache& programBinaryCache() {
+    static ProgramBinaryCache cache;
+    return cache;
+}
@@ -0,0 +1,185 @@
+#pragma once
+
+#include "../shader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#else
+#include <sys/stat.h>
+#include <sys/types.h>
+#endif
+
+// Watches the source files of registered shaders and hot reloads them: a changed file triggers
+// Shader::reload() on every program built from it (includes too), the new program compiles in the
+// background and is swapped in by update() at a frame boundary only if it links.
+// Uses inotify on Linux and polls modification times elsewhere.
+class ShaderWatcher {
+    private:
+        std::vector<Shader*> m_shaders;
+        // watched file -> programs built from it
+        std::map<std::string, std::vector<Shader*>> m_dependents;
+
+#ifdef __linux__
+        int m_inotify = -1;
+        // watch descriptor -> watched directory
+        std::map<int, std::string> m_directories;
+#else
+        typedef std::chrono::steady_clock Clock;
+        std::map<std::string, long long> m_modified;
+        Clock::time_point m_lastPoll;
+
+        static long long modificationTime(const std::string& path) {
+#ifdef _WIN32
+            struct _stat64 info;
+            return _stat64(path.c_str(), &info) == 0 ? static_cast<long long>(info.st_mtime) : -1;
+#else
+            struct stat info;
+            return stat(path.c_str(), &info) == 0 ? static_cast<long long>(info.st_mtime) : -1;
+#endif
+        }
+#endif
+
+        static std::string directoryOf(const std::string& path) {
+            size_t slash = path.find_last_of("/\\");
+            return slash == std::string::npos ? std::string(".") : path.substr(0, slash);
+        }
+
+        void addFile(const std::string& path, Shader* shader) {
+            std::vector<Shader*>& dependents = m_dependents[path];
+            if (std::find(dependents.begin(), dependents.end(), shader) == dependents.end()) {
+                dependents.push_back(shader);
+            }
+#ifdef __linux__
+            std::string directory = directoryOf(path);
+            for (const std::pair<const int, std::string>& watched : m_directories) {
+                if (watched.second == directory) {
+                    return;
+                }
+            }
+            if (m_inotify >= 0) {
+                int wd = inotify_add_watch(m_inotify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+                if (wd >= 0) {
+                    m_directories[wd] = directory;
+                }
+                else {
+                    std::cout << "WARNING::SHADER_WATCHER::CANNOT_WATCH: " << directory << std::endl;
+                }
+            }
+#else
+            if (m_modified.find(path) == m_modified.end()) {
+                m_modified[path] = modificationTime(path);
+            }
+#endif
+        }
+
+        // files changed since the last call, never blocks
+        std::vector<std::string> changedFiles() {
+            std::vector<std::string> changed;
+#ifdef __linux__
+            if (m_inotify < 0) {
+                return changed;
+            }
+            alignas(struct inotify_event) char buffer[4096];
+            for (;;) {
+                ssize_t length = read(m_inotify, buffer, sizeof(buffer));
+                if (length <= 0) {
+                    break; // EAGAIN: nothing more to read
+                }
+                for (char* ptr = buffer; ptr < buffer + length;) {
+                    const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(ptr);
+                    std::map<int, std::string>::const_iterator directory = m_directories.find(event->wd);
+                    if (event->len > 0 && directory != m_directories.end()) {
+                        std::string path = directory->second + '/' + event->name;
+                        if (std::find(changed.begin(), changed.end(), path) == changed.end()) {
+                            changed.push_back(path);
+                        }
+                    }
+                    ptr += sizeof(struct inotify_event) + event->len;
+                }
+            }
+#else
+            // stat'ing every file each frame is wasteful, a few times per second is plenty
+            Clock::time_point now = Clock::now();
+            if (now - m_lastPoll < std::chrono::milliseconds(250)) {
+                return changed;
+            }
+            m_lastPoll = now;
+            for (std::pair<const std::string, long long>& file : m_modified) {
+                long long modified = modificationTime(file.first);
+                if (modified != file.second) {
+                    file.second = modified;
+                    changed.push_back(file.first);
+                }
+            }
+#endif
+            return changed;
+        }
+
+    public:
+        ShaderWatcher() {
+#ifdef __linux__
+            m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+            if (m_inotify < 0) {
+                std::cout << "WARNING::SHADER_WATCHER::INOTIFY_UNAVAILABLE, shader hot reload disabled" << std::endl;
+            }
+#endif
+        }
+
+        ~ShaderWatcher() {
+#ifdef __linux__
+            if (m_inotify >= 0) {
+                close(m_inotify);
+            }
+#endif
+        }
+
+        ShaderWatcher(const ShaderWatcher&) = delete;
+        ShaderWatcher& operator=(const ShaderWatcher&) = delete;
+
+        // the shader must outlive the watcher
+        void watch(Shader& shader) {
+            if (std::find(m_shaders.begin(), m_shaders.end(), &shader) == m_shaders.end()) {
+                m_shaders.push_back(&shader);
+            }
+            for (const std::string& file : shader.files()) {
+                addFile(file, &shader);
+            }
+        }
+
+        // call once per frame, before any draw
+        void update() {
+            std::vector<std::string> changed = changedFiles();
+            std::vector<Shader*> outdated;
+            for (const std::string& file : changed) {
+                std::map<std::string, std::vector<Shader*>>::iterator dependents = m_dependents.find(file);
+                if (dependents == m_dependents.end()) {
+                    continue;
+                }
+                for (Shader* shader : dependents->second) {
+                    if (std::find(outdated.begin(), outdated.end(), shader) == outdated.end()) {
+                        outdated.push_back(shader);
+                    }
+                }
+            }
+            // reload() restarts a rebuild still in flight, so a file saved twice in a row only swaps once
+            for (Shader* shader : outdated) {
+                shader->reload();
+            }
+
+            for (Shader* shader : m_shaders) {
+                if (shader->reloading() && shader->applyReload()) {
+                    // includes may have changed
+                    watch(*shader);
+                }
+            }
+        }
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Lock-free single producer, single consumer handoff of the newest value. The writer fills its
+// private slot and publishes it by swapping it with the shared slot, the reader swaps the shared
+// slot into its private slot when something new was published. Neither side ever waits: a slow
+// reader only skips values, a slow writer leaves the reader on the last published one.
+template <typename T>
+class TripleBuffer {
+    private:
+        static const uint8_t INDEX_MASK = 3;
+        static const uint8_t FRESH = 4;    // shared slot was published and not yet picked up
+
+        T m_slots[3];
+        alignas(64) std::atomic<uint8_t> m_shared{ 1 };
+        alignas(64) uint8_t m_write = 0;   // writer thread only
+        alignas(64) uint8_t m_read = 2;    // reader thread only
+
+    public:
+        TripleBuffer() = default;
+        explicit TripleBuffer(const T& initial) {
+            m_slots[0] = m_slots[1] = m_slots[2] = initial;
+        }
+
+        TripleBuffer(const TripleBuffer&) = delete;
+        TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+        // writer: the slot to fill before publish(), its old contents are stale
+        T& write() { return m_slots[m_write]; }
+
+        void publish() {
+            m_write = m_shared.exchange(m_write | FRESH, std::memory_order_acq_rel) & INDEX_MASK;
+        }
+
+        // reader: picks up the newest published value, false if there was none since the last call
+        bool acquire() {
+            if (!(m_shared.load(std::memory_order_relaxed) & FRESH)) {
+                return false;
+            }
+            m_read = m_shared.exchange(m_read, std::memory_order_acq_rel) & INDEX_MASK;
+            return true;
+        }
+
+        // reader: stays valid and unchanged until the next acquire()
+        const T& read() const { return m_slots[m_read]; }
+};
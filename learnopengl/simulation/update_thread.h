@@ -0,0 +1,219 @@
+#pragma once
+
+#include "triple_buffer.h"
+#include "../camera.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+// Input gathered on the window thread (GLFW only delivers events there) for the update thread.
+// Movement keys are held states, mouse and scroll offsets add up until the next tick drains them.
+struct InputState {
+    bool forward = false;
+    bool backward = false;
+    bool left = false;
+    bool right = false;
+    float mouseX = 0.0f;
+    float mouseY = 0.0f;
+    float scroll = 0.0f;
+};
+
+class InputQueue {
+    private:
+        std::mutex m_mutex;
+        InputState m_state;
+
+    public:
+        void setMovement(bool forward, bool backward, bool left, bool right) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_state.forward = forward;
+            m_state.backward = backward;
+            m_state.left = left;
+            m_state.right = right;
+        }
+
+        void addMouse(float xoffset, float yoffset) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_state.mouseX += xoffset;
+            m_state.mouseY += yoffset;
+        }
+
+        void addScroll(float yoffset) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_state.scroll += yoffset;
+        }
+
+        // current keys and the offsets since the last drain
+        InputState drain() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            InputState state = m_state;
+            m_state.mouseX = m_state.mouseY = m_state.scroll = 0.0f;
+            return state;
+        }
+};
+
+// the parts of a Camera that change, cheap to copy and to interpolate
+struct CameraState {
+    glm::vec3 position = glm::vec3(0.0f);
+    float yaw = YAW;
+    float pitch = PITCH;
+    float zoom = ZOOM;
+
+    static CameraState of(const Camera& camera) {
+        CameraState state;
+        state.position = camera.Position;
+        state.yaw = camera.Yaw;
+        state.pitch = camera.Pitch;
+        state.zoom = camera.Zoom;
+        return state;
+    }
+
+    Camera camera() const {
+        Camera camera(position, glm::vec3(0.0f, 1.0f, 0.0f), yaw, pitch);
+        camera.Zoom = zoom;
+        return camera;
+    }
+};
+
+// Immutable result of a simulation tick. Rendering happens between the last two ticks, so frames
+// that land between ticks interpolate instead of repeating a pose, at the cost of one tick latency.
+struct FrameSnapshot {
+    CameraState previous;
+    CameraState current;
+    uint64_t tick = 0;
+    double time = 0.0;                                  // simulation time of current
+    std::chrono::steady_clock::time_point tickTime;     // wall clock time current was due
+
+    CameraState interpolate(float alpha) const {
+        CameraState state;
+        state.position = glm::mix(previous.position, current.position, alpha);
+        state.yaw = glm::mix(previous.yaw, current.yaw, alpha);
+        state.pitch = glm::mix(previous.pitch, current.pitch, alpha);
+        state.zoom = glm::mix(previous.zoom, current.zoom, alpha);
+        return state;
+    }
+};
+
+// Fixed time step simulation on its own thread. The thread owns the camera and the scene time,
+// advances them every step seconds from the queued input and publishes a FrameSnapshot through a
+// TripleBuffer, so the render thread picks up the newest state without locking while the next
+// tick is computed in parallel with its submission. Ticks are scheduled on the wall clock: a
+// stalled render thread doesn't slow the simulation down, a stalled update thread catches up at
+// most MAX_CATCH_UP ticks at once and drops the rest of the backlog.
+class UpdateThread {
+    private:
+        static const int MAX_CATCH_UP = 8;
+
+        InputQueue& m_input;
+        Camera m_camera;
+        double m_step;
+        uint64_t m_tick = 0;
+        TripleBuffer<FrameSnapshot> m_snapshots;
+        std::thread m_thread;
+        std::atomic<bool> m_running{ false };
+        std::atomic<uint64_t> m_dropped{ 0 };
+
+        void tick(const InputState& input) {
+            float step = static_cast<float>(m_step);
+            if (input.forward)
+                m_camera.ProcessKeyboard(FORWARD, step);
+            if (input.backward)
+                m_camera.ProcessKeyboard(BACKWARD, step);
+            if (input.left)
+                m_camera.ProcessKeyboard(LEFT, step);
+            if (input.right)
+                m_camera.ProcessKeyboard(RIGHT, step);
+            if (input.mouseX != 0.0f || input.mouseY != 0.0f)
+                m_camera.ProcessMouseMovement(input.mouseX, input.mouseY);
+            if (input.scroll != 0.0f)
+                m_camera.ProcessMouseScroll(input.scroll);
+            ++m_tick;
+        }
+
+        void publish(const CameraState& previous, std::chrono::steady_clock::time_point tickTime) {
+            FrameSnapshot& snapshot = m_snapshots.write();
+            snapshot.previous = previous;
+            snapshot.current = CameraState::of(m_camera);
+            snapshot.tick = m_tick;
+            snapshot.time = m_tick * m_step;
+            snapshot.tickTime = tickTime;
+            m_snapshots.publish();
+        }
+
+        void run() {
+            typedef std::chrono::steady_clock Clock;
+            const Clock::duration step = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(m_step));
+            CameraState previous = CameraState::of(m_camera);
+            Clock::time_point due = Clock::now() + step;
+            while (m_running.load(std::memory_order_relaxed)) {
+                std::this_thread::sleep_until(due);
+                Clock::time_point now = Clock::now();
+                int ticks = 0;
+                while (due <= now && ticks < MAX_CATCH_UP) {
+                    previous = CameraState::of(m_camera);
+                    // mouse movement goes in whole with the first of several catch up ticks
+                    tick(m_input.drain());
+                    due += step;
+                    ++ticks;
+                }
+                if (due <= now) {
+                    m_dropped.fetch_add(static_cast<uint64_t>((now - due) / step) + 1, std::memory_order_relaxed);
+                    due = now + step;
+                }
+                if (ticks > 0) {
+                    publish(previous, due - step);
+                }
+            }
+        }
+
+    public:
+        UpdateThread(InputQueue& input, const Camera& camera, double step = 1.0 / 120.0)
+            : m_input(input), m_camera(camera), m_step(step) {
+            FrameSnapshot initial;
+            initial.previous = initial.current = CameraState::of(camera);
+            initial.tickTime = std::chrono::steady_clock::now();
+            m_snapshots.write() = initial;
+            m_snapshots.publish();
+        }
+
+        ~UpdateThread() {
+            stop();
+        }
+
+        UpdateThread(const UpdateThread&) = delete;
+        UpdateThread& operator=(const UpdateThread&) = delete;
+
+        void start() {
+            if (!m_running.exchange(true)) {
+                m_thread = std::thread([this] { run(); });
+            }
+        }
+
+        void stop() {
+            if (m_running.exchange(false)) {
+                m_thread.join();
+            }
+        }
+
+        // render thread: the newest snapshot, valid until the next call
+        const FrameSnapshot& latest() {
+            m_snapshots.acquire();
+            return m_snapshots.read();
+        }
+
+        // render thread: how far the wall clock is past snapshot.previous, in ticks, 0 to 1
+        float interpolation(const FrameSnapshot& snapshot) const {
+            double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - snapshot.tickTime).count();
+            return static_cast<float>(std::min(std::max(elapsed / m_step, 0.0), 1.0));
+        }
+
+        double step() const { return m_step; }
+        // ticks skipped because the update thread fell too far behind
+        uint64_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+};
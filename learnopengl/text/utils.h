@@ -7,10 +7,12 @@
 
 #include <glm/glm.hpp>
 
+#include <cstring>
 #include <unordered_map>
 #include <iostream>
 
 #include "../shader.h"
+#include "../rendering/dynamic_buffer.h"
 
 struct Character {
     unsigned int id;
@@ -73,29 +75,33 @@ int loadCharacters() {
 }
 
 unsigned int textVAO;  
-unsigned int textVBO;
 
+// the quads of a string are written to the frame's dynamic buffer in one go, textVAO reads the
+// whole ring and each glyph's draw starts at its first vertex
 void renderText(Shader& shader, const std::string& text, float x, float y, float scale, glm::vec3 color) {
+    const GLsizei stride = 4 * sizeof(float);
     if (textVAO == 0) {
-        glGenVertexArrays(1, &textVAO);
-        glGenBuffers(1, &textVBO);
-        glBindVertexArray(textVAO);
-        glBindBuffer(GL_ARRAY_BUFFER, textVBO);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 4, NULL, GL_DYNAMIC_DRAW);
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glBindVertexArray(0);
+        glCreateVertexArrays(1, &textVAO);
+        glVertexArrayVertexBuffer(textVAO, 0, dynamicBuffers().buffer(), 0, stride);
+        glEnableVertexArrayAttrib(textVAO, 0);
+        glVertexArrayAttribFormat(textVAO, 0, 4, GL_FLOAT, GL_FALSE, 0);
+        glVertexArrayAttribBinding(textVAO, 0, 0);
     }
 
+    DynamicAllocation allocation = dynamicBuffers().allocate(text.size() * 6 * stride, stride);
+    if (!allocation.data) {
+        return;
+    }
+    float (*quads)[6][4] = static_cast<float (*)[6][4]>(allocation.data);
+    GLint first = static_cast<GLint>(allocation.offset / stride);
+
     shader.use();
     shader.setVec3("textColor", color);
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindVertexArray(textVAO);
+    glState().bindVertexArray(textVAO);
 
     std::string::const_iterator c;
-    for (c = text.cbegin(); c != text.cend(); ++c) {
+    for (c = text.cbegin(); c != text.cend(); ++c, ++quads, first += 6) {
         Character ch = characters[*c];
 
         float xpos = x + ch.bearing.x * scale;
@@ -104,7 +110,7 @@ void renderText(Shader& shader, const std::string& text, float x, float y, float
         float w = ch.size.x * scale;
         float h = ch.size.y * scale;
 
-        float vertices[6][4] = {
+        const float vertices[6][4] = {
             { xpos,     ypos + h,   0.0f, 0.0f },            
             { xpos,     ypos,       0.0f, 1.0f },
             { xpos + w, ypos,       1.0f, 1.0f },
@@ -114,15 +120,11 @@ void renderText(Shader& shader, const std::string& text, float x, float y, float
             { xpos + w, ypos + h,   1.0f, 0.0f }           
         };
         
-        glBindTexture(GL_TEXTURE_2D, ch.id);
-        glBindBuffer(GL_ARRAY_BUFFER, textVBO);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices); 
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glDrawArrays(GL_TRIANGLES, 0, 6);
+        std::memcpy(*quads, vertices, sizeof(vertices));
+        glState().bindTexture(0, ch.id);
+        glDrawArrays(GL_TRIANGLES, first, 6);
         
         x += (ch.advance >> 6) * scale; 
     }
 
-    glBindVertexArray(textVAO);
-    glBindTexture(GL_TEXTURE_2D, 0);
 }
\ No newline at end of file
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Bump allocator for per-frame data owned by one thread. Allocation is a pointer increment inside
+// the current block, reset() rewinds to the first block and keeps every block, so after the first
+// few frames recording allocates nothing from the heap. Blocks never move, pointers stay valid
+// until the next reset(). Not thread safe, give every recording thread its own.
+class LinearAllocator {
+    private:
+        struct Block {
+            std::unique_ptr<unsigned char[]> memory;
+            size_t size;
+        };
+
+        std::vector<Block> m_blocks;
+        size_t m_blockSize;
+        size_t m_block = 0;     // current block
+        size_t m_offset = 0;    // next free byte in the current block
+        size_t m_used = 0;
+
+    public:
+        explicit LinearAllocator(size_t blockSize = 256 * 1024) : m_blockSize{ blockSize } {}
+
+        LinearAllocator(const LinearAllocator&) = delete;
+        LinearAllocator& operator=(const LinearAllocator&) = delete;
+        LinearAllocator(LinearAllocator&&) = default;
+        LinearAllocator& operator=(LinearAllocator&&) = default;
+
+        // alignment has to be a power of two
+        void* allocate(size_t size, size_t alignment = alignof(std::max_align_t)) {
+            for (;;) {
+                if (m_block < m_blocks.size()) {
+                    Block& block = m_blocks[m_block];
+                    uintptr_t base = reinterpret_cast<uintptr_t>(block.memory.get());
+                    size_t aligned = ((base + m_offset + alignment - 1) & ~(uintptr_t(alignment) - 1)) - base;
+                    if (aligned + size <= block.size) {
+                        m_offset = aligned + size;
+                        m_used += size;
+                        return block.memory.get() + aligned;
+                    }
+                    // doesn't fit, continue in the next block
+                    if (m_block + 1 < m_blocks.size()) {
+                        ++m_block;
+                        m_offset = 0;
+                        continue;
+                    }
+                }
+                size_t blockSize = size + alignment > m_blockSize ? size + alignment : m_blockSize;
+                m_blocks.push_back({ std::unique_ptr<unsigned char[]>(new unsigned char[blockSize]), blockSize });
+                m_block = m_blocks.size() - 1;
+                m_offset = 0;
+            }
+        }
+
+        // uninitialized storage for count objects, only for trivially copyable types
+        template <typename T>
+        T* allocate(size_t count) {
+            return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+        }
+
+        void reset() {
+            m_block = 0;
+            m_offset = 0;
+            m_used = 0;
+        }
+
+        // bytes handed out since the last reset
+        size_t used() const { return m_used; }
+
+        size_t capacity() const {
+            size_t total = 0;
+            for (const Block& block : m_blocks) {
+                total += block.size;
+            }
+            return total;
+        }
+};
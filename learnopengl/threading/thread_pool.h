@@ -0,0 +1,112 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// Fixed-size pool of worker threads for CPU side work (image decoding, culling, binning...).
+// Tasks are plain callables; submit() hands back a future so callers can join on the results.
+class ThreadPool {
+    private:
+        std::vector<std::thread> m_workers;
+        std::queue<std::function<void()>> m_tasks;
+        std::mutex m_mutex;
+        std::condition_variable m_condition;
+        bool m_stop = false;
+
+        void workerLoop() {
+            for (;;) {
+                std::function<void()> task;
+                {
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    m_condition.wait(lock, [this] { return m_stop || !m_tasks.empty(); });
+                    if (m_stop && m_tasks.empty()) {
+                        return;
+                    }
+                    task = std::move(m_tasks.front());
+                    m_tasks.pop();
+                }
+                task();
+            }
+        }
+
+    public:
+        explicit ThreadPool(unsigned int threadCount = std::thread::hardware_concurrency()) {
+            if (threadCount == 0) {
+                threadCount = 1;
+            }
+            m_workers.reserve(threadCount);
+            for (unsigned int i = 0; i < threadCount; ++i) {
+                m_workers.emplace_back([this] { workerLoop(); });
+            }
+        }
+
+        ~ThreadPool() {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stop = true;
+            }
+            m_condition.notify_all();
+            for (std::thread& worker : m_workers) {
+                worker.join();
+            }
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        template <typename F>
+        auto submit(F&& func) -> std::future<decltype(func())> {
+            using Result = decltype(func());
+            auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(func));
+            std::future<Result> result = task->get_future();
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_tasks.emplace([task] { (*task)(); });
+            }
+            m_condition.notify_one();
+            return result;
+        }
+
+        // splits [0, count) into contiguous chunks and runs func(begin, end) for each of them,
+        // the calling thread takes the last chunk itself and then waits for the others
+        template <typename F>
+        void parallelFor(size_t count, size_t minChunk, F func) {
+            if (count == 0) {
+                return;
+            }
+            minChunk = std::max<size_t>(minChunk, 1);
+            size_t chunks = (count + minChunk - 1) / minChunk;
+            if (chunks > m_workers.size() + 1) {
+                chunks = m_workers.size() + 1;
+            }
+            size_t chunkSize = (count + chunks - 1) / chunks;
+
+            std::vector<std::future<void>> pending;
+            pending.reserve(chunks);
+            size_t begin = 0;
+            for (; begin + chunkSize < count; begin += chunkSize) {
+                size_t end = begin + chunkSize;
+                pending.push_back(submit([&func, begin, end] { func(begin, end); }));
+            }
+            func(begin, count);
+
+            for (std::future<void>& job : pending) {
+                job.get();
+            }
+        }
+
+        size_t size() const { return m_workers.size(); }
+};
+
+// process wide pool, created on first use
+inline ThreadPool& threadPool() {
+    static ThreadPool pool;
+    return pool;
+}
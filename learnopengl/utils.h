@@ -2,8 +2,11 @@
 #define __UTILS__
 
 #include "stb_image.h"
+#include "threading/thread_pool.h"
 
+#include <cmath>
 #include <string>
+#include <vector>
 #include <iostream>
 
 inline unsigned int textureFromFile(const char* path, const std::string& directory, bool gamma = false) {
@@ -69,4 +72,104 @@ inline unsigned int textureFromFile(const char* path, const std::string& directo
 
     return textureID;
 }
+
+struct CubemapFace {
+    unsigned char* data = nullptr;
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+};
+
+// faces are expected in the GL order: +X, -X, +Y, -Y, +Z, -Z
+// all six faces are decoded concurrently on the thread pool, so the load only waits for the slowest face
+inline unsigned int loadCubemap(const std::vector<std::string>& faces_paths) {
+    std::vector<std::future<CubemapFace>> decoding;
+    decoding.reserve(faces_paths.size());
+    for (const std::string& path : faces_paths) {
+        decoding.push_back(threadPool().submit([&path]() {
+            CubemapFace face;
+            // cubemap faces are never flipped, whatever the global stb setting is
+            stbi_set_flip_vertically_on_load_thread(false);
+            face.data = stbi_load(path.c_str(), &face.width, &face.height, &face.channels, 0);
+            return face;
+        }));
+    }
+
+    std::vector<CubemapFace> faces;
+    faces.reserve(decoding.size());
+    for (std::future<CubemapFace>& face : decoding) {
+        faces.push_back(face.get());
+    }
+
+    bool valid = faces.size() == 6;
+    if (!valid) {
+        std::cout << "ERROR: A cubemap needs 6 faces, got " << faces.size() << "\n";
+    }
+    for (size_t i = 0; valid && i < faces.size(); ++i) {
+        if (!faces[i].data) {
+            std::cout << "ERROR: Failed to load the cubemap face: " << faces_paths[i] << "\n";
+            valid = false;
+        }
+        else if (faces[i].width != faces[i].height) {
+            std::cout << "ERROR: Cubemap face is not square: " << faces_paths[i] << "\n";
+            valid = false;
+        }
+        else if (faces[i].width != faces[0].width || faces[i].channels != faces[0].channels) {
+            std::cout << "ERROR: Cubemap face size or format differs from the first face: " << faces_paths[i] << "\n";
+            valid = false;
+        }
+    }
+
+    unsigned int cubemap = 0;
+    if (valid) {
+        GLenum format;
+        GLenum internalFormat;
+        switch (faces[0].channels) {
+            case 1:
+                format = GL_RED;
+                internalFormat = GL_R8;
+                break;
+            case 2:
+                format = GL_RG;
+                internalFormat = GL_RG8;
+                break;
+            case 3:
+                format = GL_RGB;
+                internalFormat = GL_RGB8;
+                break;
+            default:
+                format = GL_RGBA;
+                internalFormat = GL_RGBA8;
+        }
+
+        int size = faces[0].width;
+        GLsizei levels = static_cast<GLsizei>(std::floor(std::log2(size))) + 1;
+
+        glGenTextures(1, &cubemap);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap);
+        glTexStorage2D(GL_TEXTURE_CUBE_MAP, levels, internalFormat, size, size);
+
+        // decoded rows are tightly packed, which breaks the default 4 byte alignment for RGB faces
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        for (size_t i = 0; i < faces.size(); ++i) {
+            glTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + static_cast<GLenum>(i), 0, 0, 0, size, size, format, GL_UNSIGNED_BYTE, faces[i].data);
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+
+        glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+    }
+
+    for (CubemapFace& face : faces) {
+        stbi_image_free(face.data);
+    }
+
+    return cubemap;
+}
 #endif
\ No newline at end of file